@@ -74,13 +74,13 @@ void AppEngine::InitDisplay()
 	 */
 	const EGLint contextAttribs[] =
 	{
-//	    EGL_CONTEXT_CLIENT_VERSION, 2,
+	    EGL_CONTEXT_CLIENT_VERSION, 2,
 	    EGL_NONE
 	};
 	const EGLint configAttribs[] =
 	{
 	    EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-//	    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+	    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
 		EGL_BLUE_SIZE, 5,
 		EGL_GREEN_SIZE, 6,
 		EGL_RED_SIZE, 5,
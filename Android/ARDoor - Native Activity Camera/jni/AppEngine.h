@@ -1,7 +1,7 @@
 #include <android_native_app_glue.h>
 
 #include <EGL/egl.h>
-#include <GLES/gl.h>
+#include <GLES2/gl2.h>
 
 typedef struct android_app AndroidApp;
 
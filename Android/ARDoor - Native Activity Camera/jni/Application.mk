@@ -1,4 +1,6 @@
 APP_STL := gnustl_static
-APP_CPPFLAGS := -frtti -fexceptions
+APP_CPPFLAGS := -frtti -fexceptions -std=gnu++11
 APP_ABI := armeabi-v7a
 APP_PLATFORM := android-10
+# the common library needs std::thread and std::atomic
+NDK_TOOLCHAIN_VERSION := 4.8
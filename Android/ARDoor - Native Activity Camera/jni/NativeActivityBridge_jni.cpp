@@ -0,0 +1,9 @@
+#include <jni.h>
+#include "PreviewBuffer.h"
+
+extern "C" {
+	JNIEXPORT void JNICALL Java_ch_bfh_cpvr_ardoor_NativeActivityBridge_nativeOnPreviewFrame(JNIEnv* env, jclass clazz, jbyteArray data, jint width, jint height)
+	{
+		PreviewBuffer::GetInstance().Write(env, data, width, height);
+	}
+}
@@ -0,0 +1,78 @@
+#include "PreviewBuffer.h"
+#include "Logging.h"
+
+#include <errno.h>
+#include <sys/time.h>
+
+PreviewBuffer::PreviewBuffer()
+{
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&frameAvailable, NULL);
+
+	width = 0;
+	height = 0;
+	hasFrame = false;
+}
+
+PreviewBuffer::~PreviewBuffer()
+{
+	pthread_cond_destroy(&frameAvailable);
+	pthread_mutex_destroy(&mutex);
+}
+
+PreviewBuffer& PreviewBuffer::GetInstance()
+{
+	static PreviewBuffer instance;
+	return instance;
+}
+
+void PreviewBuffer::Write(JNIEnv* env, jbyteArray data, int width, int height)
+{
+	int size = width * height * 3 / 2;
+	if (env->GetArrayLength(data) < size) {
+		LOGE("preview buffer too small for %dx%d", width, height);
+		return;
+	}
+
+	pthread_mutex_lock(&mutex);
+
+	// reallocates only if the reader took the buffer or the preview size changed
+	back.create(height * 3 / 2, width, CV_8UC1);
+	env->GetByteArrayRegion(data, 0, size, (jbyte*) back.data);
+
+	this->width = width;
+	this->height = height;
+	hasFrame = true;
+
+	pthread_cond_signal(&frameAvailable);
+	pthread_mutex_unlock(&mutex);
+}
+
+bool PreviewBuffer::Read(cv::Mat& frame, int timeoutMs)
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+
+	long nsec = now.tv_usec * 1000L + (timeoutMs % 1000) * 1000000L;
+	struct timespec deadline;
+	deadline.tv_sec = now.tv_sec + timeoutMs / 1000 + nsec / 1000000000L;
+	deadline.tv_nsec = nsec % 1000000000L;
+
+	pthread_mutex_lock(&mutex);
+
+	int result = 0;
+	while (!hasFrame && result != ETIMEDOUT) {
+		result = pthread_cond_timedwait(&frameAvailable, &mutex, &deadline);
+	}
+
+	bool success = hasFrame;
+	if (hasFrame) {
+		// the buffers change owners, no pixels are copied
+		cv::swap(frame, back);
+		hasFrame = false;
+	}
+
+	pthread_mutex_unlock(&mutex);
+
+	return success;
+}
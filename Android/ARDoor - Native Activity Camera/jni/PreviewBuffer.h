@@ -0,0 +1,40 @@
+#include <jni.h>
+#include <pthread.h>
+#include <opencv2/core/core.hpp>
+
+/**
+ * Hands the NV21 preview frames from the camera callback in the Java thread
+ * over to the native activity thread. The frames are kept in two buffers,
+ * a newer frame replaces one that has not been read yet.
+ */
+class PreviewBuffer
+{
+private:
+	pthread_mutex_t mutex;
+	pthread_cond_t frameAvailable;
+
+	// the camera writes into back while front belongs to the reader
+	cv::Mat back;
+	int width;
+	int height;
+	bool hasFrame;
+
+	PreviewBuffer();
+
+public:
+	~PreviewBuffer();
+
+	static PreviewBuffer& GetInstance();
+
+	/**
+	 * Copies the frame out of the Java array, called from the preview callback
+	 */
+	void Write(JNIEnv* env, jbyteArray data, int width, int height);
+
+	/**
+	 * Waits up to timeoutMs for a frame newer than the last one read
+	 * @param frame CV_8UC1 of height * 3 / 2 rows, the Y plane followed by interleaved V and U
+	 * @return false if there was no new frame
+	 */
+	bool Read(cv::Mat& frame, int timeoutMs);
+};
@@ -0,0 +1,191 @@
+#include "YuvRenderer.h"
+#include "Logging.h"
+
+static const char* vertexShaderSource =
+	"attribute vec2 a_position;\n"
+	"attribute vec2 a_texCoord;\n"
+	"varying vec2 v_texCoord;\n"
+	"void main() {\n"
+	"    v_texCoord = a_texCoord;\n"
+	"    gl_Position = vec4(a_position, 0.0, 1.0);\n"
+	"}\n";
+
+// BT.601 video range, the VU texture holds V in luminance and U in alpha
+static const char* fragmentShaderSource =
+	"precision mediump float;\n"
+	"varying vec2 v_texCoord;\n"
+	"uniform sampler2D u_textureY;\n"
+	"uniform sampler2D u_textureVU;\n"
+	"void main() {\n"
+	"    float y = 1.164 * (texture2D(u_textureY, v_texCoord).r - 0.0625);\n"
+	"    vec4 vu = texture2D(u_textureVU, v_texCoord);\n"
+	"    float v = vu.r - 0.5;\n"
+	"    float u = vu.a - 0.5;\n"
+	"    gl_FragColor = vec4(y + 1.596 * v, y - 0.813 * v - 0.391 * u, y + 2.018 * u, 1.0);\n"
+	"}\n";
+
+// the camera delivers landscape frames, the texture coordinates turn them to portrait
+static const GLfloat positions[] = {
+	-1.0f,  1.0f, // top left
+	 1.0f,  1.0f, // top right
+	-1.0f, -1.0f, // bottom left
+	 1.0f, -1.0f  // bottom right
+};
+static const GLfloat texCoords[] = {
+	0.0f, 1.0f,
+	0.0f, 0.0f,
+	1.0f, 1.0f,
+	1.0f, 0.0f
+};
+
+YuvRenderer::YuvRenderer()
+{
+	program = 0;
+	textures[0] = 0;
+	textures[1] = 0;
+	positionLocation = -1;
+	texCoordLocation = -1;
+	textureWidth = 0;
+	textureHeight = 0;
+}
+
+GLuint YuvRenderer::CompileShader(GLenum type, const char* source)
+{
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	GLint compiled = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (!compiled) {
+		char log[512];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		LOGE("compiling shader failed: %s", log);
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+bool YuvRenderer::Initialize()
+{
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+	if (!vertexShader || !fragmentShader) {
+		return false;
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+
+	// the program keeps the shaders alive as long as it needs them
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		char log[512];
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		LOGE("linking program failed: %s", log);
+		Release();
+		return false;
+	}
+
+	positionLocation = glGetAttribLocation(program, "a_position");
+	texCoordLocation = glGetAttribLocation(program, "a_texCoord");
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "u_textureY"), 0);
+	glUniform1i(glGetUniformLocation(program, "u_textureVU"), 1);
+
+	glGenTextures(2, textures);
+	for (int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// the textures are allocated with the first frame
+	textureWidth = 0;
+	textureHeight = 0;
+
+	return true;
+}
+
+void YuvRenderer::Release()
+{
+	if (textures[0]) {
+		glDeleteTextures(2, textures);
+		textures[0] = 0;
+		textures[1] = 0;
+	}
+
+	if (program) {
+		glDeleteProgram(program);
+		program = 0;
+	}
+}
+
+void YuvRenderer::AllocateTextures(int width, int height)
+{
+	glBindTexture(GL_TEXTURE_2D, textures[0]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, NULL);
+
+	glBindTexture(GL_TEXTURE_2D, textures[1]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, width / 2, height / 2, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, NULL);
+
+	textureWidth = width;
+	textureHeight = height;
+}
+
+void YuvRenderer::Upload(const cv::Mat& nv21)
+{
+	int width = nv21.cols;
+	int height = nv21.rows * 2 / 3;
+
+	if (width != textureWidth || height != textureHeight) {
+		AllocateTextures(width, height);
+	}
+
+	// the rows of odd sized frames are not aligned to four bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	glBindTexture(GL_TEXTURE_2D, textures[0]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE, nv21.ptr(0));
+
+	glBindTexture(GL_TEXTURE_2D, textures[1]);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width / 2, height / 2, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, nv21.ptr(height));
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void YuvRenderer::Draw()
+{
+	if (!textureWidth) {
+		return;
+	}
+
+	glUseProgram(program);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, textures[0]);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, textures[1]);
+	glActiveTexture(GL_TEXTURE0);
+
+	glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE, 0, positions);
+	glEnableVertexAttribArray(positionLocation);
+	glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+	glEnableVertexAttribArray(texCoordLocation);
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+	glDisableVertexAttribArray(positionLocation);
+	glDisableVertexAttribArray(texCoordLocation);
+}
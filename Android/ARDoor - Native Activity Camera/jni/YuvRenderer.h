@@ -0,0 +1,43 @@
+#include <GLES2/gl2.h>
+#include <opencv2/core/core.hpp>
+
+/**
+ * Draws NV21 camera frames in their native resolution. The Y plane and the
+ * interleaved VU plane go into two textures and are converted to RGB by the
+ * fragment shader, so the CPU neither converts nor resizes the frame.
+ *
+ * The textures are not power of two, they are clamped to the edge and have
+ * no mip maps, which is what GLES2 supports for them.
+ */
+class YuvRenderer
+{
+private:
+	GLuint program;
+	GLuint textures[2];
+	GLint positionLocation;
+	GLint texCoordLocation;
+	int textureWidth;
+	int textureHeight;
+
+	GLuint CompileShader(GLenum type, const char* source);
+	void AllocateTextures(int width, int height);
+
+public:
+	YuvRenderer();
+
+	/**
+	 * Compiles the shader, the GL context has to be current
+	 */
+	bool Initialize();
+	void Release();
+
+	/**
+	 * @param nv21 CV_8UC1 of height * 3 / 2 rows, the Y plane followed by interleaved V and U
+	 */
+	void Upload(const cv::Mat& nv21);
+
+	/**
+	 * Draws the last uploaded frame over the whole viewport, rotated to portrait
+	 */
+	void Draw();
+};
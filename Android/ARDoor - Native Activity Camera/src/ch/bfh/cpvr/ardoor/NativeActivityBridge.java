@@ -1,22 +1,127 @@
 package ch.bfh.cpvr.ardoor;
 
+import java.io.IOException;
+import java.util.List;
+
 import android.app.NativeActivity;
+import android.graphics.ImageFormat;
+import android.graphics.SurfaceTexture;
+import android.hardware.Camera;
 import android.util.Log;
 import android.view.Menu;
 
-public class NativeActivityBridge extends NativeActivity {
+public class NativeActivityBridge extends NativeActivity implements Camera.PreviewCallback {
 
 	static {
 		System.loadLibrary("opencv_java");
+		// the preview callback is implemented in the library of the native activity
+		System.loadLibrary("CameraTest");
 	}
-	
+
     private static final String TAG = "ARDoor::NativeActivityBridge";
 
-	
+    private static final int PREVIEW_WIDTH = 640;
+    private static final int PREVIEW_HEIGHT = 480;
+    // one buffer is filled by the camera while the other one is handed to the native code
+    private static final int BUFFER_COUNT = 2;
+
+    private Camera camera;
+    // the preview has to go somewhere, the frames are only taken from the callback
+    private SurfaceTexture previewTexture;
+    private int previewWidth;
+    private int previewHeight;
+
+    private static native void nativeOnPreviewFrame(byte[] data, int width, int height);
+
     @Override
     public boolean onCreateOptionsMenu(Menu menu) {
         Log.i(TAG, "called onCreateOptionsMenu");
         menu.add("Test Menu in Native Activity");
         return true;
     }
+
+    @Override
+    protected void onResume() {
+        super.onResume();
+        startCamera();
+    }
+
+    @Override
+    protected void onPause() {
+        stopCamera();
+        super.onPause();
+    }
+
+    @Override
+    public void onPreviewFrame(byte[] data, Camera camera) {
+        // the native code copies the frame, so the buffer can be reused right away
+        nativeOnPreviewFrame(data, previewWidth, previewHeight);
+        camera.addCallbackBuffer(data);
+    }
+
+    private void startCamera() {
+        try {
+            camera = Camera.open();
+        } catch (RuntimeException e) {
+            Log.e(TAG, "camera not available", e);
+            return;
+        }
+
+        Camera.Parameters parameters = camera.getParameters();
+        Camera.Size size = choosePreviewSize(parameters.getSupportedPreviewSizes());
+        previewWidth = size.width;
+        previewHeight = size.height;
+
+        parameters.setPreviewSize(previewWidth, previewHeight);
+        parameters.setPreviewFormat(ImageFormat.NV21);
+        camera.setParameters(parameters);
+
+        int bufferSize = previewWidth * previewHeight * ImageFormat.getBitsPerPixel(ImageFormat.NV21) / 8;
+        for (int i = 0; i < BUFFER_COUNT; i++) {
+            camera.addCallbackBuffer(new byte[bufferSize]);
+        }
+        camera.setPreviewCallbackWithBuffer(this);
+
+        try {
+            previewTexture = new SurfaceTexture(0);
+            camera.setPreviewTexture(previewTexture);
+        } catch (IOException e) {
+            Log.e(TAG, "setting the preview texture failed", e);
+        }
+
+        camera.startPreview();
+        Log.i(TAG, "preview started with " + previewWidth + "x" + previewHeight);
+    }
+
+    private void stopCamera() {
+        if (camera == null) {
+            return;
+        }
+
+        camera.stopPreview();
+        camera.setPreviewCallbackWithBuffer(null);
+        camera.release();
+        camera = null;
+
+        previewTexture.release();
+        previewTexture = null;
+    }
+
+    /**
+     * The supported size closest to the preferred one, the native code processes every pixel
+     */
+    private Camera.Size choosePreviewSize(List<Camera.Size> sizes) {
+        Camera.Size best = sizes.get(0);
+        int bestDistance = Integer.MAX_VALUE;
+
+        for (Camera.Size size : sizes) {
+            int distance = Math.abs(size.width - PREVIEW_WIDTH) + Math.abs(size.height - PREVIEW_HEIGHT);
+            if (distance < bestDistance) {
+                best = size;
+                bestDistance = distance;
+            }
+        }
+
+        return best;
+    }
 }
@@ -0,0 +1,42 @@
+#-------------------------------------------------
+#
+# Headless benchmark replaying recorded or generated
+# frames through the ARDoor image pipeline
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = Benchmark
+TEMPLATE = app
+
+include(../_globals.pro)
+
+
+SOURCES += \
+    main.cpp \
+    FrameSource.cpp \
+    BenchmarkProcessors.cpp \
+    KernelBenchmark.cpp
+
+HEADERS += \
+    FrameSource.h \
+    BenchmarkProcessors.h \
+    KernelBenchmark.h
+
+unix:!macx {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv
+}
+
+macx {
+    QMAKE_LFLAGS += -F/Library/Frameworks
+    LIBS += -framework opencv2
+}
+
+# ARDoorCommon Library
+INCLUDEPATH += ../Libraries/ARDoorCommon
+LIBS += -L$$BUILDPATH/ARDoorCommon -lARDoorCommon
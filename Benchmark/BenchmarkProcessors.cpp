@@ -0,0 +1,124 @@
+#include "BenchmarkProcessors.h"
+#include "ImageUtils.h"
+#include <opencv2/features2d/features2d.hpp>
+
+std::string GrayProcessor::getName()
+{
+    return "gray";
+}
+
+void GrayProcessor::processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame)
+{
+    ARDoor::ImageUtils::convertToGray(inputFrame, outputFrame);
+}
+
+UndistortProcessor::UndistortProcessor(ARDoor::CameraCalibration *calibration)
+{
+    this->calibration = calibration;
+}
+
+std::string UndistortProcessor::getName()
+{
+    return "undistort";
+}
+
+void UndistortProcessor::processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame)
+{
+    calibration->remap(inputFrame, outputFrame);
+}
+
+ChessboardProcessor::ChessboardProcessor(ARDoor::CameraCalibration *calibration, cv::Size boardSize)
+{
+    this->calibration = calibration;
+    this->boardSize = boardSize;
+    detections = 0;
+}
+
+std::string ChessboardProcessor::getName()
+{
+    return "chessboard";
+}
+
+void ChessboardProcessor::processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame)
+{
+    std::vector<cv::Point2f> imageCorners;
+    std::vector<cv::Point3f> objectCorners;
+
+    ARDoor::ImageUtils::convertToGray(inputFrame, gray);
+    if (calibration->findChessboardPoints(gray, boardSize, imageCorners, objectCorners)) {
+        detections++;
+    }
+
+    outputFrame = inputFrame;
+}
+
+int ChessboardProcessor::getDetections()
+{
+    return detections;
+}
+
+FeatureProcessor::FeatureProcessor()
+{
+    extractor = new ARDoor::PatternExtractor(new cv::ORB(1000), new cv::FREAK(false, false));
+    keypoints = 0;
+    frames = 0;
+}
+
+FeatureProcessor::~FeatureProcessor()
+{
+    delete extractor;
+}
+
+std::string FeatureProcessor::getName()
+{
+    return "features";
+}
+
+void FeatureProcessor::processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame)
+{
+    ARDoor::ImageUtils::convertToGray(inputFrame, gray);
+    extractor->extract(gray, pattern);
+
+    keypoints += pattern.keypoints.size();
+    frames++;
+
+    outputFrame = inputFrame;
+}
+
+double FeatureProcessor::getAverageKeypoints()
+{
+    return frames == 0 ? 0 : (double) keypoints / frames;
+}
+
+PatternProcessor::PatternProcessor()
+{
+    detections = 0;
+}
+
+void PatternProcessor::train(const cv::Mat &patternImage)
+{
+    ARDoor::PatternExtractor extractor(new cv::ORB(1000), new cv::FREAK(false, false));
+    ARDoor::Pattern pattern;
+
+    extractor.extract(patternImage, pattern);
+    detector.train(pattern);
+}
+
+std::string PatternProcessor::getName()
+{
+    return "pattern";
+}
+
+void PatternProcessor::processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame)
+{
+    if (detector.findPattern(inputFrame, info)) {
+        detections++;
+    }
+
+    outputFrame = inputFrame;
+}
+
+int PatternProcessor::getDetections()
+{
+    return detections;
+}
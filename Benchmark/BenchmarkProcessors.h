@@ -0,0 +1,101 @@
+#ifndef BENCHMARKPROCESSORS_H
+#define BENCHMARKPROCESSORS_H
+
+#include "ImageProcessor.h"
+#include "CameraCalibration.h"
+#include "PatternExtractor.h"
+#include "PatternDetector.h"
+#include "Pattern.h"
+
+/**
+ * Converts the frame to gray scale.
+ */
+class GrayProcessor : public ARDoor::ImageProcessor
+{
+public:
+    std::string getName();
+    void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
+};
+
+/**
+ * Removes the lens distortion using the given calibration.
+ */
+class UndistortProcessor : public ARDoor::ImageProcessor
+{
+public:
+    UndistortProcessor(ARDoor::CameraCalibration* calibration);
+
+    std::string getName();
+    void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
+
+private:
+    ARDoor::CameraCalibration* calibration;
+};
+
+/**
+ * Searches the calibration chessboard, the frame is passed on unchanged.
+ */
+class ChessboardProcessor : public ARDoor::ImageProcessor
+{
+public:
+    ChessboardProcessor(ARDoor::CameraCalibration* calibration, cv::Size boardSize = cv::Size(9, 6));
+
+    std::string getName();
+    void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
+    bool isInPlace() { return true; }
+
+    int getDetections();
+
+private:
+    ARDoor::CameraCalibration* calibration;
+    cv::Size boardSize;
+    cv::Mat gray;
+    int detections;
+};
+
+/**
+ * Extracts ORB keypoints and FREAK descriptors, the frame is passed on unchanged.
+ */
+class FeatureProcessor : public ARDoor::ImageProcessor
+{
+public:
+    FeatureProcessor();
+    ~FeatureProcessor();
+
+    std::string getName();
+    void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
+    bool isInPlace() { return true; }
+
+    double getAverageKeypoints();
+
+private:
+    ARDoor::PatternExtractor* extractor;
+    ARDoor::Pattern pattern;
+    cv::Mat gray;
+    long keypoints;
+    long frames;
+};
+
+/**
+ * Searches a trained pattern by feature matching, the frame is passed on unchanged.
+ */
+class PatternProcessor : public ARDoor::ImageProcessor
+{
+public:
+    PatternProcessor();
+
+    void train(const cv::Mat& patternImage);
+
+    std::string getName();
+    void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
+    bool isInPlace() { return true; }
+
+    int getDetections();
+
+private:
+    ARDoor::PatternDetector detector;
+    ARDoor::PatternTrackingInfo info;
+    int detections;
+};
+
+#endif // BENCHMARKPROCESSORS_H
@@ -0,0 +1,143 @@
+#include "FrameSource.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+// fixed seeds keep the generated fixtures identical between runs
+static const uint64 PATTERN_SEED = 0xA4D0012;
+static const uint64 BACKGROUND_SEED = 0xA4D0013;
+
+/**
+ * Computes where the corners of a target end up in the given frame. The
+ * target follows a smooth path of translations, rotations and tilts which
+ * only depends on the frame index.
+ */
+static cv::Mat targetHomography(cv::Size frameSize, cv::Size targetSize, int frame, int frameCount)
+{
+    double t = 2.0 * CV_PI * frame / std::max(frameCount, 1);
+
+    double fit = std::min(frameSize.width / (double) targetSize.width, frameSize.height / (double) targetSize.height);
+    double scale = 0.5 * fit * (1.0 + 0.2 * std::sin(t));
+    double angle = 0.35 * std::sin(0.5 * t);
+    double tiltX = 0.15 * std::sin(t);
+    double tiltY = 0.15 * std::cos(1.3 * t);
+    cv::Point2d center(frameSize.width * (0.5 + 0.08 * std::cos(t)), frameSize.height * (0.5 + 0.08 * std::sin(2.0 * t)));
+
+    cv::Point2f source[4] = {
+        cv::Point2f(0, 0),
+        cv::Point2f(targetSize.width, 0),
+        cv::Point2f(targetSize.width, targetSize.height),
+        cv::Point2f(0, targetSize.height)
+    };
+    cv::Point2f destination[4];
+
+    for (int i = 0; i < 4; i++) {
+        // corner relative to the target center, normalized to [-1, 1]
+        double nx = source[i].x / targetSize.width * 2.0 - 1.0;
+        double ny = source[i].y / targetSize.height * 2.0 - 1.0;
+
+        double x = nx * targetSize.width * 0.5 * (1.0 + tiltY * ny) * scale;
+        double y = ny * targetSize.height * 0.5 * (1.0 + tiltX * nx) * scale;
+
+        destination[i].x = center.x + x * std::cos(angle) - y * std::sin(angle);
+        destination[i].y = center.y + x * std::sin(angle) + y * std::cos(angle);
+    }
+
+    return cv::getPerspectiveTransform(source, destination);
+}
+
+VideoFrameSource::VideoFrameSource(const std::string &path) : capture(path)
+{
+}
+
+bool VideoFrameSource::isOpened() const
+{
+    return capture.isOpened();
+}
+
+bool VideoFrameSource::nextFrame(cv::Mat &frame)
+{
+    return capture.read(frame) && !frame.empty();
+}
+
+ChessboardFixture::ChessboardFixture(cv::Size frameSize, int frameCount, cv::Size boardSize)
+    : frameSize(frameSize), frameCount(frameCount), currentFrame(0)
+{
+    // boardSize counts the inner corners, the board has one more square in each direction
+    const int squareSize = 40;
+    const int squaresX = boardSize.width + 1;
+    const int squaresY = boardSize.height + 1;
+
+    // one square of white margin around the board
+    board = cv::Mat((squaresY + 2) * squareSize, (squaresX + 2) * squareSize, CV_8UC3, cv::Scalar::all(255));
+
+    for (int row = 0; row < squaresY; row++) {
+        for (int col = 0; col < squaresX; col++) {
+            if ((row + col) % 2 == 0) {
+                cv::Rect square((col + 1) * squareSize, (row + 1) * squareSize, squareSize, squareSize);
+                board(square).setTo(cv::Scalar::all(0));
+            }
+        }
+    }
+}
+
+bool ChessboardFixture::nextFrame(cv::Mat &frame)
+{
+    if (currentFrame >= frameCount) {
+        return false;
+    }
+
+    cv::Mat homography = targetHomography(frameSize, board.size(), currentFrame, frameCount);
+    cv::warpPerspective(board, frame, homography, frameSize, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar::all(96));
+
+    currentFrame++;
+
+    return true;
+}
+
+PatternFixture::PatternFixture(cv::Size frameSize, int frameCount)
+    : frameSize(frameSize), frameCount(frameCount), currentFrame(0)
+{
+    cv::RNG rng(PATTERN_SEED);
+
+    pattern = cv::Mat(360, 480, CV_8UC3, cv::Scalar::all(128));
+
+    for (int i = 0; i < 400; i++) {
+        cv::Point center(rng.uniform(0, pattern.cols), rng.uniform(0, pattern.rows));
+        cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        int size = rng.uniform(3, 30);
+
+        if (i % 2 == 0) {
+            cv::circle(pattern, center, size, color, -1);
+        } else {
+            cv::rectangle(pattern, center, center + cv::Point(size, rng.uniform(3, 30)), color, -1);
+        }
+    }
+
+    cv::GaussianBlur(pattern, pattern, cv::Size(3, 3), 0);
+
+    cv::RNG backgroundRng(BACKGROUND_SEED);
+    background = cv::Mat(frameSize, CV_8UC3);
+    backgroundRng.fill(background, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::GaussianBlur(background, background, cv::Size(9, 9), 0);
+}
+
+bool PatternFixture::nextFrame(cv::Mat &frame)
+{
+    if (currentFrame >= frameCount) {
+        return false;
+    }
+
+    cv::Mat homography = targetHomography(frameSize, pattern.size(), currentFrame, frameCount);
+    background.copyTo(frame);
+    cv::warpPerspective(pattern, frame, homography, frameSize, cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+
+    currentFrame++;
+
+    return true;
+}
+
+const cv::Mat& PatternFixture::getPatternImage() const
+{
+    return pattern;
+}
@@ -0,0 +1,80 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <string>
+
+/**
+ * Delivers the frames replayed by the benchmark.
+ */
+class FrameSource
+{
+public:
+    virtual ~FrameSource() {}
+
+    /**
+     * @return false once the source is exhausted
+     */
+    virtual bool nextFrame(cv::Mat& frame) = 0;
+};
+
+/**
+ * Reads a video file or an image sequence given as printf pattern,
+ * e.g. frames/%04d.png
+ */
+class VideoFrameSource : public FrameSource
+{
+public:
+    VideoFrameSource(const std::string& path);
+
+    bool isOpened() const;
+    bool nextFrame(cv::Mat& frame);
+
+private:
+    cv::VideoCapture capture;
+};
+
+/**
+ * Chessboard seen from a deterministic sequence of poses, matching the
+ * board size used for calibration.
+ */
+class ChessboardFixture : public FrameSource
+{
+public:
+    ChessboardFixture(cv::Size frameSize, int frameCount, cv::Size boardSize = cv::Size(9, 6));
+
+    bool nextFrame(cv::Mat& frame);
+
+private:
+    cv::Size frameSize;
+    int frameCount;
+    int currentFrame;
+    cv::Mat board;
+};
+
+/**
+ * Textured planar target on a noisy background, generated from a fixed
+ * seed so every run sees the same pixels.
+ */
+class PatternFixture : public FrameSource
+{
+public:
+    PatternFixture(cv::Size frameSize, int frameCount);
+
+    bool nextFrame(cv::Mat& frame);
+
+    /**
+     * @return the undistorted target as expected by PatternExtractor
+     */
+    const cv::Mat& getPatternImage() const;
+
+private:
+    cv::Size frameSize;
+    int frameCount;
+    int currentFrame;
+    cv::Mat pattern;
+    cv::Mat background;
+};
+
+#endif // FRAMESOURCE_H
@@ -0,0 +1,72 @@
+#include "KernelBenchmark.h"
+#include "ImageUtils.h"
+#include <opencv2/imgproc/imgproc.hpp>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsPerRun(int iterations, const std::function<void()>& run)
+{
+    // the first run allocates the output buffers
+    run();
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        run();
+    }
+
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+}
+
+static void printComparison(const std::string& name, double opencv, double kernel)
+{
+    std::cout << std::left << std::setw(20) << name
+        << std::right << std::fixed << std::setprecision(3)
+        << std::setw(12) << opencv
+        << std::setw(12) << kernel
+        << std::setw(10) << std::setprecision(2) << opencv / kernel << "x" << std::endl;
+}
+
+void benchmarkKernels(cv::Size frameSize, int iterations)
+{
+    cv::RNG rng(0xA4D0014);
+
+    cv::Mat bgra(frameSize, CV_8UC4);
+    rng.fill(bgra, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    cv::Mat nv21(frameSize.height * 3 / 2, frameSize.width, CV_8UC1);
+    rng.fill(nv21, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    cv::Mat rgb, gray;
+
+    std::cout << std::endl
+        << "colour conversion at " << frameSize.width << "x" << frameSize.height << ", " << iterations << " runs" << std::endl
+        << std::left << std::setw(20) << "conversion"
+        << std::right << std::setw(12) << "cvtColor ms"
+        << std::setw(12) << "kernel ms"
+        << std::setw(11) << "speedup" << std::endl;
+
+    printComparison("bgra -> gray",
+        millisecondsPerRun(iterations, [&]() { cv::cvtColor(bgra, gray, CV_BGRA2GRAY); }),
+        millisecondsPerRun(iterations, [&]() { ARDoor::ImageUtils::bgraToGray(bgra, gray); }));
+
+    printComparison("bgra -> rgb + gray",
+        millisecondsPerRun(iterations, [&]() {
+            cv::cvtColor(bgra, rgb, CV_BGRA2RGB);
+            cv::cvtColor(rgb, gray, CV_RGB2GRAY);
+        }),
+        millisecondsPerRun(iterations, [&]() { ARDoor::ImageUtils::bgraToRgb(bgra, rgb, gray); }));
+
+    printComparison("nv21 -> gray",
+        millisecondsPerRun(iterations, [&]() { cv::cvtColor(nv21, gray, CV_YUV2GRAY_NV21); }),
+        millisecondsPerRun(iterations, [&]() { ARDoor::ImageUtils::nv21ToGray(nv21, gray); }));
+
+    printComparison("nv21 -> rgb",
+        millisecondsPerRun(iterations, [&]() { cv::cvtColor(nv21, rgb, CV_YUV2RGB_NV21); }),
+        millisecondsPerRun(iterations, [&]() { ARDoor::ImageUtils::nv21ToRgb(nv21, rgb); }));
+
+    std::cout.unsetf(std::ios_base::floatfield);
+}
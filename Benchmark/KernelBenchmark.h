@@ -0,0 +1,12 @@
+#ifndef KERNELBENCHMARK_H
+#define KERNELBENCHMARK_H
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * Times the colour conversion kernels of ImageUtils against the cvtColor
+ * calls they replace and prints the time per frame.
+ */
+void benchmarkKernels(cv::Size frameSize, int iterations);
+
+#endif // KERNELBENCHMARK_H
@@ -0,0 +1,236 @@
+#include "FrameSource.h"
+#include "BenchmarkProcessors.h"
+#include "KernelBenchmark.h"
+#include "ImagePipeline.h"
+#include "TestImageProcessor.h"
+#include "CameraCalibration.h"
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #define makeDirectory(path) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #define makeDirectory(path) mkdir(path, 0755)
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void printUsage(const char* program)
+{
+    std::cout
+        << "Usage: " << program << " [options]" << std::endl
+        << "  --video <path>      replay a video file or an image sequence (e.g. frames/%04d.png)" << std::endl
+        << "  --fixture <name>    replay generated frames: chessboard (default) or pattern" << std::endl
+        << "  --frames <n>        number of generated frames (default 300)" << std::endl
+        << "  --size <w>x<h>      size of the generated frames (default 1280x720)" << std::endl
+        << "  --stages <a,b,...>  pipeline configuration (default gray,chessboard)" << std::endl
+        << "                      available: test, gray, undistort, chessboard, features, pattern" << std::endl
+        << "                      pattern only finds the target of the pattern fixture" << std::endl
+        << "  --calibrate <n>     also calibrate from n generated chessboard images" << std::endl
+        << "  --workdir <dir>     directory for the calibration images (default ardoor-benchmark)" << std::endl
+        << "  --kernels <n>       also time the colour conversion kernels over n runs" << std::endl;
+}
+
+static ARDoor::ImagePipeline::Configuration parseStages(const std::string& stages)
+{
+    ARDoor::ImagePipeline::Configuration configuration;
+    std::stringstream stream(stages);
+    std::string stage;
+
+    while (std::getline(stream, stage, ',')) {
+        if (!stage.empty()) {
+            configuration.push_back(stage);
+        }
+    }
+
+    return configuration;
+}
+
+/**
+ * Plausible intrinsics for the generated frames, so that undistortion has some work to do.
+ */
+static void setupCalibration(ARDoor::CameraCalibration& calibration, cv::Size frameSize)
+{
+    cv::Mat intrinsics = cv::Mat::eye(3, 3, CV_32F);
+    intrinsics.at<float>(0, 0) = frameSize.width;
+    intrinsics.at<float>(1, 1) = frameSize.width;
+    intrinsics.at<float>(0, 2) = frameSize.width / 2.0f;
+    intrinsics.at<float>(1, 2) = frameSize.height / 2.0f;
+
+    cv::Mat distortion = cv::Mat::zeros(1, 5, CV_32F);
+    distortion.at<float>(0, 0) = -0.1f;
+    distortion.at<float>(0, 1) = 0.01f;
+
+    calibration.setIntrinsicsMatrix(intrinsics);
+    calibration.setDistortionCoeffs(distortion);
+}
+
+static void benchmarkCalibration(int imageCount, cv::Size frameSize, const std::string& directory)
+{
+    makeDirectory(directory.c_str());
+
+    std::vector<std::string> files;
+    ChessboardFixture fixture(frameSize, imageCount);
+    cv::Mat frame;
+
+    while (fixture.nextFrame(frame)) {
+        char name[32];
+        sprintf(name, "/chessboard_%04d.png", (int) files.size());
+
+        std::string file = directory + name;
+        if (!cv::imwrite(file, frame)) {
+            std::cerr << "Could not write " << file << std::endl;
+            return;
+        }
+        files.push_back(file);
+    }
+
+    ARDoor::CameraCalibration calibration;
+    cv::Size boardSize(9, 6);
+
+    Clock::time_point start = Clock::now();
+    int detected = calibration.addChessboardPoints(files, boardSize);
+    double detectionTime = secondsSince(start);
+
+    start = Clock::now();
+    double error = calibration.calibrate(frameSize);
+    double calibrationTime = secondsSince(start);
+
+    std::cout << std::endl
+        << "calibration images:  " << files.size() << " (" << detected << " detected)" << std::endl
+        << "corner detection:    " << detectionTime << " s" << std::endl
+        << "calibrateCamera:     " << calibrationTime << " s" << std::endl
+        << "reprojection error:  " << error << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string video;
+    std::string fixtureName = "chessboard";
+    std::string stages = "gray,chessboard";
+    std::string workdir = "ardoor-benchmark";
+    cv::Size frameSize(1280, 720);
+    int frameCount = 300;
+    int calibrationImages = 0;
+    int kernelRuns = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (option == "--video" && hasValue) {
+            video = argv[++i];
+        } else if (option == "--fixture" && hasValue) {
+            fixtureName = argv[++i];
+        } else if (option == "--frames" && hasValue) {
+            frameCount = atoi(argv[++i]);
+        } else if (option == "--size" && hasValue && sscanf(argv[i + 1], "%dx%d", &frameSize.width, &frameSize.height) == 2) {
+            i++;
+        } else if (option == "--stages" && hasValue) {
+            stages = argv[++i];
+        } else if (option == "--calibrate" && hasValue) {
+            calibrationImages = atoi(argv[++i]);
+        } else if (option == "--workdir" && hasValue) {
+            workdir = argv[++i];
+        } else if (option == "--kernels" && hasValue) {
+            kernelRuns = atoi(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return option == "--help" ? 0 : 1;
+        }
+    }
+
+    FrameSource* source;
+    cv::Mat patternImage;
+    if (!video.empty()) {
+        VideoFrameSource* videoSource = new VideoFrameSource(video);
+        if (!videoSource->isOpened()) {
+            std::cerr << "Could not open " << video << std::endl;
+            delete videoSource;
+            return 1;
+        }
+        source = videoSource;
+    } else if (fixtureName == "chessboard") {
+        source = new ChessboardFixture(frameSize, frameCount);
+    } else if (fixtureName == "pattern") {
+        PatternFixture* patternSource = new PatternFixture(frameSize, frameCount);
+        patternImage = patternSource->getPatternImage();
+        source = patternSource;
+    } else {
+        std::cerr << "Unknown fixture " << fixtureName << std::endl;
+        return 1;
+    }
+
+    ARDoor::CameraCalibration calibration;
+    setupCalibration(calibration, frameSize);
+
+    ARDoor::TestImageProcessor testProcessor(calibration);
+    GrayProcessor grayProcessor;
+    UndistortProcessor undistortProcessor(&calibration);
+    ChessboardProcessor chessboardProcessor(&calibration);
+    FeatureProcessor featureProcessor;
+    PatternProcessor patternProcessor;
+
+    if (!patternImage.empty()) {
+        patternProcessor.train(patternImage);
+    }
+
+    ARDoor::ImagePipeline pipeline(calibration);
+    pipeline.registerProcessor(&testProcessor);
+    pipeline.registerProcessor(&grayProcessor);
+    pipeline.registerProcessor(&undistortProcessor);
+    pipeline.registerProcessor(&chessboardProcessor);
+    pipeline.registerProcessor(&featureProcessor);
+    pipeline.registerProcessor(&patternProcessor);
+    pipeline.setConfiguration(parseStages(stages));
+    pipeline.setProfilingEnabled(true);
+
+    cv::Mat frame;
+    cv::Mat output;
+    int frames = 0;
+    double processingTime = 0;
+    Clock::time_point start = Clock::now();
+
+    while (source->nextFrame(frame)) {
+        Clock::time_point frameStart = Clock::now();
+        pipeline.processFrame(frame, output);
+        processingTime += secondsSince(frameStart);
+        frames++;
+    }
+
+    double totalTime = secondsSince(start);
+    delete source;
+
+    std::cout
+        << "frames:              " << frames << std::endl
+        << "total time:          " << totalTime << " s (" << frames / totalTime << " fps including decoding)" << std::endl
+        << "pipeline time:       " << processingTime << " s (" << frames / processingTime << " fps)" << std::endl
+        << "chessboards found:   " << chessboardProcessor.getDetections() << std::endl
+        << "patterns found:      " << patternProcessor.getDetections() << std::endl
+        << "keypoints per frame: " << featureProcessor.getAverageKeypoints() << std::endl
+        << std::endl;
+
+    pipeline.getProfiler().dump(std::cout);
+
+    if (calibrationImages > 0) {
+        benchmarkCalibration(calibrationImages, frameSize, workdir);
+    }
+
+    if (kernelRuns > 0) {
+        benchmarkKernels(frameSize, kernelRuns);
+    }
+
+    return 0;
+}
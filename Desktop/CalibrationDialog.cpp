@@ -5,13 +5,16 @@
 
 #include <QCamera>
 
-CalibrationDialog::CalibrationDialog(ARDoor::CameraCalibration *calibrator, QWidget *parent) :
+const std::string CalibrationDialog::CAMERA_DEVICE = "default";
+
+CalibrationDialog::CalibrationDialog(ARDoor::CameraCalibration *calibrator, ARDoor::CalibrationStore *store, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::CalibrationDialog)
 {
     ui->setupUi(this);
 
     this->calibrator = calibrator;
+    this->store = store;
 
     matWidget = new ImageWidget(this);
     ui->mainContainer->addWidget(matWidget, 1);
@@ -20,10 +23,14 @@ CalibrationDialog::CalibrationDialog(ARDoor::CameraCalibration *calibrator, QWid
     imageProcessor = new CalibrationImageProcessor(calibrator, matWidget);
     camera.setCaptureMode(QCamera::CaptureViewfinder);
     camera.setViewfinder(imageProcessor);
+
+    finishTimer.setInterval(100);
+    connect(&finishTimer, SIGNAL(timeout()), this, SLOT(onFinishTimer()));
 }
 
 CalibrationDialog::~CalibrationDialog()
 {
+    finishTimer.stop();
     delete ui;
     delete matWidget;
     delete imageProcessor;
@@ -39,9 +46,45 @@ void CalibrationDialog::on_pushButton_clicked()
 }
 
 void CalibrationDialog::on_pushButton_2_clicked()
+{
+    if (!imageProcessor->finishCalibration()) {
+        std::cerr << "Not enough views for calibration" << std::endl;
+        return;
+    }
+
+    // the final estimate is computed on the background thread, the timer saves it once it is done
+    ui->pushButton_2->setEnabled(false);
+    finishTimer.start();
+    onFinishTimer();
+}
+
+void CalibrationDialog::onFinishTimer()
+{
+    // checked before taking over the estimate, an estimate finishing in between is then not missed
+    bool estimating = imageProcessor->isEstimating();
+    imageProcessor->updateEstimate();
+
+    if (imageProcessor->isCalibrationFinished()) {
+        finishTimer.stop();
+        ui->pushButton_2->setEnabled(true);
+        finishCalibration();
+    } else if (imageProcessor->hasCalibrationFailed()) {
+        finishTimer.stop();
+        ui->pushButton_2->setEnabled(true);
+        std::cerr << "Calibration failed" << std::endl;
+    } else if (!estimating && !imageProcessor->finishCalibration()) {
+        // outliers have been dropped since the request
+        finishTimer.stop();
+        ui->pushButton_2->setEnabled(true);
+        std::cerr << "Not enough views for calibration" << std::endl;
+    }
+}
+
+void CalibrationDialog::finishCalibration()
 {
     cv::Size size = imageProcessor->getImageSize();
-    calibrator->calibrate(size);
+    double error = imageProcessor->calibrate();
+    std::cout << "Re-projection error " << error << " px" << std::endl;
 
     cv::Mat_<float> intrinsics = calibrator->getIntrinsicsMatrix();
     cv::Mat_<float> distortion = calibrator->getDistortionCoeffs();
@@ -49,24 +92,8 @@ void CalibrationDialog::on_pushButton_2_clicked()
     DebugHelper::printMat<float>(intrinsics);
     DebugHelper::printMat<float>(distortion);
 
-
-    settings.beginGroup("calibration/matrix/intrinsics");
-    for (int i = 0; i < intrinsics.rows; ++i) {
-        for (int j = 0; j < intrinsics.cols; ++j) {
-            QString settingName = QString("m") + QString::number(i) + QString::number(j);
-            settings.setValue(settingName, intrinsics.at<float>(i, j));
-        }
-    }
-    settings.endGroup();
-
-    std::cout.flush();
-
-    settings.beginGroup("calibration/matrix/distortion");
-    for (int i = 0; i < distortion.rows; ++i) {
-        for (int j = 0; j < distortion.cols; ++j) {
-            QString settingName = QString("m") + QString::number(i) + QString::number(j);
-            settings.setValue(settingName, distortion.at<float>(i, j));
-        }
+    store->put(CAMERA_DEVICE, size, *calibrator);
+    if (!store->save()) {
+        std::cerr << "Could not save calibration" << std::endl;
     }
-    settings.endGroup();
 }
@@ -2,11 +2,12 @@
 #define CALIBRATIONDIALOG_H
 
 #include "CameraCalibration.h"
+#include "CalibrationStore.h"
 #include "ImageWidget.h"
 #include "CalibrationImageProcessor.h"
 #include <QDialog>
 #include <QCamera>
-#include <QSettings>
+#include <QTimer>
 
 namespace Ui {
 class CalibrationDialog;
@@ -17,21 +18,29 @@ class CalibrationDialog : public QDialog
     Q_OBJECT
     
 public:
-    explicit CalibrationDialog(ARDoor::CameraCalibration *calibrator, QWidget *parent = 0);
+    explicit CalibrationDialog(ARDoor::CameraCalibration *calibrator, ARDoor::CalibrationStore *store, QWidget *parent = 0);
     ~CalibrationDialog();
+
+    // profile name of the camera used for capturing
+    static const std::string CAMERA_DEVICE;
     
 private slots:
     void on_pushButton_clicked();
     void on_pushButton_2_clicked();
+    void onFinishTimer();
 
 private:
+    void finishCalibration();
+
     Ui::CalibrationDialog *ui;
 
     ARDoor::CameraCalibration* calibrator;
+    ARDoor::CalibrationStore* store;
     ImageWidget* matWidget;
     CalibrationImageProcessor* imageProcessor;
     QCamera camera;
-    QSettings settings;
+    // polls for the final estimate, which is computed in the background
+    QTimer finishTimer;
 };
 
 #endif // CALIBRATIONDIALOG_H
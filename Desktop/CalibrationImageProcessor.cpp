@@ -1,52 +1,176 @@
 #include "CalibrationImageProcessor.h"
 #include "QtUtil.h"
+#include "ImageUtils.h"
 #include <opencv2/core/core.hpp>
 
 cv::Size CalibrationImageProcessor::BOARD_SIZE = cv::Size(9, 6);
 
+// views whose error exceeds the overall error by this factor are dropped
+static const double OUTLIER_FACTOR = 3.0;
+
 CalibrationImageProcessor::CalibrationImageProcessor(ARDoor::CameraCalibration *calibration, ImageWidget *widget)
+    : incrementalCalibration(calibration, BOARD_SIZE), tracker(BOARD_SIZE)
 {
     this->calibration = calibration;
     this->widget = widget;
+
+    // same board coordinates as CameraCalibration::findChessboardPoints
+    for (int i = 0; i < BOARD_SIZE.height; i++) {
+        for (int j = 0; j < BOARD_SIZE.width; j++) {
+            objectCorners.push_back(cv::Point3f(i * 110, j * 110, 0.0f)); //110 = size of one square on the board
+        }
+    }
+
+    running = true;
+    hasPendingFrame = false;
+    hasDetection = false;
+    detector = std::thread(&CalibrationImageProcessor::detect, this);
+}
+
+CalibrationImageProcessor::~CalibrationImageProcessor()
+{
+    {
+        std::lock_guard<std::mutex> lock(detectionMutex);
+        running = false;
+    }
+    frameAvailable.notify_one();
+    detector.join();
 }
 
 QList<QVideoFrame::PixelFormat> CalibrationImageProcessor::supportedPixelFormats(QAbstractVideoBuffer::HandleType handleType) const
 {
     Q_UNUSED(handleType);
     // Return the formats you will support
-    return QList<QVideoFrame::PixelFormat>() << QVideoFrame::Format_RGB32;
+    return QList<QVideoFrame::PixelFormat>()
+            << QVideoFrame::Format_RGB32
+            << QVideoFrame::Format_ARGB32
+            << QVideoFrame::Format_NV21
+            << QVideoFrame::Format_NV12
+            << QVideoFrame::Format_YUV420P
+            << QVideoFrame::Format_YV12
+            << QVideoFrame::Format_Y8;
 }
 
 bool CalibrationImageProcessor::present(const QVideoFrame &frame)
 {
-    cv::Mat mat = QtUtil::convertToMat(frame);
-    cv::Mat grey;
-    cv::cvtColor(mat, grey, CV_RGB2GRAY);
+    MappedFrame view(frame);
+    if (!view.isValid()) {
+        return false;
+    }
 
-    std::vector<cv::Point2f> imageCorners;
-    std::vector<cv::Point3f> objectCorners;
+    // planar YUV frames carry the gray image in their Y plane, RGB32 is converted into the reused buffer
+    cv::Mat grey = view.luminance();
+    if (grey.empty()) {
+        ARDoor::ImageUtils::bgraToGray(view.mat(), greyBuffer);
+        grey = greyBuffer;
+    }
 
-    time_t delay = 1;
+    std::vector<cv::Point2f> imageCorners;
+    cv::Size cornersSize;
+    bool found = false;
 
-    if (time(NULL) - prevTimestamp > delay) {
-        if (calibration->findChessboardPoints(grey, BOARD_SIZE, imageCorners, objectCorners)) {
-            std::cout << "Chessboard found" << std::endl;
+    {
+        // the mapped frame is only valid during present, so the detection gets a copy
+        std::lock_guard<std::mutex> lock(detectionMutex);
+        pendingFrame = grey.clone();
+        hasPendingFrame = true;
 
-            imageSize = mat.size();
-            calibration->addPoints(imageCorners, objectCorners);
-            //cv::drawChessboardCorners(mat, imageSize, imageCorners, true);
+        if (hasDetection) {
+            imageCorners.swap(detectedCorners);
+            cornersSize = detectedSize;
+            hasDetection = false;
+            found = true;
         }
+    }
+    frameAvailable.notify_one();
+
+    // views too similar to the collected ones are rejected by the coverage grid
+    if (found) {
+        imageSize = cornersSize;
 
-        prevTimestamp = time(NULL);
+        if (incrementalCalibration.addView(imageCorners, objectCorners, imageSize)) {
+            std::cout << "View added, " << incrementalCalibration.getViews().size() << " views covering "
+                      << incrementalCalibration.getCoverage() << " cells" << std::endl;
+        }
     }
 
-    widget->setFrame(frame);
+    updateEstimate();
+
+    // the widget copies the image while scaling it, so the mapped data can be shown directly
+    widget->setMat(view.isYuv() ? grey : view.mat());
     widget->repaint();
 
     return true;
 }
 
+void CalibrationImageProcessor::detect()
+{
+    std::vector<cv::Point2f> corners;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(detectionMutex);
+            frameAvailable.wait(lock, [this]() { return hasPendingFrame || !running; });
+
+            if (!running) {
+                return;
+            }
+
+            detectionFrame = pendingFrame;
+            pendingFrame.release();
+            hasPendingFrame = false;
+        }
+
+        // the tracker follows a found board with optical flow, the full search only runs when it is lost
+        if (tracker.track(detectionFrame, corners)) {
+            std::lock_guard<std::mutex> lock(detectionMutex);
+            detectedCorners = corners;
+            detectedSize = detectionFrame.size();
+            hasDetection = true;
+        }
+    }
+}
+
+void CalibrationImageProcessor::updateEstimate()
+{
+    if (incrementalCalibration.update()) {
+        const ARDoor::CalibrationEstimate &estimate = incrementalCalibration.getEstimate();
+        std::cout << "Re-projection error " << estimate.rms << " px" << std::endl;
+
+        int dropped = incrementalCalibration.dropOutliers(estimate.rms * OUTLIER_FACTOR);
+        if (dropped > 0) {
+            std::cout << "Dropped " << dropped << " outlier views" << std::endl;
+        }
+    }
+}
+
 cv::Size CalibrationImageProcessor::getImageSize()
 {
     return imageSize;
 }
+
+bool CalibrationImageProcessor::finishCalibration()
+{
+    return incrementalCalibration.requestFinalEstimate();
+}
+
+bool CalibrationImageProcessor::isCalibrationFinished() const
+{
+    return incrementalCalibration.isEstimateCurrent();
+}
+
+bool CalibrationImageProcessor::hasCalibrationFailed() const
+{
+    return incrementalCalibration.hasEstimateFailed();
+}
+
+bool CalibrationImageProcessor::isEstimating()
+{
+    return incrementalCalibration.isEstimating();
+}
+
+double CalibrationImageProcessor::calibrate()
+{
+    return incrementalCalibration.applyEstimate();
+}
@@ -2,14 +2,26 @@
 #define CALIBRATIONIMAGEPROCESSOR_H
 
 #include "CameraCalibration.h"
+#include "ChessboardTracker.h"
+#include "IncrementalCalibration.h"
 #include "ImageWidget.h"
-#include <ctime>
 #include <QAbstractVideoSurface>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
+/**
+ * Shows the camera frames and collects chessboard views for the calibration.
+ * The board is searched on a detection thread, a frame arriving while the
+ * thread is busy replaces the one still waiting. The views are handed back
+ * and added to the incremental calibration on the thread presenting the
+ * frames.
+ */
 class CalibrationImageProcessor : public QAbstractVideoSurface
 {
 public:
     CalibrationImageProcessor(ARDoor::CameraCalibration* calibration, ImageWidget* widget);
+    ~CalibrationImageProcessor();
 
     static cv::Size BOARD_SIZE;
 
@@ -18,11 +30,63 @@ public:
 
     cv::Size getImageSize();
 
+    /**
+     * Takes over a finished background estimate and drops the outlier views.
+     * Called for every frame, and while waiting for the final estimate.
+     */
+    void updateEstimate();
+
+    /**
+     * Requests an estimate from all views collected so far
+     * @return false if too few views have been collected
+     */
+    bool finishCalibration();
+
+    /**
+     * @return true once the estimate covers all collected views
+     */
+    bool isCalibrationFinished() const;
+
+    /**
+     * @return true if the estimation of all collected views failed
+     */
+    bool hasCalibrationFailed() const;
+
+    /**
+     * @return true while an estimate is computed in the background
+     */
+    bool isEstimating();
+
+    /**
+     * Stores the current estimate in the calibration
+     * @return the re-projection error, negative if there is no estimate
+     */
+    double calibrate();
+
 private:
+    void detect();
+
     ARDoor::CameraCalibration* calibration;
     ImageWidget* widget;
+    ARDoor::IncrementalCalibration incrementalCalibration;
     cv::Size imageSize;
-    time_t prevTimestamp;
+    cv::Mat greyBuffer;
+    std::vector<cv::Point3f> objectCorners;
+
+    // only used by the detection thread
+    ARDoor::ChessboardTracker tracker;
+    cv::Mat detectionFrame;
+
+    std::thread detector;
+    std::mutex detectionMutex;
+    std::condition_variable frameAvailable;
+    bool running;
+    cv::Mat pendingFrame;
+    bool hasPendingFrame;
+    // corners found in the last searched frame, not picked up yet
+    std::vector<cv::Point2f> detectedCorners;
+    cv::Size detectedSize;
+    bool hasDetection;
 };
 
 #endif // CALIBRATIONIMAGEPROCESSOR_H
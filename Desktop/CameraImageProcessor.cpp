@@ -8,17 +8,35 @@ CameraImageProcessor::CameraImageProcessor(GLRenderer *renderer, ARDoor::ImagePi
     this->pipeline = pipeline;
 }
 
+void CameraImageProcessor::setFrameSizeCallback(const FrameSizeCallback &callback)
+{
+    frameSizeCallback = callback;
+}
+
 QList<QVideoFrame::PixelFormat> CameraImageProcessor::supportedPixelFormats(QAbstractVideoBuffer::HandleType handleType) const
 {
     Q_UNUSED(handleType);
     // Return the formats you will support
-    return QList<QVideoFrame::PixelFormat>() << QVideoFrame::Format_RGB32;
+    return QList<QVideoFrame::PixelFormat>() << QVideoFrame::Format_RGB32 << QVideoFrame::Format_ARGB32;
 }
 
 bool CameraImageProcessor::present(const QVideoFrame &frame)
 {
-    cv::Mat mat = QtUtil::convertToMat(frame);
-    cv::cvtColor(mat, mat, CV_BGR2RGB);
-    renderer->updateBackground(mat);
+    MappedFrame view(frame);
+    if (!view.isValid()) {
+        return false;
+    }
+
+    if (view.mat().size() != frameSize) {
+        frameSize = view.mat().size();
+        if (frameSizeCallback) {
+            frameSizeCallback(frameSize);
+        }
+    }
+
+    // RGB32 is laid out as BGRA, which is uploaded as it is. The renderer keeps
+    // the frame until it is drawn, so it gets its own copy of the mapped data.
+    renderer->updateBackground(view.mat().clone());
+
     return true;
 }
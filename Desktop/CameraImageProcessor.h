@@ -4,18 +4,29 @@
 #include "GLRenderer.h"
 #include "ImagePipeline.h"
 #include <QAbstractVideoSurface>
+#include <functional>
 
 class CameraImageProcessor : public QAbstractVideoSurface
 {
 public:
+    typedef std::function<void(cv::Size frameSize)> FrameSizeCallback;
+
     CameraImageProcessor(GLRenderer *renderer, ARDoor::ImagePipeline* pipeline);
 
+    /**
+     * Sets the function called from present with the size of the first frame
+     * and whenever the size of the frames changes
+     */
+    void setFrameSizeCallback(const FrameSizeCallback &callback);
+
     QList<QVideoFrame::PixelFormat> supportedPixelFormats(QAbstractVideoBuffer::HandleType handleType = QAbstractVideoBuffer::NoHandle) const;
     bool present(const QVideoFrame &frame);
 
 private:
     GLRenderer *renderer;
     ARDoor::ImagePipeline* pipeline;
+    FrameSizeCallback frameSizeCallback;
+    cv::Size frameSize;
 };
 
 #endif // CAMERAIMAGEPROCESSOR_H
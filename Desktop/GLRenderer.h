@@ -8,6 +8,8 @@ class GLRenderer : public QGLWidget
 {
 public:
     GLRenderer(QWidget *parent, ARDoor::RenderingContext *context) : QGLWidget(parent), context(context) {}
+    // the GL resources of the context are freed while its GL context still exists
+    ~GLRenderer() { makeCurrent(); context->release(); }
 
     void updateBackground(const cv::Mat &mat)
     {
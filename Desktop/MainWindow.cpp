@@ -4,9 +4,21 @@
 #include "DebugHelper.h"
 #include <iostream>
 #include <QFileDialog>
+#include <QStandardPaths>
+#include <QDir>
+#include <QProgressDialog>
+#include <QApplication>
+
+static std::string calibrationStorePath()
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    QDir().mkpath(directory);
+    return QDir(directory).filePath("calibration.bin").toStdString();
+}
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
+    calibrationStore(calibrationStorePath()),
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
@@ -31,8 +43,18 @@ MainWindow::MainWindow(QWidget *parent) :
     camera.setCaptureMode(QCamera::CaptureViewfinder);
     camera.setViewfinder(imageProcessor);
 
-    // load calibration settings
-    if (settings.contains("calibration/matrix/intrinsics/m00")) {
+    // the profile of the stream resolution is applied once the frames arrive
+    imageProcessor->setFrameSizeCallback([this](cv::Size frameSize) {
+        applyCalibration(frameSize);
+    });
+
+    // load calibration profiles, older versions kept the matrices in the settings
+    std::vector<cv::Size> resolutions;
+    if (calibrationStore.load()) {
+        resolutions = calibrationStore.getResolutions(CalibrationDialog::CAMERA_DEVICE);
+    }
+
+    if (resolutions.empty() && settings.contains("calibration/matrix/intrinsics/m00")) {
         cv::Mat intrinsics = cv::Mat(3, 3, CV_32F);
         cv::Mat distortion = cv::Mat(1, 5, CV_32F);
 
@@ -60,6 +82,21 @@ MainWindow::MainWindow(QWidget *parent) :
         calibrator.setIntrinsicsMatrix(intrinsics);
         calibrator.setDistortionCoeffs(distortion);
     }
+
+    context->updateCalibration();
+}
+
+void MainWindow::applyCalibration(cv::Size frameSize)
+{
+    if (!calibrationStore.apply(CalibrationDialog::CAMERA_DEVICE, frameSize, calibrator)) {
+        std::cerr << "No calibration for " << frameSize.width << "x" << frameSize.height << std::endl;
+        return;
+    }
+
+    DebugHelper::printMat<float>(calibrator.getIntrinsicsMatrix());
+    DebugHelper::printMat<float>(calibrator.getDistortionCoeffs());
+
+    context->updateCalibration();
 }
 
 MainWindow::~MainWindow()
@@ -68,6 +105,10 @@ MainWindow::~MainWindow()
     delete pipeline;
     delete imageProcessor;
     delete cameraWidget;
+
+    // the renderer releases the GL resources of the context while its GL context still exists
+    delete glRenderer;
+    delete context;
     delete ui;
 }
 
@@ -81,7 +122,15 @@ void MainWindow::onCalibrationAction()
         fileList.push_back(it->toStdString());
     }
 
-    calibrator.addChessboardPoints(fileList, size);
+    QProgressDialog progressDialog("Searching chessboards...", QString(), 0, fileList.size(), this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.show();
+
+    calibrator.addChessboardPoints(fileList, size, [&progressDialog](int processed, int total) {
+        Q_UNUSED(total);
+        progressDialog.setValue(processed);
+        QApplication::processEvents();
+    });
 }
 
 void MainWindow::on_pushButton_clicked()
@@ -95,6 +144,9 @@ void MainWindow::on_pushButton_clicked()
 
 void MainWindow::on_pushButton_2_clicked()
 {
-    CalibrationDialog dialog(&calibrator, this);
+    CalibrationDialog dialog(&calibrator, &calibrationStore, this);
     dialog.exec();
+
+    // the dialog calibrates the shared calibrator, the pose estimation works on a copy
+    context->updateCalibration();
 }
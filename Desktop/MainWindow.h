@@ -2,6 +2,7 @@
 #define MAINWINDOW_H
 
 #include "CameraCalibration.h"
+#include "CalibrationStore.h"
 #include "ImagePipeline.h"
 #include "TestImageProcessor.h"
 #include "CameraImageProcessor.h"
@@ -30,6 +31,9 @@ private slots:
     void on_pushButton_2_clicked();
 
 private:
+    void applyCalibration(cv::Size frameSize);
+
+    ARDoor::CalibrationStore calibrationStore;
     ARDoor::CameraCalibration calibrator;
     ARDoor::RenderingContext* context;
     ARDoor::ImagePipeline* pipeline;
@@ -1,4 +1,5 @@
 #include "QtUtil.h"
+#include "ImageUtils.h"
 #include <opencv/cv.h>
 #include <opencv2/core/core.hpp>
 #include <QPoint>
@@ -6,11 +7,42 @@
 cv::Mat QtUtil::convertToMat(const QImage &image)
 {
     QImage rgb = image.convertToFormat(QImage::Format_RGB888);
-    return cv::Mat(rgb.height(), rgb.width(), CV_8UC3, (void*) rgb.scanLine(0), rgb.bytesPerLine());
+    // the converted image is freed on return, so the data has to be copied
+    return cv::Mat(rgb.height(), rgb.width(), CV_8UC3, (void*) rgb.scanLine(0), rgb.bytesPerLine()).clone();
 }
 
 cv::Mat QtUtil::convertToMat(const QVideoFrame &frame)
 {
+    cv::Mat rgb;
+    {
+        MappedFrame view(frame);
+        switch (view.isValid() ? view.pixelFormat() : QVideoFrame::Format_Invalid) {
+        case QVideoFrame::Format_RGB32:
+        case QVideoFrame::Format_ARGB32:
+        case QVideoFrame::Format_BGRA32:
+            ARDoor::ImageUtils::bgraToRgb(view.mat(), rgb);
+            return rgb;
+        case QVideoFrame::Format_NV21:
+            ARDoor::ImageUtils::nv21ToRgb(view.mat(), rgb);
+            return rgb;
+        case QVideoFrame::Format_NV12:
+            cv::cvtColor(view.mat(), rgb, CV_YUV2RGB_NV12);
+            return rgb;
+        case QVideoFrame::Format_YUV420P:
+            cv::cvtColor(view.mat(), rgb, CV_YUV2RGB_I420);
+            return rgb;
+        case QVideoFrame::Format_YV12:
+            cv::cvtColor(view.mat(), rgb, CV_YUV2RGB_YV12);
+            return rgb;
+        case QVideoFrame::Format_Y8:
+            cv::cvtColor(view.mat(), rgb, CV_GRAY2RGB);
+            return rgb;
+        default:
+            break;
+        }
+    }
+
+    // other formats go through QImage, the frame has to be unmapped before it is mapped again
     return convertToMat(convertToImage(frame));
 }
 
@@ -46,6 +78,15 @@ QImage QtUtil::convertToImage(const cv::Mat &mat)
         return img;
     }
 
+    // 8-bits unsigned, NO. OF CHANNELS=4, laid out as BGRA
+    if (mat.type() == CV_8UC4)
+    {
+        const uchar *qImageBuffer = (const uchar*) mat.data;
+
+        QImage img(qImageBuffer, mat.cols, mat.rows, mat.step, QImage::Format_RGB32);
+        return img;
+    }
+
     return QImage();
 }
 
@@ -53,8 +94,100 @@ QImage QtUtil::convertToImage(const QVideoFrame &frame)
 {
     QVideoFrame copy(frame);
     if (copy.map(QAbstractVideoBuffer::ReadOnly)) {
-        QImage::Format format = QVideoFrame::imageFormatFromPixelFormat(frame.pixelFormat());
-        return QImage(frame.bits(), frame.width(), frame.height(), frame.bytesPerLine(), format);
+        QImage::Format format = QVideoFrame::imageFormatFromPixelFormat(copy.pixelFormat());
+        // the bits are only valid while the frame is mapped
+        QImage image = QImage(copy.bits(), copy.width(), copy.height(), copy.bytesPerLine(), format).copy();
+        copy.unmap();
+        return image;
     }
     return QImage();
 }
+
+MappedFrame::MappedFrame(const QVideoFrame &frame) : frame(frame)
+{
+    if (!this->frame.map(QAbstractVideoBuffer::ReadOnly)) {
+        return;
+    }
+
+    int width = this->frame.width();
+    int height = this->frame.height();
+    uchar *bits = this->frame.bits();
+    size_t step = this->frame.bytesPerLine();
+
+    switch (this->frame.pixelFormat()) {
+    case QVideoFrame::Format_RGB32:
+    case QVideoFrame::Format_ARGB32:
+        data = cv::Mat(height, width, CV_8UC4, bits, step);
+        break;
+    case QVideoFrame::Format_BGRA32:
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        ARDoor::ImageUtils::argbToBgra(cv::Mat(height, width, CV_8UC4, bits, step), data);
+#else
+        data = cv::Mat(height, width, CV_8UC4, bits, step);
+#endif
+        break;
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+        // the chroma planes follow the Y plane directly, with half its stride
+        data = cv::Mat(height * 3 / 2, width, CV_8UC1, bits, step);
+        break;
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV:
+        data = cv::Mat(height, width, CV_8UC2, bits, step);
+        break;
+    case QVideoFrame::Format_Y8:
+        data = cv::Mat(height, width, CV_8UC1, bits, step);
+        break;
+    default:
+        break;
+    }
+}
+
+MappedFrame::~MappedFrame()
+{
+    if (frame.isMapped()) {
+        frame.unmap();
+    }
+}
+
+bool MappedFrame::isValid() const
+{
+    return !data.empty();
+}
+
+bool MappedFrame::isYuv() const
+{
+    switch (frame.pixelFormat()) {
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV:
+    case QVideoFrame::Format_Y8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QVideoFrame::PixelFormat MappedFrame::pixelFormat() const
+{
+    return frame.pixelFormat();
+}
+
+const cv::Mat& MappedFrame::mat() const
+{
+    return data;
+}
+
+cv::Mat MappedFrame::luminance() const
+{
+    if (data.empty() || data.type() != CV_8UC1) {
+        return cv::Mat();
+    }
+
+    return data.rowRange(0, frame.height());
+}
@@ -14,4 +14,45 @@ public:
     static QImage convertToImage(const QVideoFrame& frame);
 };
 
+/**
+ * Maps a video frame for reading as long as the object lives and wraps the
+ * mapped bits as a cv::Mat, without copying them. The matrix must not be
+ * used after the frame view has been destroyed, clone it to keep the data.
+ *
+ * RGB32, ARGB32 and BGRA32 become CV_8UC4 with the channels B, G, R, A.
+ * RGB32 and ARGB32 are wrapped as they are, which is this order on little
+ * endian machines. BGRA32 is defined by its 32-bit words, so its bytes are
+ * A, R, G, B there and it is reordered into a copy.
+ * NV12, NV21, YUV420P and YV12 become CV_8UC1 with height * 3 / 2 rows, the
+ * Y plane followed by the chroma planes, as expected by cv::cvtColor.
+ * UYVY and YUYV become CV_8UC2 and Y8 CV_8UC1.
+ */
+class MappedFrame
+{
+public:
+    MappedFrame(const QVideoFrame& frame);
+    ~MappedFrame();
+
+    /**
+     * @return false if the frame could not be mapped or its format is not supported
+     */
+    bool isValid() const;
+    bool isYuv() const;
+    QVideoFrame::PixelFormat pixelFormat() const;
+
+    const cv::Mat& mat() const;
+
+    /**
+     * @return the Y plane of planar YUV frames, empty for all other formats
+     */
+    cv::Mat luminance() const;
+
+private:
+    MappedFrame(const MappedFrame&);
+    MappedFrame& operator=(const MappedFrame&);
+
+    QVideoFrame frame;
+    cv::Mat data;
+};
+
 #endif // QTUTIL_H
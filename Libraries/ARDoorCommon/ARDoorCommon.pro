@@ -15,25 +15,58 @@ include(../../_globals.pro)
 
 SOURCES += \
     CameraCalibration.cpp \
+    CalibrationStore.cpp \
     PoseEstimation.cpp \
     ImagePipeline.cpp \
+    AsyncImagePipeline.cpp \
+    PipelineProfiler.cpp \
     TestImageProcessor.cpp \
     RenderingContext.cpp \
+    OverlayRenderer.cpp \
+    ARSceneView.cpp \
+    BackgroundStream.cpp \
     PatternExtractor.cpp \
+    PatternDetector.cpp \
+    PatternDatabase.cpp \
+    ChessboardTracker.cpp \
+    VisionWorker.cpp \
+    PoseFilter.cpp \
+    IncrementalCalibration.cpp \
     ImageUtils.cpp
 
 HEADERS += \
     CameraCalibration.h \
+    CalibrationStore.h \
     PoseEstimation.h \
     ImagePipeline.h \
+    AsyncImagePipeline.h \
+    BoundedQueue.h \
+    PipelineProfiler.h \
     ImageProcessor.h \
     TestImageProcessor.h \
     RenderingContext.h \
+    OverlayRenderer.h \
+    ARSceneView.h \
+    BackgroundStream.h \
     DebugHelper.h \
     PatternExtractor.h \
+    PatternDetector.h \
+    PatternDatabase.h \
+    ChessboardTracker.h \
+    VisionWorker.h \
+    PoseFilter.h \
+    IncrementalCalibration.h \
     Pattern.h \
     ImageUtils.h
 
+# SSSE3 shuffles for the colour conversion kernels in ImageUtils
+!win32:contains(QMAKE_HOST.arch, x86.*) {
+    QMAKE_CXXFLAGS += -mssse3
+}
+
+# SLProject buffers, shaders and scene view for the augmented content
+include(../SLProject/SLProject.pri)
+
 unix:!macx {
     CONFIG += link_pkgconfig
     PKGCONFIG += opencv
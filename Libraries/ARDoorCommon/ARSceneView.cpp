@@ -0,0 +1,206 @@
+#include "ARSceneView.h"
+
+#include <SLScene.h>
+#include <SLGroup.h>
+#include <SLCamera.h>
+#include <SLLightSphere.h>
+#include <SLGLTexture.h>
+#include <SLGLShaderProg.h>
+#include <SL3DSMeshFile.h>
+
+#include <opencv2/calib3d/calib3d.hpp>
+
+namespace ARDoor {
+
+ARSceneView::ARSceneView(CameraCalibration *calibration, int width, int height)
+    : SLSceneView("ARDoor", width, height, 96)
+{
+    m_calibration = calibration;
+    m_isFrameChanged = false;
+    m_lastPaintTime = 0;
+
+#ifdef __glew_h__
+    // GLEW resolves the entry points of the context created by the window system
+    glewInit();
+#endif
+
+#ifdef SL_SHADER_PATH
+    SLGLShaderProg::defaultPath = SL_SHADER_PATH;
+#endif
+
+    // the scene loads the standard shaders, which needs the path above
+    m_scene = new SLScene("ARDoor");
+    m_scene->activeSV(this);
+    m_scene->init();
+
+    // the image of the camera is the background, a frame without intrinsics is never drawn
+    m_camera = new SLCamera();
+    m_camera->projection(monoPerspective);
+    m_camera->clipNear(0.01f);
+    m_camera->clipFar(100.0f);
+    camera(m_camera);
+
+    m_background = new SLGLTexture();
+}
+
+ARSceneView::~ARSceneView()
+{
+    m_quadPositions.dispose();
+    m_quadTexCoords.dispose();
+    m_quadIndices.dispose();
+    delete m_background;
+
+    // the scene deletes the GL state, so it goes last
+    camera(0);
+    delete m_camera;
+    delete m_scene;
+}
+
+bool ARSceneView::loadModel(const std::string& path, float scale)
+{
+    // the loader exits if the file is missing
+    SLstring file = path;
+    if (!SLFileSystem::fileExists(file)) {
+        return false;
+    }
+
+    // 3DS models have z up, the loader turns them to y up
+    SLGroup *model = SL3DSMeshFile::load(file, 0, true, true);
+    model->scale(scale);
+
+    SLGroup *scene = new SLGroup("Model");
+    scene->addNode(model);
+    setScene(scene);
+
+    return true;
+}
+
+void ARSceneView::setScene(SLGroup *scene)
+{
+    // drops the previous scene graph together with its materials and textures
+    m_scene->init();
+    camera(m_camera);
+
+    // board coordinates have y down and z pointing into the board
+    SLGroup *root = new SLGroup("Board");
+    root->rotate(180, 1, 0, 0);
+
+    // head light in front of the board, the standard shaders need at least one light
+    SLLightSphere *light = new SLLightSphere(0, 0, 10, 0.05f);
+    light->attenuation(1, 0, 0);
+    root->addNode(light);
+    root->addNode(scene);
+
+    m_scene->root3D(root);
+    onInitialize();
+}
+
+void ARSceneView::updateBackground(const cv::Mat& frame)
+{
+    m_frame = frame;
+    m_isFrameChanged = true;
+}
+
+void ARSceneView::setPose(const Pose& pose)
+{
+    m_pose = pose;
+}
+
+bool ARSceneView::paint()
+{
+    if (!_stateGL) {
+        onInitialize();
+    }
+
+    if (m_frame.data == NULL) {
+        return false;
+    }
+
+    SLfloat now = m_scene->timeSec();
+    SLfloat elapsedTime = now - m_lastPaintTime;
+    m_lastPaintTime = now;
+
+    _stateGL->viewport(0, 0, _scrW, _scrH);
+    _stateGL->clearColorDepthBuffer();
+
+    drawBackground();
+
+    bool updated = false;
+    if (m_pose.valid && m_scene->root3D()) {
+        updateCamera();
+
+        // culls against the calibrated frustum and draws the blended shapes last
+        updated = updateAndDraw3D(elapsedTime);
+    }
+
+    _stateGL->unbindAnythingAndFlush();
+
+    return updated;
+}
+
+void ARSceneView::drawBackground()
+{
+    if (m_isFrameChanged) {
+        SLenum format;
+        switch (m_frame.channels()) {
+        case 1:  format = GL_LUMINANCE; break;
+        case 4:  format = GL_BGRA; break;
+        default: format = GL_BGR; break;
+        }
+
+        m_background->copyVideoImage(m_frame.cols, m_frame.rows, format, m_frame.data, (SLint) m_frame.step);
+        m_isFrameChanged = false;
+    }
+
+    if (!m_quadPositions.id()) {
+        // full screen quad, the first image row is at the top
+        SLfloat positions[] = { -1, 1,  -1, -1,  1, 1,  1, -1 };
+        SLfloat texCoords[] = {  0, 0,   0,  1,  1, 0,  1,  1 };
+        SLushort indices[]  = {  0, 1, 2, 3 };
+
+        m_quadPositions.generate(positions, 4, 2);
+        m_quadTexCoords.generate(texCoords, 4, 2);
+        m_quadIndices.generate(indices, 4, 1, SL_UNSIGNED_SHORT, SL_ELEMENT_ARRAY_BUFFER);
+    }
+
+    _stateGL->depthTest(false);
+    _stateGL->depthMask(false);
+    _stateGL->blend(false);
+
+    SLMat4f identity;
+    SLGLShaderProg *shader = m_scene->shaderProgs(TextureOnly);
+    shader->useProgram();
+    shader->uniformMatrix4fv("u_mvpMatrix", 1, identity.m());
+    shader->uniform1i("u_texture0", 0);
+
+    m_background->bindActive(0);
+
+    m_quadPositions.bindAndEnableAttrib(shader->getAttribLocation("a_position"));
+    m_quadTexCoords.bindAndEnableAttrib(shader->getAttribLocation("a_texCoord"));
+    m_quadIndices.bindAndDrawElementsAs(SL_TRIANGLE_STRIP);
+    m_quadPositions.disableAttribArray();
+    m_quadTexCoords.disableAttribArray();
+
+    _stateGL->depthMask(true);
+}
+
+void ARSceneView::updateCamera()
+{
+    cv::Mat_<double> K;
+    m_calibration->getIntrinsicsMatrix().convertTo(K, CV_64F);
+    m_camera->intrinsics((SLfloat) K(0, 0), (SLfloat) K(1, 1), (SLfloat) K(0, 2), (SLfloat) K(1, 2), m_frame.cols, m_frame.rows);
+
+    cv::Matx33d R;
+    cv::Rodrigues(m_pose.rotation, R);
+    cv::Mat_<double> t;
+    m_pose.translation.convertTo(t, CV_64F);
+
+    // OpenCV looks down +z with y pointing down, GL down -z with y up
+    SLMat4f vm((SLfloat)  R(0, 0), (SLfloat)  R(0, 1), (SLfloat)  R(0, 2), (SLfloat)  t(0),
+               (SLfloat) -R(1, 0), (SLfloat) -R(1, 1), (SLfloat) -R(1, 2), (SLfloat) -t(1),
+               (SLfloat) -R(2, 0), (SLfloat) -R(2, 1), (SLfloat) -R(2, 2), (SLfloat) -t(2),
+               0, 0, 0, 1);
+    m_camera->vm(vm);
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef ARSCENEVIEW_H
+#define ARSCENEVIEW_H
+
+// SLProject includes GLEW, which has to come before any other GL header
+#include <stdafx.h>
+#include <SLSceneView.h>
+#include <SLGLBuffer.h>
+
+#include "CameraCalibration.h"
+#include "PoseFilter.h"
+#include <opencv2/core/core.hpp>
+#include <string>
+
+class SLCamera;
+class SLGLTexture;
+
+namespace ARDoor {
+
+/**
+ * Renders an SLProject scene over the camera image. The SLCamera of the view
+ * takes its projection from the camera calibration and its view matrix from
+ * the tracked pose, so the scene gets the culling, buffer objects and
+ * material handling of SLSceneView. The camera frames are streamed into an
+ * SLGLTexture which is drawn as the background.
+ *
+ * The scene coordinates have their origin in the board origin, x runs along
+ * the board, y up the board and z towards the camera, all in board units.
+ *
+ * The view owns its SLScene and becomes SLScene::current, so there can only
+ * be one of them. Everything except the setters has to be called with the
+ * GL context current.
+ */
+class ARSceneView : public SLSceneView
+{
+public:
+    ARSceneView(CameraCalibration *calibration, int width, int height);
+    ~ARSceneView();
+
+    /**
+     * Replaces the scene with a 3DS model, standing upright on the board
+     * @param scale converts model units to board units
+     * @return false if the file does not exist
+     */
+    bool loadModel(const std::string& path, float scale = 1.0f);
+
+    /**
+     * Replaces the scene with the given scene graph in scene coordinates, takes ownership
+     */
+    void setScene(SLGroup *scene);
+
+    /**
+     * Sets the frame drawn as background, uploaded by the next paint. The frame
+     * is referenced and not copied, it has to be BGR, BGRA or GRAY.
+     */
+    void updateBackground(const cv::Mat& frame);
+
+    /**
+     * Pose of the board in the background frame, the scene is hidden while it is invalid
+     */
+    void setPose(const Pose& pose);
+
+    /**
+     * Draws the background and the scene, replaces SLSceneView::onPaint
+     * @return true if the scene is animated and has to be painted again
+     */
+    bool paint();
+
+private:
+    void drawBackground();
+    void updateCamera();
+
+    CameraCalibration *m_calibration;
+    SLScene           *m_scene;
+    SLCamera          *m_camera;
+
+    // camera frame, streamed into the texture when it has changed
+    cv::Mat            m_frame;
+    bool               m_isFrameChanged;
+    SLGLTexture       *m_background;
+    SLGLBuffer         m_quadPositions;
+    SLGLBuffer         m_quadTexCoords;
+    SLGLBuffer         m_quadIndices;
+
+    Pose               m_pose;
+    SLfloat            m_lastPaintTime;
+};
+
+}
+
+#endif // ARSCENEVIEW_H
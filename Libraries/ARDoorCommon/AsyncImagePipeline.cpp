@@ -0,0 +1,192 @@
+#include "AsyncImagePipeline.h"
+#include <chrono>
+
+namespace ARDoor {
+
+// spin briefly before putting an idle thread to sleep
+static void waitForWork(unsigned int attempt)
+{
+    if (attempt < 16)
+    {
+        std::this_thread::yield();
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+AsyncImagePipeline::AsyncImagePipeline(const CameraCalibration &calibration, size_t queueCapacity, BackpressurePolicy policy)
+    : ImagePipeline(calibration), queueCapacity(queueCapacity), policy(policy), running(false), droppedFrames(0)
+{
+}
+
+AsyncImagePipeline::~AsyncImagePipeline()
+{
+    stop();
+}
+
+void AsyncImagePipeline::setFrameCallback(const FrameCallback &callback)
+{
+    this->callback = callback;
+}
+
+void AsyncImagePipeline::start()
+{
+    if (running)
+    {
+        return;
+    }
+
+    activeStages = stages;
+    droppedFrames = 0;
+    running = true;
+
+    for (size_t i = 0; i < activeStages.size(); ++i)
+    {
+        queues.push_back(new FrameQueue(queueCapacity));
+    }
+
+    for (size_t i = 0; i < activeStages.size(); ++i)
+    {
+        workers.push_back(std::thread(&AsyncImagePipeline::runStage, this, i));
+    }
+}
+
+void AsyncImagePipeline::stop()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    running = false;
+
+    for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+    {
+        it->join();
+    }
+    workers.clear();
+
+    for (std::vector<FrameQueue*>::iterator it = queues.begin(); it != queues.end(); ++it)
+    {
+        delete *it;
+    }
+    queues.clear();
+}
+
+bool AsyncImagePipeline::isRunning() const
+{
+    return running;
+}
+
+bool AsyncImagePipeline::pushFrame(const cv::Mat &frame)
+{
+    if (!running)
+    {
+        return false;
+    }
+
+    if (activeStages.empty())
+    {
+        if (callback)
+        {
+            callback(frame);
+        }
+        return true;
+    }
+
+    return enqueue(queues.front(), frame);
+}
+
+unsigned long AsyncImagePipeline::getDroppedFrames() const
+{
+    return droppedFrames;
+}
+
+bool AsyncImagePipeline::enqueue(FrameQueue *queue, const cv::Mat &frame)
+{
+    unsigned int attempt = 0;
+
+    while (!queue->tryPush(frame))
+    {
+        if (!running)
+        {
+            return false;
+        }
+
+        if (policy == DROP_OLDEST)
+        {
+            cv::Mat dropped;
+            if (queue->tryPop(dropped))
+            {
+                ++droppedFrames;
+            }
+        }
+        else
+        {
+            waitForWork(attempt++);
+        }
+    }
+
+    return true;
+}
+
+void AsyncImagePipeline::runStage(size_t index)
+{
+    ImageProcessor* processor = activeStages[index];
+    FrameQueue* input = queues[index];
+    FrameQueue* output = index + 1 < queues.size() ? queues[index + 1] : NULL;
+
+    cv::Mat frame;
+    cv::Mat result;
+    unsigned int attempt = 0;
+
+    while (running)
+    {
+        if (!input->tryPop(frame))
+        {
+            waitForWork(attempt++);
+            continue;
+        }
+        attempt = 0;
+
+        if (processor->isInPlace())
+        {
+            runProcessor(index, processor, frame, frame);
+            result = frame;
+        }
+        else
+        {
+            // the last result may still be used further down the pipeline,
+            // its memory is only reused once everybody else has released it,
+            // the count is read atomically since other threads release concurrently
+            if (result.refcount != NULL && CV_XADD(result.refcount, 0) > 1)
+            {
+                result.release();
+            }
+            runProcessor(index, processor, frame, result);
+        }
+        frame.release();
+
+        if (output != NULL)
+        {
+            enqueue(output, result);
+        }
+        else
+        {
+            if (callback)
+            {
+                callback(result);
+            }
+            finishFrame();
+        }
+
+        if (processor->isInPlace())
+        {
+            result.release();
+        }
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+#ifndef ASYNCIMAGEPIPELINE_H
+#define ASYNCIMAGEPIPELINE_H
+
+#include "ImagePipeline.h"
+#include "BoundedQueue.h"
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace ARDoor {
+
+/**
+ * Runs every configured stage on its own worker thread. Stages are joined
+ * by bounded queues, so the thread delivering camera frames only has to
+ * hand them over and a slow stage no longer stalls capture.
+ */
+class AsyncImagePipeline : public ImagePipeline
+{
+public:
+    enum BackpressurePolicy
+    {
+        // a full queue discards its oldest frame to make room for the new one
+        DROP_OLDEST,
+        // the producing thread waits until the queue has room again
+        BLOCK
+    };
+
+    typedef std::function<void(const cv::Mat&)> FrameCallback;
+
+    AsyncImagePipeline(const CameraCalibration& calibration, size_t queueCapacity = 4, BackpressurePolicy policy = DROP_OLDEST);
+    ~AsyncImagePipeline();
+
+    /**
+     * Sets the function receiving the output of the last stage. It is
+     * called on the worker thread of the last stage.
+     */
+    void setFrameCallback(const FrameCallback& callback);
+
+    /**
+     * Starts one worker per configured stage. Configuration changes only
+     * take effect after the pipeline has been restarted.
+     */
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * Queues a frame for the first stage. The pipeline takes over the frame
+     * data, callers which reuse their buffer have to pass a clone.
+     * @return false if the frame could not be queued
+     */
+    bool pushFrame(const cv::Mat& frame);
+
+    /**
+     * @return number of frames discarded by the DROP_OLDEST policy since start()
+     */
+    unsigned long getDroppedFrames() const;
+
+private:
+    typedef BoundedQueue<cv::Mat> FrameQueue;
+
+    void runStage(size_t index);
+    bool enqueue(FrameQueue* queue, const cv::Mat& frame);
+
+    size_t queueCapacity;
+    BackpressurePolicy policy;
+    FrameCallback callback;
+
+    // snapshot of the stages taken by start()
+    StageList activeStages;
+    // queues[i] feeds stage i
+    std::vector<FrameQueue*> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+    std::atomic<unsigned long> droppedFrames;
+};
+
+}
+
+#endif // ASYNCIMAGEPIPELINE_H
@@ -0,0 +1,185 @@
+#include "BackgroundStream.h"
+#include <cstring>
+
+#if defined(ANDROID) || defined(__ANDROID__)
+    #include <GLES/gl.h>
+    #include <GLES/glext.h>
+    // OpenGL ES 1.x knows no BGR, 3 channel frames have to be delivered as RGB
+    #define GL_BGR GL_RGB
+    #define GL_BGRA GL_BGRA_EXT
+    #define OPENGL_ES
+#elif defined(__APPLE__) || defined(MACOSX)
+    #include <OpenGL/gl.h>
+#else
+    #define GL_GLEXT_PROTOTYPES
+    #include <GL/gl.h>
+    #include <GL/glext.h>
+#endif
+
+// pixel buffer objects are part of OpenGL 2.1, but not of OpenGL ES 1.x
+#ifdef GL_PIXEL_UNPACK_BUFFER
+    #define HAS_PIXEL_BUFFERS
+#endif
+
+namespace ARDoor {
+
+#ifdef OPENGL_ES
+static int nextPowerOfTwo(int value)
+{
+    int power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+#endif
+
+BackgroundStream::BackgroundStream(unsigned int bufferCount)
+{
+    m_textureId = 0;
+    m_bufferCount = bufferCount;
+    m_nextBuffer = 0;
+    m_frameType = -1;
+    m_format = 0;
+}
+
+void BackgroundStream::upload(const cv::Mat& frame, ChannelOrder order)
+{
+    if (frame.empty() || frame.depth() != CV_8U) {
+        return;
+    }
+
+    GLenum format, internalFormat;
+    switch (frame.channels()) {
+    case 1:
+        format = GL_LUMINANCE;
+        internalFormat = GL_LUMINANCE;
+        break;
+    case 3:
+        format = order == BGR ? GL_BGR : GL_RGB;
+        internalFormat = GL_RGB;
+        break;
+    case 4:
+        format = order == BGR ? GL_BGRA : GL_RGBA;
+        internalFormat = GL_RGBA;
+        break;
+    default:
+        return;
+    }
+
+    if (m_textureId == 0 || frame.size() != m_frameSize || frame.type() != m_frameType || format != m_format) {
+        allocate(frame, format, internalFormat);
+    }
+
+    // rows of the frame are tightly packed, so the alignment follows from the row length
+    size_t rowSize = frame.cols * frame.elemSize();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, rowSize % 4 == 0 ? 4 : (rowSize % 2 == 0 ? 2 : 1));
+    glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+#ifdef HAS_PIXEL_BUFFERS
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffers[m_nextBuffer]);
+
+    // orphans the storage, a transfer still reading from it keeps the old one
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, rowSize * frame.rows, NULL, GL_STREAM_DRAW);
+    unsigned char *buffer = static_cast<unsigned char*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+
+    if (buffer != NULL) {
+        if (frame.isContinuous()) {
+            memcpy(buffer, frame.data, rowSize * frame.rows);
+        } else {
+            for (int y = 0; y < frame.rows; y++) {
+                memcpy(buffer + y * rowSize, frame.ptr(y), rowSize);
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // returns immediately, the data is taken from the bound buffer
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.cols, frame.rows, format, GL_UNSIGNED_BYTE, 0);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_nextBuffer = (m_nextBuffer + 1) % m_pixelBuffers.size();
+#else
+    if (frame.isContinuous()) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.cols, frame.rows, format, GL_UNSIGNED_BYTE, frame.data);
+    } else {
+        for (int y = 0; y < frame.rows; y++) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, frame.cols, 1, format, GL_UNSIGNED_BYTE, frame.ptr(y));
+        }
+    }
+#endif
+}
+
+unsigned int BackgroundStream::getTextureId() const
+{
+    return m_textureId;
+}
+
+cv::Size BackgroundStream::getFrameSize() const
+{
+    return m_frameSize;
+}
+
+cv::Point2f BackgroundStream::getTextureScale() const
+{
+    if (m_storageSize.area() == 0) {
+        return cv::Point2f(1, 1);
+    }
+
+    return cv::Point2f((float) m_frameSize.width / m_storageSize.width, (float) m_frameSize.height / m_storageSize.height);
+}
+
+void BackgroundStream::release()
+{
+#ifdef HAS_PIXEL_BUFFERS
+    if (!m_pixelBuffers.empty()) {
+        glDeleteBuffers(m_pixelBuffers.size(), &m_pixelBuffers[0]);
+    }
+#endif
+    m_pixelBuffers.clear();
+
+    if (m_textureId != 0) {
+        glDeleteTextures(1, &m_textureId);
+        m_textureId = 0;
+    }
+
+    m_frameSize = cv::Size();
+    m_storageSize = cv::Size();
+    m_frameType = -1;
+}
+
+void BackgroundStream::allocate(const cv::Mat& frame, unsigned int format, unsigned int internalFormat)
+{
+    release();
+
+    m_frameSize = frame.size();
+    m_frameType = frame.type();
+    m_format = format;
+
+#ifdef OPENGL_ES
+    // textures of arbitrary size and format conversions are not supported
+    m_storageSize = cv::Size(nextPowerOfTwo(frame.cols), nextPowerOfTwo(frame.rows));
+    internalFormat = format;
+#else
+    m_storageSize = m_frameSize;
+#endif
+
+    glGenTextures(1, &m_textureId);
+    glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // storage only, the frames are written into it by upload()
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_storageSize.width, m_storageSize.height, 0, format, GL_UNSIGNED_BYTE, NULL);
+
+#ifdef HAS_PIXEL_BUFFERS
+    m_pixelBuffers.resize(std::max(m_bufferCount, 1u));
+    glGenBuffers(m_pixelBuffers.size(), &m_pixelBuffers[0]);
+    m_nextBuffer = 0;
+#endif
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef BACKGROUNDSTREAM_H
+#define BACKGROUNDSTREAM_H
+
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+namespace ARDoor {
+
+/**
+ * Streams camera frames into a texture for drawing the background. The
+ * texture storage is allocated once and every frame is uploaded in its
+ * native format with glTexSubImage2D. Where pixel buffer objects are
+ * available the frames pass through a ring of them, so the transfer to
+ * the texture runs asynchronously and the driver does not have to wait
+ * for the previous upload to finish.
+ *
+ * All methods have to be called with the GL context current.
+ */
+class BackgroundStream
+{
+public:
+    enum ChannelOrder
+    {
+        // OpenCV's default, BGR or BGRA
+        BGR,
+        // RGB or RGBA, as delivered by the Android camera
+        RGB
+    };
+
+    BackgroundStream(unsigned int bufferCount = 3);
+
+    /**
+     * Copies the frame into the texture, storage is only reallocated if
+     * the size or the format of the frames change.
+     * @param frame 1, 3 or 4 channels of 8 bit
+     */
+    void upload(const cv::Mat& frame, ChannelOrder order = BGR);
+
+    unsigned int getTextureId() const;
+
+    /**
+     * @return size of the last uploaded frame
+     */
+    cv::Size getFrameSize() const;
+
+    /**
+     * @return part of the texture covered by the frame, less than 1 if the
+     *         storage had to be rounded up to a power of two
+     */
+    cv::Point2f getTextureScale() const;
+
+    /**
+     * Deletes the texture and the pixel buffers
+     */
+    void release();
+
+private:
+    void allocate(const cv::Mat& frame, unsigned int format, unsigned int internalFormat);
+
+    unsigned int       m_textureId;
+    std::vector<unsigned int> m_pixelBuffers;
+    unsigned int       m_bufferCount;
+    unsigned int       m_nextBuffer;
+
+    cv::Size           m_frameSize;
+    cv::Size           m_storageSize;
+    int                m_frameType;
+    unsigned int       m_format;
+};
+
+}
+
+#endif // BACKGROUNDSTREAM_H
@@ -0,0 +1,150 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+namespace ARDoor {
+
+/**
+ * Fixed size lock-free ring buffer connecting two threads.
+ *
+ * Every slot carries a sequence number telling whether it is ready to be
+ * written or read, so a slot is only touched by the thread which claimed
+ * it. Besides the consumer, this also allows the producer to pop the
+ * oldest element when it wants to make room for a newer one.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+    /**
+     * @param capacity number of slots, must be a power of two
+     */
+    BoundedQueue(size_t capacity)
+        : cells(new Cell[capacity]), mask(capacity - 1), enqueuePos(0), dequeuePos(0)
+    {
+        assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedQueue()
+    {
+        delete[] cells;
+    }
+
+    /**
+     * @return false if the queue is full
+     */
+    bool tryPush(const T& value)
+    {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t) sequence - (ptrdiff_t) pos;
+
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @return false if the queue is empty
+     */
+    bool tryPop(T& value)
+    {
+        Cell* cell;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = (ptrdiff_t) sequence - (ptrdiff_t) (pos + 1);
+
+            if (diff == 0)
+            {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->value;
+        // don't keep the element alive until the slot gets overwritten
+        cell->value = T();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Removes all elements, must only be called while no other thread uses the queue.
+     */
+    void clear()
+    {
+        T value;
+        while (tryPop(value)) {}
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // keep the two positions on separate cache lines
+    enum { CACHE_LINE_SIZE = 64 };
+
+    Cell* const cells;
+    const size_t mask;
+    char padding0[CACHE_LINE_SIZE];
+    std::atomic<size_t> enqueuePos;
+    char padding1[CACHE_LINE_SIZE];
+    std::atomic<size_t> dequeuePos;
+    char padding2[CACHE_LINE_SIZE];
+
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+};
+
+}
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,394 @@
+
+#include "CalibrationStore.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+#ifdef _WIN32
+    #include <iterator>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace ARDoor
+{
+    /*
+     * File layout, all values in host byte order:
+     *   FileHeader
+     *   ProfileEntry[profileCount]
+     *   map data, every block aligned to DATA_ALIGNMENT bytes
+     */
+    static const char MAGIC[8] = { 'A', 'R', 'D', 'C', 'A', 'L', 'I', 'B' };
+    static const uint32_t VERSION = 1;
+    static const uint64_t DATA_ALIGNMENT = 64;
+    static const int MAX_DEVICE_NAME = 64;
+    static const int MAX_DISTORTION_COEFFS = 8;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t profileCount;
+    };
+
+    struct MapEntry
+    {
+        int32_t type;
+        int32_t rows;
+        int32_t cols;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct ProfileEntry
+    {
+        char device[MAX_DEVICE_NAME];
+        int32_t width;
+        int32_t height;
+        double intrinsics[9];
+        double distortion[MAX_DISTORTION_COEFFS];
+        int32_t distortionCount;
+        uint32_t reserved;
+        MapEntry maps[2];
+    };
+
+    static uint64_t alignOffset(uint64_t offset)
+    {
+        return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+
+    /**
+     * Checks a map entry against the resolution of its profile and the file size. Maps
+     * cropped to the valid region are smaller than the resolution. Fixed point maps are
+     * stored as CV_16SC2 and CV_16UC1, float maps as two CV_32FC1.
+     */
+    static bool isValidMap(const MapEntry &map, int index, cv::Size resolution, uint64_t fileSize)
+    {
+        if (map.size == 0)
+        {
+            return true;
+        }
+
+        bool validType = index == 0 ? (map.type == CV_16SC2 || map.type == CV_32FC1) : (map.type == CV_16UC1 || map.type == CV_32FC1);
+        if (!validType || map.rows <= 0 || map.cols <= 0 || map.rows > resolution.height || map.cols > resolution.width)
+        {
+            return false;
+        }
+
+        uint64_t expectedSize = (uint64_t) map.rows * map.cols * CV_ELEM_SIZE(map.type);
+        return map.size == expectedSize && map.offset <= fileSize && map.size <= fileSize - map.offset;
+    }
+
+    static bool isValidEntry(const ProfileEntry &entry, uint64_t fileSize)
+    {
+        // OpenCV estimates 4, 5 or 8 distortion coefficients
+        if (entry.width <= 0 || entry.height <= 0 ||
+            (entry.distortionCount != 4 && entry.distortionCount != 5 && entry.distortionCount != 8))
+        {
+            return false;
+        }
+
+        const MapEntry &map1 = entry.maps[0];
+        const MapEntry &map2 = entry.maps[1];
+        if (map1.size != 0 && map2.size != 0 && (map1.rows != map2.rows || map1.cols != map2.cols))
+        {
+            return false;
+        }
+
+        cv::Size resolution(entry.width, entry.height);
+        return isValidMap(entry.maps[0], 0, resolution, fileSize) && isValidMap(entry.maps[1], 1, resolution, fileSize);
+    }
+
+    CalibrationStore::CalibrationStore(const std::string &path)
+    {
+        this->path = path;
+        mappedData = NULL;
+        mappedSize = 0;
+    }
+
+    CalibrationStore::~CalibrationStore()
+    {
+        unmap();
+    }
+
+    bool CalibrationStore::load()
+    {
+        profiles.clear();
+        unmap();
+
+#ifdef _WIN32
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        fileBuffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        mappedData = fileBuffer.empty() ? NULL : &fileBuffer[0];
+        mappedSize = fileBuffer.size();
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+
+        mappedData = (const char*) data;
+        mappedSize = info.st_size;
+#endif
+
+        const FileHeader *header = (const FileHeader*) mappedData;
+        if (mappedSize < sizeof(FileHeader) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION
+            || (mappedSize - sizeof(FileHeader)) / sizeof(ProfileEntry) < header->profileCount)
+        {
+            std::cerr << "Invalid calibration store " << path << std::endl;
+            unmap();
+            return false;
+        }
+
+        const ProfileEntry *entries = (const ProfileEntry*) (mappedData + sizeof(FileHeader));
+
+        for (uint32_t i = 0; i < header->profileCount; i++)
+        {
+            const ProfileEntry &entry = entries[i];
+            Profile profile;
+
+            profile.device = std::string(entry.device, strnlen(entry.device, MAX_DEVICE_NAME));
+
+            // a truncated or stale file must not lead to reads outside of the mapping
+            if (!isValidEntry(entry, mappedSize))
+            {
+                std::cerr << "Skipping invalid calibration profile " << profile.device << " in " << path << std::endl;
+                continue;
+            }
+
+            profile.resolution = cv::Size(entry.width, entry.height);
+            profile.intrinsics = cv::Mat(3, 3, CV_64F, (void*) entry.intrinsics).clone();
+            profile.distortion = cv::Mat(1, entry.distortionCount, CV_64F, (void*) entry.distortion).clone();
+
+            cv::Mat *maps[2] = { &profile.map1, &profile.map2 };
+            for (int m = 0; m < 2; m++)
+            {
+                const MapEntry &map = entry.maps[m];
+                if (map.size == 0)
+                {
+                    continue;
+                }
+
+                // the mapping is read only and gone after the load, so the profile gets its own copy
+                *maps[m] = cv::Mat(map.rows, map.cols, map.type, (void*) (mappedData + map.offset)).clone();
+            }
+
+            profiles.push_back(profile);
+        }
+
+        unmap();
+        return true;
+    }
+
+    bool CalibrationStore::save() const
+    {
+        FileHeader header;
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.profileCount = (uint32_t) profiles.size();
+
+        std::vector<ProfileEntry> entries(profiles.size());
+        std::vector<cv::Mat> blocks;
+        uint64_t offset = sizeof(FileHeader) + profiles.size() * sizeof(ProfileEntry);
+
+        for (size_t i = 0; i < profiles.size(); i++)
+        {
+            const Profile &profile = profiles[i];
+            ProfileEntry &entry = entries[i];
+
+            memset(&entry, 0, sizeof(ProfileEntry));
+            strncpy(entry.device, profile.device.c_str(), MAX_DEVICE_NAME - 1);
+            entry.width = profile.resolution.width;
+            entry.height = profile.resolution.height;
+
+            cv::Mat intrinsics, distortion;
+            profile.intrinsics.convertTo(intrinsics, CV_64F);
+            profile.distortion.convertTo(distortion, CV_64F);
+
+            for (int j = 0; j < 9; j++)
+            {
+                entry.intrinsics[j] = intrinsics.at<double>(j / 3, j % 3);
+            }
+
+            entry.distortionCount = std::min((int) distortion.total(), MAX_DISTORTION_COEFFS);
+            for (int j = 0; j < entry.distortionCount; j++)
+            {
+                entry.distortion[j] = ((const double*) distortion.data)[j];
+            }
+
+            const cv::Mat *maps[2] = { &profile.map1, &profile.map2 };
+            for (int m = 0; m < 2; m++)
+            {
+                if (maps[m]->empty())
+                {
+                    continue;
+                }
+
+                cv::Mat block = maps[m]->isContinuous() ? *maps[m] : maps[m]->clone();
+                offset = alignOffset(offset);
+
+                entry.maps[m].type = block.type();
+                entry.maps[m].rows = block.rows;
+                entry.maps[m].cols = block.cols;
+                entry.maps[m].offset = offset;
+                entry.maps[m].size = block.total() * block.elemSize();
+
+                offset += entry.maps[m].size;
+                blocks.push_back(block);
+            }
+        }
+
+        // write next to the store and replace it afterwards, so a failed write keeps the old file
+        std::string temporaryPath = path + ".tmp";
+        std::ofstream file(temporaryPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            return false;
+        }
+
+        file.write((const char*) &header, sizeof(FileHeader));
+        if (!entries.empty())
+        {
+            file.write((const char*) &entries[0], entries.size() * sizeof(ProfileEntry));
+        }
+
+        const char padding[DATA_ALIGNMENT] = { 0 };
+        for (size_t i = 0; i < blocks.size(); i++)
+        {
+            uint64_t position = (uint64_t) file.tellp();
+            file.write(padding, alignOffset(position) - position);
+            file.write((const char*) blocks[i].data, blocks[i].total() * blocks[i].elemSize());
+        }
+
+        file.close();
+        if (!file)
+        {
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+
+        return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+
+    void CalibrationStore::put(const std::string &device, cv::Size resolution, CameraCalibration &calibration)
+    {
+        Profile profile;
+        profile.device = device;
+        profile.resolution = resolution;
+        profile.intrinsics = calibration.getIntrinsicsMatrix().clone();
+        profile.distortion = calibration.getDistortionCoeffs().clone();
+        calibration.getUndistortMaps(resolution, profile.map1, profile.map2);
+
+        for (std::vector<Profile>::iterator it = profiles.begin(); it != profiles.end(); ++it)
+        {
+            if (it->device == device && it->resolution == resolution)
+            {
+                *it = profile;
+                return;
+            }
+        }
+
+        profiles.push_back(profile);
+    }
+
+    bool CalibrationStore::apply(const std::string &device, cv::Size resolution, CameraCalibration &calibration) const
+    {
+        const Profile *profile = find(device, resolution);
+        if (profile == NULL)
+        {
+            return false;
+        }
+
+        // the rest of the application works with float matrices
+        cv::Mat intrinsics, distortion;
+        profile->intrinsics.convertTo(intrinsics, CV_32F);
+        profile->distortion.convertTo(distortion, CV_32F);
+
+        calibration.setIntrinsicsMatrix(intrinsics);
+        calibration.setDistortionCoeffs(distortion);
+
+        if (!profile->map1.empty() && !profile->map2.empty())
+        {
+            calibration.setUndistortMaps(resolution, profile->map1, profile->map2);
+        }
+
+        return true;
+    }
+
+    bool CalibrationStore::contains(const std::string &device, cv::Size resolution) const
+    {
+        return find(device, resolution) != NULL;
+    }
+
+    std::vector<cv::Size> CalibrationStore::getResolutions(const std::string &device) const
+    {
+        std::vector<cv::Size> resolutions;
+
+        for (std::vector<Profile>::const_iterator it = profiles.begin(); it != profiles.end(); ++it)
+        {
+            if (it->device == device)
+            {
+                resolutions.push_back(it->resolution);
+            }
+        }
+
+        return resolutions;
+    }
+
+    const CalibrationStore::Profile* CalibrationStore::find(const std::string &device, cv::Size resolution) const
+    {
+        for (std::vector<Profile>::const_iterator it = profiles.begin(); it != profiles.end(); ++it)
+        {
+            if (it->device == device && it->resolution == resolution)
+            {
+                return &(*it);
+            }
+        }
+
+        return NULL;
+    }
+
+    void CalibrationStore::unmap()
+    {
+#ifndef _WIN32
+        if (mappedData != NULL)
+        {
+            munmap((void*) mappedData, mappedSize);
+        }
+#endif
+
+        fileBuffer.clear();
+        mappedData = NULL;
+        mappedSize = 0;
+    }
+}
@@ -0,0 +1,87 @@
+
+#ifndef __ARDoor__CalibrationStore__
+#define __ARDoor__CalibrationStore__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "CameraCalibration.h"
+
+namespace ARDoor
+{
+    /**
+     * Binary file holding the calibration of several cameras. Every profile
+     * is identified by a device name and a resolution and contains the
+     * intrinsics, the distortion coefficients and the undistortion maps for
+     * that resolution.
+     *
+     * The file is memory mapped while it is loaded. The profiles own copies
+     * of their matrices, so calibrations keep working after the store is
+     * reloaded or destroyed.
+     */
+    class CalibrationStore
+    {
+    public:
+        struct Profile
+        {
+            std::string device;
+            cv::Size resolution;
+            cv::Mat intrinsics;
+            cv::Mat distortion;
+            cv::Mat map1;
+            cv::Mat map2;
+        };
+
+        CalibrationStore(const std::string &path);
+        ~CalibrationStore();
+
+        /**
+         * Maps the store file into memory, replaces all profiles in the store
+         * @return false if the file does not exist or is invalid
+         */
+        bool load();
+
+        /**
+         * Writes all profiles to the store file
+         * @return true on success
+         */
+        bool save() const;
+
+        /**
+         * Adds or replaces the profile for the given camera. The undistortion
+         * maps are computed by the calibration.
+         */
+        void put(const std::string &device, cv::Size resolution, CameraCalibration &calibration);
+
+        /**
+         * Sets intrinsics, distortion and undistortion maps of the given profile
+         * @return false if there is no such profile
+         */
+        bool apply(const std::string &device, cv::Size resolution, CameraCalibration &calibration) const;
+
+        bool contains(const std::string &device, cv::Size resolution) const;
+
+        /**
+         * @return resolutions with a stored profile for the given device
+         */
+        std::vector<cv::Size> getResolutions(const std::string &device) const;
+
+    private:
+        const Profile* find(const std::string &device, cv::Size resolution) const;
+        void unmap();
+
+        std::string path;
+        std::vector<Profile> profiles;
+
+        // memory backing the profiles read from the file
+        const char *mappedData;
+        size_t mappedSize;
+        std::vector<char> fileBuffer;
+
+        CalibrationStore(const CalibrationStore&);
+        CalibrationStore& operator=(const CalibrationStore&);
+    };
+}
+
+#endif
@@ -1,11 +1,18 @@
 
 #include "CameraCalibration.h"
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace ARDoor
 {
     CameraCalibration::CameraCalibration()
     {
         mustInitUndistort = false;
+        mapCropped = false;
     }
 
     cv::Mat CameraCalibration::getIntrinsicsMatrix()
@@ -16,6 +23,7 @@ namespace ARDoor
     void CameraCalibration::setIntrinsicsMatrix(cv::Mat intrinsics)
     {
         cameraMatrix = intrinsics;
+        mustInitUndistort = true;
     }
 
     cv::Mat CameraCalibration::getDistortionCoeffs()
@@ -26,23 +34,85 @@ namespace ARDoor
     void CameraCalibration::setDistortionCoeffs(cv::Mat distortion)
     {
         distCoeffs = distortion;
+        mustInitUndistort = true;
     }
     
         
-    int CameraCalibration::addChessboardPoints(const std::vector<std::string> &filelist, cv::Size &boardSize)
+    int CameraCalibration::addChessboardPoints(const std::vector<std::string> &filelist, cv::Size &boardSize, const ProgressCallback &progress, unsigned int threadCount)
     {
-        std::vector<cv::Point2f> imageCorners;
-        std::vector<cv::Point3f> objectCorners;
+        const int total = (int) filelist.size();
         
-        cv::Mat image;
-        int successes = 0;
+        std::vector< std::vector<cv::Point2f> > imageCorners(total);
+        std::vector< std::vector<cv::Point3f> > objectCorners(total);
+        std::vector<char> found(total, 0);
+        
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threadCount = std::min(threadCount, (unsigned int) std::max(total, 1));
+        
+        std::atomic<int> nextImage(0);
+        int processed = 0;
+        std::mutex mutex;
+        std::condition_variable imageDone;
         
-        for (int i = 0; i < filelist.size(); i++)
+        // every worker loads and searches one image after the other, results are stored by index
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < threadCount; t++)
         {
-            image = cv::imread(filelist[i],0);
+            workers.push_back(std::thread([&]() {
+                int i;
+                while ((i = nextImage++) < total)
+                {
+                    cv::Mat image = cv::imread(filelist[i], 0);
+                    
+                    try
+                    {
+                        if (!image.empty())
+                        {
+                            found[i] = findChessboardPoints(image, boardSize, imageCorners[i], objectCorners[i]);
+                        }
+                    }
+                    catch (const cv::Exception &e)
+                    {
+                        // an exception must not leave the worker, the image is skipped instead
+                        std::cerr << filelist[i] << ": " << e.what() << std::endl;
+                    }
+                    
+                    std::lock_guard<std::mutex> lock(mutex);
+                    processed++;
+                    imageDone.notify_one();
+                }
+            }));
+        }
+        
+        // report progress on the calling thread so that the callback may touch the UI
+        int reported = 0;
+        while (reported < total)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            imageDone.wait(lock, [&]() { return processed > reported; });
+            reported = processed;
+            lock.unlock();
             
-            if (findChessboardPoints(image, boardSize, imageCorners, objectCorners)) {
-                addPoints(imageCorners, objectCorners);
+            if (progress)
+            {
+                progress(reported, total);
+            }
+        }
+        
+        for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+        {
+            it->join();
+        }
+        
+        int successes = 0;
+        
+        for (int i = 0; i < total; i++)
+        {
+            if (found[i]) {
+                addPoints(imageCorners[i], objectCorners[i]);
                 successes++;
             }
         }
@@ -126,28 +196,115 @@ namespace ARDoor
     cv::Mat CameraCalibration::remap(const cv::Mat &image)
     {
         cv::Mat undistorted;
+        remap(image, undistorted);
         
-        if(mustInitUndistort) { 
-            cv::initUndistortRectifyMap(
-                cameraMatrix,
-                distCoeffs,
-                cv::Mat(),
-                cv::Mat(),
-                image.size(),
-                CV_32F,
-                mapX,
-                mapY           
-            );
-            
-            printMat(cameraMatrix, "Camera Matrix");
-            printMat(distCoeffs, "Disortion Coefficients");
-            
-            mustInitUndistort= false;
+        return undistorted;
+    }
+    
+    void CameraCalibration::remap(const cv::Mat &image, cv::Mat &undistorted, bool cropToValidRegion)
+    {
+        assert(image.empty() || image.data != undistorted.data);
+        
+        if(mustInitUndistort || image.size() != mapImageSize || cropToValidRegion != mapCropped)
+        {
+            initUndistort(image.size(), cropToValidRegion);
         }
         
         cv::remap(image, undistorted, mapX, mapY, cv::INTER_LINEAR);
+    }
+    
+    cv::Rect CameraCalibration::getValidRegion(cv::Size imageSize)
+    {
+        // undistort points along the image border, the valid region lies inside all of them
+        const int samples = 16;
+        std::vector<cv::Point2f> border, undistortedBorder;
         
-        return undistorted;
+        for(int i = 0; i <= samples; i++)
+        {
+            float x = (imageSize.width - 1) * i / (float) samples;
+            float y = (imageSize.height - 1) * i / (float) samples;
+            
+            border.push_back(cv::Point2f(x, 0));
+            border.push_back(cv::Point2f(x, imageSize.height - 1));
+            border.push_back(cv::Point2f(0, y));
+            border.push_back(cv::Point2f(imageSize.width - 1, y));
+        }
+        
+        cv::undistortPoints(border, undistortedBorder, cameraMatrix, distCoeffs, cv::noArray(), cameraMatrix);
+        
+        float left = 0, top = 0;
+        float right = imageSize.width - 1, bottom = imageSize.height - 1;
+        
+        for(size_t i = 0; i < undistortedBorder.size(); i += 4)
+        {
+            top = std::max(top, undistortedBorder[i].y);
+            bottom = std::min(bottom, undistortedBorder[i + 1].y);
+            left = std::max(left, undistortedBorder[i + 2].x);
+            right = std::min(right, undistortedBorder[i + 3].x);
+        }
+        
+        cv::Rect region(cv::Point((int) std::ceil(left), (int) std::ceil(top)), cv::Point((int) std::floor(right) + 1, (int) std::floor(bottom) + 1));
+        
+        return region & cv::Rect(cv::Point(0, 0), imageSize);
+    }
+    
+    void CameraCalibration::getUndistortMaps(cv::Size imageSize, cv::Mat &map1, cv::Mat &map2)
+    {
+        if(mustInitUndistort || imageSize != mapImageSize || mapCropped)
+        {
+            initUndistort(imageSize, false);
+        }
+        
+        map1 = mapX;
+        map2 = mapY;
+    }
+    
+    void CameraCalibration::setUndistortMaps(cv::Size imageSize, const cv::Mat &map1, const cv::Mat &map2)
+    {
+        mapX = map1;
+        mapY = map2;
+        validRegion = getValidRegion(imageSize);
+        
+        mapImageSize = imageSize;
+        mapCropped = false;
+        mustInitUndistort = false;
+    }
+    
+    void CameraCalibration::initUndistort(cv::Size imageSize, bool cropToValidRegion)
+    {
+        cv::Mat newCameraMatrix;
+        cv::Size mapSize = imageSize;
+        
+        cameraMatrix.convertTo(newCameraMatrix, CV_64F);
+        validRegion = getValidRegion(imageSize);
+        
+        if(cropToValidRegion && validRegion.area() > 0)
+        {
+            // moving the principal point makes the maps start at the top left corner of the region
+            newCameraMatrix.at<double>(0, 2) -= validRegion.x;
+            newCameraMatrix.at<double>(1, 2) -= validRegion.y;
+            mapSize = validRegion.size();
+        }
+        
+        // the old maps may be shared with a store profile or a caller, so they are never overwritten
+        mapX.release();
+        mapY.release();
+        
+        // fixed point maps are half the size of float maps and let remap skip the coordinate conversion
+        cv::initUndistortRectifyMap(
+            cameraMatrix,
+            distCoeffs,
+            cv::Mat(),
+            newCameraMatrix,
+            mapSize,
+            CV_16SC2,
+            mapX,
+            mapY
+        );
+        
+        mapImageSize = imageSize;
+        mapCropped = cropToValidRegion;
+        mustInitUndistort = false;
     }
         
     void CameraCalibration::printMat(const cv::Mat &mat, std::string name)
@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <vector>
+#include <functional>
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/calib3d/calib3d.hpp>
@@ -20,11 +21,21 @@ namespace ARDoor {
         // output Matrices
         cv::Mat cameraMatrix;
         cv::Mat distCoeffs;
-        // used in image undistortion
+        // used in image undistortion, fixed point CV_16SC2 coordinates and CV_16UC1 interpolation weights
         cv::Mat mapX, mapY;
         bool mustInitUndistort;
+        // image size and mode the maps have been built for
+        cv::Size mapImageSize;
+        bool mapCropped;
+        // undistorted region which only contains valid pixels
+        cv::Rect validRegion;
         
     public:
+        /**
+         * Receives the number of processed images and the total number of images
+         */
+        typedef std::function<void(int processed, int total)> ProgressCallback;
+
         CameraCalibration();
 
         cv::Mat getIntrinsicsMatrix();
@@ -34,12 +45,15 @@ namespace ARDoor {
         void setDistortionCoeffs(cv::Mat distortion);
     
         /**
-         * Adds additional images to be used for calibration
+         * Adds additional images to be used for calibration. The images are loaded and
+         * searched on a pool of worker threads, the points are added in file list order.
          * @param fileList list of files to be loaded
          * @param boardSize number of rows and columns on the board
+         * @param progress called on the calling thread whenever images have been processed
+         * @param threadCount number of worker threads, 0 uses one per core
          * @return number of successfuly detected chess boards
          */
-        int addChessboardPoints(const std::vector<std::string> &filelist, cv::Size &boardSize);
+        int addChessboardPoints(const std::vector<std::string> &filelist, cv::Size &boardSize, const ProgressCallback &progress = ProgressCallback(), unsigned int threadCount = 0);
         
         /**
          * Adds points to be used for calibration
@@ -74,7 +88,40 @@ namespace ARDoor {
          */
         cv::Mat remap(const cv::Mat &image);
         
+        /**
+         * Removes disortion from the given image. The undistortion maps are built once and
+         * rebuilt automatically when the image size changes.
+         * @param image the distorted image
+         * @param undistorted buffer receiving the undistorted image, must not share memory with image
+         * @param cropToValidRegion only produce the region returned by getValidRegion
+         */
+        void remap(const cv::Mat &image, cv::Mat &undistorted, bool cropToValidRegion = false);
+        
+        /**
+         * @param imageSize size of the distorted image
+         * @return region of the undistorted image which is completely covered by the distorted image
+         */
+        cv::Rect getValidRegion(cv::Size imageSize);
+        
+        /**
+         * Returns the undistortion maps for the whole image, builds them if necessary
+         * @param imageSize size of the distorted image
+         * @param map1 receives the CV_16SC2 coordinates
+         * @param map2 receives the CV_16UC1 interpolation weights
+         */
+        void getUndistortMaps(cv::Size imageSize, cv::Mat &map1, cv::Mat &map2);
+        
+        /**
+         * Uses precomputed undistortion maps instead of building them on the first remap.
+         * Has to be called after the intrinsics and distortion coefficients have been set.
+         * @param imageSize size of the distorted image the maps were built for
+         * @param map1 CV_16SC2 coordinates
+         * @param map2 CV_16UC1 interpolation weights
+         */
+        void setUndistortMaps(cv::Size imageSize, const cv::Mat &map1, const cv::Mat &map2);
+        
         private:
+            void initUndistort(cv::Size imageSize, bool cropToValidRegion);
             void printMat(const cv::Mat &mat, std::string name);
     };
     
@@ -0,0 +1,203 @@
+
+#include "ChessboardTracker.h"
+#include "ImageUtils.h"
+#include <opencv2/calib3d/calib3d.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/video/video.hpp>
+
+namespace ARDoor
+{
+    static const cv::Size FLOW_WINDOW = cv::Size(21, 21);
+    static const int FLOW_LEVELS = 3;
+    // mean distance in pixels the tracked corners may deviate from a projected chessboard
+    static const double MAX_GRID_ERROR = 1.5;
+    // frames after which the last position is no longer used to predict the search region
+    static const int MAX_LOST_FRAMES = 10;
+
+    ChessboardTracker::ChessboardTracker(cv::Size boardSize)
+    {
+        this->boardSize = boardSize;
+
+        for(int i = 0; i < boardSize.height; i++)
+        {
+            for(int j = 0; j < boardSize.width; j++)
+            {
+                boardGrid.push_back(cv::Point2f(j, i));
+            }
+        }
+
+        reset();
+    }
+
+    bool ChessboardTracker::track(const cv::Mat &frame, std::vector<cv::Point2f> &corners)
+    {
+        ImageUtils::convertToGray(frame, gray);
+        if (gray.data == frame.data)
+        {
+            // the pyramid of this frame is kept, it must not change with the caller's buffer
+            gray = frame.clone();
+        }
+
+        bool wasTracking = tracking;
+        if (wasTracking)
+        {
+            cv::buildOpticalFlowPyramid(gray, pyramid, FLOW_WINDOW, FLOW_LEVELS);
+        }
+
+        bool found = wasTracking && followCorners(corners);
+
+        if (!found && !previousCorners.empty())
+        {
+            found = detect(predictSearchRegion(), corners);
+        }
+
+        if (!found)
+        {
+            found = detect(cv::Rect(0, 0, gray.cols, gray.rows), corners);
+        }
+
+        if (found)
+        {
+            if (!previousCorners.empty())
+            {
+                cv::Point2f center = (corners.front() + corners.back()) * 0.5f;
+                cv::Point2f previousCenter = (previousCorners.front() + previousCorners.back()) * 0.5f;
+                motion = center - previousCenter;
+            }
+
+            previousCorners = corners;
+            if (!wasTracking)
+            {
+                cv::buildOpticalFlowPyramid(gray, pyramid, FLOW_WINDOW, FLOW_LEVELS);
+            }
+            std::swap(pyramid, previousPyramid);
+            lostFrames = 0;
+        }
+        else if (++lostFrames > MAX_LOST_FRAMES)
+        {
+            reset();
+        }
+
+        tracking = found;
+
+        return found;
+    }
+
+    void ChessboardTracker::reset()
+    {
+        previousCorners.clear();
+        previousPyramid.clear();
+        motion = cv::Point2f(0, 0);
+        tracking = false;
+        lostFrames = 0;
+    }
+
+    bool ChessboardTracker::isTracking() const
+    {
+        return tracking;
+    }
+
+    bool ChessboardTracker::followCorners(std::vector<cv::Point2f> &corners)
+    {
+        std::vector<uchar> status;
+        std::vector<float> error;
+
+        cv::calcOpticalFlowPyrLK(previousPyramid, pyramid, previousCorners, corners, status, error, FLOW_WINDOW, FLOW_LEVELS);
+
+        for (size_t i = 0; i < corners.size(); i++)
+        {
+            const cv::Point2f &corner = corners[i];
+            if (!status[i] || corner.x < 0 || corner.y < 0 || corner.x > gray.cols - 1 || corner.y > gray.rows - 1)
+            {
+                return false;
+            }
+        }
+
+        refineCorners(corners);
+
+        return isBoardShaped(corners);
+    }
+
+    bool ChessboardTracker::detect(const cv::Rect &region, std::vector<cv::Point2f> &corners)
+    {
+        if (region.area() == 0)
+        {
+            return false;
+        }
+
+        bool found = cv::findChessboardCorners(
+            gray(region),
+            boardSize,
+            corners,
+            CV_CALIB_CB_ADAPTIVE_THRESH | CV_CALIB_CB_FILTER_QUADS | CV_CALIB_CB_FAST_CHECK
+        );
+
+        if (!found)
+        {
+            return false;
+        }
+
+        cv::Point2f offset(region.x, region.y);
+        for (size_t i = 0; i < corners.size(); i++)
+        {
+            corners[i] += offset;
+        }
+
+        refineCorners(corners);
+
+        return true;
+    }
+
+    bool ChessboardTracker::isBoardShaped(const std::vector<cv::Point2f> &corners) const
+    {
+        // the corners of a planar board are related to the ideal grid by a homography
+        cv::Mat homography = cv::findHomography(boardGrid, corners, 0);
+        if (homography.empty())
+        {
+            return false;
+        }
+
+        std::vector<cv::Point2f> projected;
+        cv::perspectiveTransform(boardGrid, projected, homography);
+
+        double error = 0;
+        for (size_t i = 0; i < corners.size(); i++)
+        {
+            cv::Point2f difference = projected[i] - corners[i];
+            error += std::sqrt(difference.dot(difference));
+        }
+
+        return error / corners.size() < MAX_GRID_ERROR;
+    }
+
+    void ChessboardTracker::refineCorners(std::vector<cv::Point2f> &corners) const
+    {
+        cv::cornerSubPix(
+            gray,
+            corners,
+            cv::Size(5,5),
+            cv::Size(-1,-1),
+            cv::TermCriteria(
+                cv::TermCriteria::MAX_ITER + cv::TermCriteria::EPS,
+                30,  // max number of iterations
+                0.1  // min accuracy
+            )
+        );
+    }
+
+    cv::Rect ChessboardTracker::predictSearchRegion() const
+    {
+        cv::Rect bounds = cv::boundingRect(previousCorners);
+
+        // expect the board where it would be if it kept moving, leave room for a border of squares
+        bounds.x += cvRound(motion.x);
+        bounds.y += cvRound(motion.y);
+
+        int marginX = bounds.width / 2 + std::abs(cvRound(motion.x));
+        int marginY = bounds.height / 2 + std::abs(cvRound(motion.y));
+
+        cv::Rect region(bounds.x - marginX, bounds.y - marginY, bounds.width + 2 * marginX, bounds.height + 2 * marginY);
+
+        return region & cv::Rect(0, 0, gray.cols, gray.rows);
+    }
+}
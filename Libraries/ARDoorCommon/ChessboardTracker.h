@@ -0,0 +1,58 @@
+
+#ifndef __ARDoor__ChessboardTracker__
+#define __ARDoor__ChessboardTracker__
+
+#include <iostream>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace ARDoor
+{
+    /**
+     * Finds a chessboard in consecutive frames. Once the board has been
+     * detected its corners are followed with pyramidal Lucas-Kanade optical
+     * flow, the full detection only runs again when tracking fails. It then
+     * searches the region predicted from the last known position first.
+     */
+    class ChessboardTracker
+    {
+    public:
+        ChessboardTracker(cv::Size boardSize);
+
+        /**
+         * @param frame the current camera frame, BGR, BGRA or GRAY
+         * @param corners receives the refined corner positions
+         * @return true if the board has been found
+         */
+        bool track(const cv::Mat &frame, std::vector<cv::Point2f> &corners);
+
+        /**
+         * Forgets the last position, the next frame is searched completely.
+         */
+        void reset();
+
+        bool isTracking() const;
+
+    private:
+        bool followCorners(std::vector<cv::Point2f> &corners);
+        bool detect(const cv::Rect &region, std::vector<cv::Point2f> &corners);
+        bool isBoardShaped(const std::vector<cv::Point2f> &corners) const;
+        void refineCorners(std::vector<cv::Point2f> &corners) const;
+        cv::Rect predictSearchRegion() const;
+
+        cv::Size boardSize;
+        // ideal corner positions, used to verify the tracked corners
+        std::vector<cv::Point2f> boardGrid;
+
+        cv::Mat gray;
+        std::vector<cv::Mat> pyramid;
+        std::vector<cv::Mat> previousPyramid;
+        std::vector<cv::Point2f> previousCorners;
+        // movement of the board center between the last two detections
+        cv::Point2f motion;
+        bool tracking;
+        int lostFrames;
+    };
+}
+
+#endif
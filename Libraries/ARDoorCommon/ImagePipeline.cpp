@@ -3,35 +3,126 @@
 namespace ARDoor {
 
 ImagePipeline::ImagePipeline(const CameraCalibration &calibration)
-    : calibration(calibration)
+    : calibration(calibration), profilingEnabled(false)
 {
 }
 
 void ImagePipeline::processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame)
 {
-    cv::Mat currentInputFrame(inputFrame);
+    if (stages.empty())
+    {
+        outputFrame = inputFrame;
+        return;
+    }
 
-    for (Configuration::iterator it = configuration.begin(); it != configuration.end(); ++it)
+    // -1 means the current stage reads the caller's frame
+    int sourceBuffer = -1;
+    size_t lastStage = stages.size() - 1;
+
+    for (size_t i = 0; i < stages.size(); ++i)
     {
-        std::string processorName = *it;
-        if (processors.count(processorName) == 1)
+        ImageProcessor* processor = stages[i];
+        const cv::Mat& source = sourceBuffer < 0 ? inputFrame : buffers[sourceBuffer];
+
+        if (i == lastStage)
+        {
+            runProcessor(i, processor, source, outputFrame);
+            break;
+        }
+
+        // the caller's frame is never written to, in place stages only reuse our own buffers
+        int targetBuffer = sourceBuffer == 0 ? 1 : 0;
+        if (sourceBuffer >= 0 && processor->isInPlace())
+        {
+            targetBuffer = sourceBuffer;
+        }
+
+        cv::Mat& target = buffers[targetBuffer];
+        runProcessor(i, processor, source, target);
+
+        if (targetBuffer != sourceBuffer && target.data == source.data)
         {
-            ImageProcessor* processor = processors.at(processorName);
-            processor->processFrame(currentInputFrame, outputFrame);
-            outputFrame.copyTo(currentInputFrame);
+            // the stage passed its input through by reference, keep reading from the
+            // original so that the two buffers never share the same memory
+            target.release();
+            continue;
         }
+
+        sourceBuffer = targetBuffer;
     }
+
+    finishFrame();
 }
 
 void ImagePipeline::registerProcessor(ImageProcessor *processor)
 {
     ProcessorMapEntry entry(processor->getName(), processor);
     processors.insert(entry);
+    updateStages();
 }
 
 void ImagePipeline::setConfiguration(const Configuration& configuration)
 {
     this->configuration = configuration;
+    updateStages();
+}
+
+void ImagePipeline::setProfilingEnabled(bool enabled)
+{
+    profilingEnabled = enabled;
+}
+
+PipelineProfiler& ImagePipeline::getProfiler()
+{
+    return profiler;
+}
+
+void ImagePipeline::runProcessor(size_t index, ImageProcessor *processor, const cv::Mat &inputFrame, cv::Mat &outputFrame)
+{
+    if (!profilingEnabled)
+    {
+        processor->processFrame(inputFrame, outputFrame);
+        return;
+    }
+
+    const uchar* previousData = outputFrame.datastart;
+    PipelineProfiler::Clock::time_point start = PipelineProfiler::Clock::now();
+
+    processor->processFrame(inputFrame, outputFrame);
+
+    double elapsed = std::chrono::duration<double, std::micro>(PipelineProfiler::Clock::now() - start).count();
+
+    // a new data block behind the output means the stage had to allocate it
+    unsigned int allocations = outputFrame.datastart != previousData && outputFrame.datastart != inputFrame.datastart ? 1 : 0;
+    size_t bytes = inputFrame.total() * inputFrame.elemSize() + outputFrame.total() * outputFrame.elemSize();
+
+    profiler.record(index, elapsed, allocations, bytes);
+}
+
+void ImagePipeline::finishFrame()
+{
+    if (profilingEnabled)
+    {
+        profiler.frameFinished();
+    }
+}
+
+void ImagePipeline::updateStages()
+{
+    std::vector<std::string> names;
+    stages.clear();
+
+    for (Configuration::iterator it = configuration.begin(); it != configuration.end(); ++it)
+    {
+        ProcessorMap::iterator processor = processors.find(*it);
+        if (processor != processors.end())
+        {
+            stages.push_back(processor->second);
+            names.push_back(processor->first);
+        }
+    }
+
+    profiler.setStages(names);
 }
 
 }
@@ -3,9 +3,12 @@
 
 #include "CameraCalibration.h"
 #include "ImageProcessor.h"
+#include "PipelineProfiler.h"
 #include <opencv2/core/core.hpp>
+#include <atomic>
 #include <list>
 #include <map>
+#include <vector>
 
 namespace ARDoor {
 
@@ -16,20 +19,49 @@ public:
     typedef std::list<std::string> Configuration;
 
     ImagePipeline(const CameraCalibration& calibration);
+    virtual ~ImagePipeline() {}
 
+    /**
+     * Runs the configured processors on the input frame. Intermediate
+     * results alternate between two buffers owned by the pipeline, the
+     * last stage writes directly into outputFrame. The input frame is
+     * never modified.
+     */
     void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
     void registerProcessor(ImageProcessor* processor);
     void setConfiguration(const Configuration& configuration);
 
+    /**
+     * Enables time, allocation and memory traffic measurements for every stage.
+     */
+    void setProfilingEnabled(bool enabled);
+    PipelineProfiler& getProfiler();
+
 protected:
+    typedef std::vector<ImageProcessor*> StageList;
+
+    void runProcessor(size_t index, ImageProcessor* processor, const cv::Mat& inputFrame, cv::Mat& outputFrame);
+    void finishFrame();
+
     const CameraCalibration& calibration;
+    // registered processors in configuration order
+    StageList stages;
 
 private:
     typedef std::map<std::string, ImageProcessor*> ProcessorMap;
     typedef ProcessorMap::value_type ProcessorMapEntry;
 
+    void updateStages();
+
     ProcessorMap processors;
     Configuration configuration;
+
+    // intermediate frames, reused across calls
+    cv::Mat buffers[2];
+
+    PipelineProfiler profiler;
+    // toggled from the UI while the pipeline threads run
+    std::atomic<bool> profilingEnabled;
 };
 
 }
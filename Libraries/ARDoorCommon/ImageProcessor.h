@@ -14,6 +14,13 @@ public:
 
     virtual std::string getName() = 0;
     virtual void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame) = 0;
+
+    /**
+     * Processors which can safely be called with inputFrame and outputFrame
+     * referring to the same image return true. The pipeline then skips
+     * switching to its second buffer for this stage.
+     */
+    virtual bool isInPlace() { return false; }
 };
 
 }
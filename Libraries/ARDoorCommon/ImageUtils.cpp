@@ -7,9 +7,310 @@
 //
 
 #include "ImageUtils.h"
+#include <cstring>
+
+#if defined(__SSSE3__)
+    #include <tmmintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define USE_NEON
+#endif
 
 namespace ARDoor
 {
+    // fixed point weights of the gray conversion, they sum up to 256
+    static const int GRAY_B = 29;
+    static const int GRAY_G = 150;
+    static const int GRAY_R = 77;
+
+    // fixed point BT.601 coefficients, scaled by 64
+    static const int YUV_Y = 74;
+    static const int YUV_VR = 102;
+    static const int YUV_VG = -52;
+    static const int YUV_UG = -25;
+    static const int YUV_UB = 129;
+
+    static inline uchar grayOf(int b, int g, int r)
+    {
+        return (uchar) ((b * GRAY_B + g * GRAY_G + r * GRAY_R + 128) >> 8);
+    }
+
+    static inline uchar clampToByte(int value)
+    {
+        return (uchar) (value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    static inline void yuvToRgb(int y, int u, int v, uchar *rgb)
+    {
+        int luma = (y - 16) * YUV_Y;
+        u -= 128;
+        v -= 128;
+
+        rgb[0] = clampToByte((luma + YUV_VR * v) >> 6);
+        rgb[1] = clampToByte((luma + YUV_VG * v + YUV_UG * u) >> 6);
+        rgb[2] = clampToByte((luma + YUV_UB * u) >> 6);
+    }
+
+#ifdef __SSE2__
+    /**
+     * Weighted sums of 4 BGRA pixels as 32 bit integers
+     */
+    static inline __m128i graySums(__m128i bgra, __m128i weights, __m128i zero)
+    {
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(bgra, zero), weights);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(bgra, zero), weights);
+
+        // each pixel is split into b + g and r + a, add the halves and gather them
+        lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+        hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+        lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 2, 0));
+        hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 2, 0));
+
+        return _mm_unpacklo_epi64(lo, hi);
+    }
+
+    /**
+     * Gray values of 16 BGRA pixels
+     */
+    static inline __m128i grayOf16(const __m128i *bgra)
+    {
+        const __m128i weights = _mm_setr_epi16(GRAY_B, GRAY_G, GRAY_R, 0, GRAY_B, GRAY_G, GRAY_R, 0);
+        const __m128i round = _mm_set1_epi32(128);
+        const __m128i zero = _mm_setzero_si128();
+
+        __m128i sums[4];
+        for (int i = 0; i < 4; i++)
+        {
+            sums[i] = _mm_srli_epi32(_mm_add_epi32(graySums(bgra[i], weights, zero), round), 8);
+        }
+
+        return _mm_packus_epi16(_mm_packs_epi32(sums[0], sums[1]), _mm_packs_epi32(sums[2], sums[3]));
+    }
+#endif
+
+#ifdef __SSSE3__
+    /**
+     * Shuffle masks interleaving three planes of 16 bytes into 48 bytes of RGB
+     * @param masks receives the masks of block 0-2 for channel 0-2 at masks[block * 3 + channel]
+     */
+    static void interleaveMasks(__m128i *masks)
+    {
+        for (int block = 0; block < 3; block++)
+        {
+            for (int channel = 0; channel < 3; channel++)
+            {
+                char mask[16];
+                for (int i = 0; i < 16; i++)
+                {
+                    int index = block * 16 + i;
+                    mask[i] = index % 3 == channel ? (char) (index / 3) : (char) 0x80;
+                }
+                masks[block * 3 + channel] = _mm_loadu_si128((const __m128i*) mask);
+            }
+        }
+    }
+
+    static inline void storeRgb(uchar *dst, __m128i r, __m128i g, __m128i b, const __m128i *masks)
+    {
+        for (int block = 0; block < 3; block++)
+        {
+            __m128i out = _mm_or_si128(
+                _mm_or_si128(_mm_shuffle_epi8(r, masks[block * 3]), _mm_shuffle_epi8(g, masks[block * 3 + 1])),
+                _mm_shuffle_epi8(b, masks[block * 3 + 2])
+            );
+            _mm_storeu_si128((__m128i*) (dst + block * 16), out);
+        }
+    }
+#endif
+
+    static void bgraToGrayRow(const uchar *src, uchar *gray, int width)
+    {
+        int x = 0;
+
+#if defined(__SSE2__)
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i bgra[4];
+            for (int i = 0; i < 4; i++)
+            {
+                bgra[i] = _mm_loadu_si128((const __m128i*) (src + 4 * x + 16 * i));
+            }
+            _mm_storeu_si128((__m128i*) (gray + x), grayOf16(bgra));
+        }
+#elif defined(USE_NEON)
+        for (; x + 16 <= width; x += 16)
+        {
+            uint8x16x4_t bgra = vld4q_u8(src + 4 * x);
+
+            uint16x8_t lo = vmull_u8(vget_low_u8(bgra.val[0]), vdup_n_u8(GRAY_B));
+            lo = vmlal_u8(lo, vget_low_u8(bgra.val[1]), vdup_n_u8(GRAY_G));
+            lo = vmlal_u8(lo, vget_low_u8(bgra.val[2]), vdup_n_u8(GRAY_R));
+
+            uint16x8_t hi = vmull_u8(vget_high_u8(bgra.val[0]), vdup_n_u8(GRAY_B));
+            hi = vmlal_u8(hi, vget_high_u8(bgra.val[1]), vdup_n_u8(GRAY_G));
+            hi = vmlal_u8(hi, vget_high_u8(bgra.val[2]), vdup_n_u8(GRAY_R));
+
+            vst1q_u8(gray + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+#endif
+
+        for (; x < width; x++)
+        {
+            const uchar *pixel = src + 4 * x;
+            gray[x] = grayOf(pixel[0], pixel[1], pixel[2]);
+        }
+    }
+
+    /**
+     * @param gray may be NULL
+     */
+    static void bgraToRgbRow(const uchar *src, uchar *rgb, uchar *gray, int width)
+    {
+        int x = 0;
+
+#if defined(__SSSE3__)
+        const __m128i toRgb = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        // every store writes 4 bytes past its pixels, which the next one overwrites
+        for (; x + 18 <= width; x += 16)
+        {
+            __m128i bgra[4];
+            for (int i = 0; i < 4; i++)
+            {
+                bgra[i] = _mm_loadu_si128((const __m128i*) (src + 4 * x + 16 * i));
+                _mm_storeu_si128((__m128i*) (rgb + 3 * x + 12 * i), _mm_shuffle_epi8(bgra[i], toRgb));
+            }
+
+            if (gray != NULL)
+            {
+                _mm_storeu_si128((__m128i*) (gray + x), grayOf16(bgra));
+            }
+        }
+#elif defined(USE_NEON)
+        for (; x + 16 <= width; x += 16)
+        {
+            uint8x16x4_t bgra = vld4q_u8(src + 4 * x);
+
+            uint8x16x3_t out;
+            out.val[0] = bgra.val[2];
+            out.val[1] = bgra.val[1];
+            out.val[2] = bgra.val[0];
+            vst3q_u8(rgb + 3 * x, out);
+
+            if (gray != NULL)
+            {
+                uint16x8_t lo = vmull_u8(vget_low_u8(bgra.val[0]), vdup_n_u8(GRAY_B));
+                lo = vmlal_u8(lo, vget_low_u8(bgra.val[1]), vdup_n_u8(GRAY_G));
+                lo = vmlal_u8(lo, vget_low_u8(bgra.val[2]), vdup_n_u8(GRAY_R));
+
+                uint16x8_t hi = vmull_u8(vget_high_u8(bgra.val[0]), vdup_n_u8(GRAY_B));
+                hi = vmlal_u8(hi, vget_high_u8(bgra.val[1]), vdup_n_u8(GRAY_G));
+                hi = vmlal_u8(hi, vget_high_u8(bgra.val[2]), vdup_n_u8(GRAY_R));
+
+                vst1q_u8(gray + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+            }
+        }
+#endif
+
+        for (; x < width; x++)
+        {
+            const uchar *pixel = src + 4 * x;
+            uchar *out = rgb + 3 * x;
+
+            out[0] = pixel[2];
+            out[1] = pixel[1];
+            out[2] = pixel[0];
+
+            if (gray != NULL)
+            {
+                gray[x] = grayOf(pixel[0], pixel[1], pixel[2]);
+            }
+        }
+    }
+
+    /**
+     * @param vu chroma row shared by two luma rows, V and U interleaved at half the resolution
+     */
+    static void nv21ToRgbRow(const uchar *luma, const uchar *vu, uchar *rgb, int width)
+    {
+        int x = 0;
+
+#if defined(__SSSE3__)
+        __m128i masks[9];
+        interleaveMasks(masks);
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+        const __m128i offset16 = _mm_set1_epi16(16);
+        const __m128i offset128 = _mm_set1_epi16(128);
+
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i y = _mm_loadu_si128((const __m128i*) (luma + x));
+            __m128i chroma = _mm_loadu_si128((const __m128i*) (vu + x));
+
+            __m128i v = _mm_sub_epi16(_mm_and_si128(chroma, lowBytes), offset128);
+            __m128i u = _mm_sub_epi16(_mm_srli_epi16(chroma, 8), offset128);
+
+            __m128i rc = _mm_mullo_epi16(v, _mm_set1_epi16(YUV_VR));
+            __m128i gc = _mm_add_epi16(_mm_mullo_epi16(v, _mm_set1_epi16(YUV_VG)), _mm_mullo_epi16(u, _mm_set1_epi16(YUV_UG)));
+            __m128i bc = _mm_mullo_epi16(u, _mm_set1_epi16(YUV_UB));
+
+            __m128i yLo = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y, zero), offset16), _mm_set1_epi16(YUV_Y));
+            __m128i yHi = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y, zero), offset16), _mm_set1_epi16(YUV_Y));
+
+            // every chroma sample covers two neighbouring pixels, blue may exceed 16 bit and saturates
+            __m128i r = _mm_packus_epi16(
+                _mm_srai_epi16(_mm_adds_epi16(yLo, _mm_unpacklo_epi16(rc, rc)), 6),
+                _mm_srai_epi16(_mm_adds_epi16(yHi, _mm_unpackhi_epi16(rc, rc)), 6)
+            );
+            __m128i g = _mm_packus_epi16(
+                _mm_srai_epi16(_mm_adds_epi16(yLo, _mm_unpacklo_epi16(gc, gc)), 6),
+                _mm_srai_epi16(_mm_adds_epi16(yHi, _mm_unpackhi_epi16(gc, gc)), 6)
+            );
+            __m128i b = _mm_packus_epi16(
+                _mm_srai_epi16(_mm_adds_epi16(yLo, _mm_unpacklo_epi16(bc, bc)), 6),
+                _mm_srai_epi16(_mm_adds_epi16(yHi, _mm_unpackhi_epi16(bc, bc)), 6)
+            );
+
+            storeRgb(rgb + 3 * x, r, g, b, masks);
+        }
+#elif defined(USE_NEON)
+        for (; x + 16 <= width; x += 16)
+        {
+            uint8x16_t y = vld1q_u8(luma + x);
+            uint8x8x2_t chroma = vld2_u8(vu + x);
+
+            int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(chroma.val[0])), vdupq_n_s16(128));
+            int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(chroma.val[1])), vdupq_n_s16(128));
+
+            int16x8x2_t rc = vzipq_s16(vmulq_n_s16(v, YUV_VR), vmulq_n_s16(v, YUV_VR));
+            int16x8_t g1 = vaddq_s16(vmulq_n_s16(v, YUV_VG), vmulq_n_s16(u, YUV_UG));
+            int16x8x2_t gc = vzipq_s16(g1, g1);
+            int16x8x2_t bc = vzipq_s16(vmulq_n_s16(u, YUV_UB), vmulq_n_s16(u, YUV_UB));
+
+            int16x8_t yLo = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y))), vdupq_n_s16(16)), YUV_Y);
+            int16x8_t yHi = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y))), vdupq_n_s16(16)), YUV_Y);
+
+            uint8x16x3_t out;
+            out.val[0] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLo, rc.val[0]), 6), vqshrun_n_s16(vqaddq_s16(yHi, rc.val[1]), 6));
+            out.val[1] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLo, gc.val[0]), 6), vqshrun_n_s16(vqaddq_s16(yHi, gc.val[1]), 6));
+            out.val[2] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLo, bc.val[0]), 6), vqshrun_n_s16(vqaddq_s16(yHi, bc.val[1]), 6));
+            vst3q_u8(rgb + 3 * x, out);
+        }
+#endif
+
+        for (; x < width; x++)
+        {
+            const uchar *chroma = vu + (x & ~1);
+            yuvToRgb(luma[x], chroma[1], chroma[0], rgb + 3 * x);
+        }
+    }
+
     /**
      * Converts the given original image to a gray scale image.
      * Expects orig to be BGR, BGRA or GRAY.
@@ -22,11 +323,75 @@ namespace ARDoor
         }
         else if (orig.channels() == 4)
         {
-            cv::cvtColor(orig, gray, CV_BGRA2GRAY);
+            bgraToGray(orig, gray);
         }
         else if (orig.channels() == 1)
         {
             gray = orig;
         }
     }
-}
\ No newline at end of file
+
+    void ImageUtils::bgraToGray(const cv::Mat &bgra, cv::Mat &gray)
+    {
+        CV_Assert(bgra.type() == CV_8UC4);
+
+        gray.create(bgra.rows, bgra.cols, CV_8UC1);
+        for (int y = 0; y < bgra.rows; y++)
+        {
+            bgraToGrayRow(bgra.ptr(y), gray.ptr(y), bgra.cols);
+        }
+    }
+
+    void ImageUtils::bgraToRgb(const cv::Mat &bgra, cv::Mat &rgb)
+    {
+        CV_Assert(bgra.type() == CV_8UC4);
+
+        rgb.create(bgra.rows, bgra.cols, CV_8UC3);
+        for (int y = 0; y < bgra.rows; y++)
+        {
+            bgraToRgbRow(bgra.ptr(y), rgb.ptr(y), NULL, bgra.cols);
+        }
+    }
+
+    void ImageUtils::bgraToRgb(const cv::Mat &bgra, cv::Mat &rgb, cv::Mat &gray)
+    {
+        CV_Assert(bgra.type() == CV_8UC4);
+
+        rgb.create(bgra.rows, bgra.cols, CV_8UC3);
+        gray.create(bgra.rows, bgra.cols, CV_8UC1);
+        for (int y = 0; y < bgra.rows; y++)
+        {
+            bgraToRgbRow(bgra.ptr(y), rgb.ptr(y), gray.ptr(y), bgra.cols);
+        }
+    }
+
+    void ImageUtils::argbToBgra(const cv::Mat &argb, cv::Mat &bgra)
+    {
+        CV_Assert(argb.type() == CV_8UC4 && argb.data != bgra.data);
+
+        static const int fromTo[] = { 0, 3, 1, 2, 2, 1, 3, 0 };
+        bgra.create(argb.rows, argb.cols, CV_8UC4);
+        cv::mixChannels(&argb, 1, &bgra, 1, fromTo, 4);
+    }
+
+    void ImageUtils::nv21ToGray(const cv::Mat &nv21, cv::Mat &gray)
+    {
+        CV_Assert(nv21.type() == CV_8UC1 && nv21.rows % 3 == 0);
+
+        // the Y plane already is the gray scale image
+        nv21.rowRange(0, nv21.rows * 2 / 3).copyTo(gray);
+    }
+
+    void ImageUtils::nv21ToRgb(const cv::Mat &nv21, cv::Mat &rgb)
+    {
+        CV_Assert(nv21.type() == CV_8UC1 && nv21.rows % 3 == 0 && nv21.cols % 2 == 0);
+
+        int height = nv21.rows * 2 / 3;
+
+        rgb.create(height, nv21.cols, CV_8UC3);
+        for (int y = 0; y < height; y++)
+        {
+            nv21ToRgbRow(nv21.ptr(y), nv21.ptr(height + y / 2), rgb.ptr(y), nv21.cols);
+        }
+    }
+}
@@ -7,11 +7,41 @@
 
 namespace ARDoor
 {
+    /**
+     * The conversion kernels run in a single pass over the image, using SSE
+     * or NEON where the compiler supports it. The output matrices are only
+     * reallocated if their size or type does not fit, so callers should keep
+     * them from frame to frame.
+     *
+     * Gray is computed as (29 B + 150 G + 77 R) / 256 and YUV as BT.601
+     * video range, both in fixed point. Results may differ from cvtColor by
+     * one in some pixels.
+     */
     class ImageUtils
     {
     public:
         static void convertToGray(const cv::Mat &orig, cv::Mat &gray);
+
+        static void bgraToGray(const cv::Mat &bgra, cv::Mat &gray);
+        static void bgraToRgb(const cv::Mat &bgra, cv::Mat &rgb);
+
+        /**
+         * Converts to RGB and writes the gray scale image in the same pass
+         */
+        static void bgraToRgb(const cv::Mat &bgra, cv::Mat &rgb, cv::Mat &gray);
+
+        /**
+         * Reverses the byte order of every pixel
+         * @param argb CV_8UC4 with A, R, G, B in memory, as 0xBBGGRRAA words on little endian machines
+         */
+        static void argbToBgra(const cv::Mat &argb, cv::Mat &bgra);
+
+        /**
+         * @param nv21 CV_8UC1 of height * 3 / 2 rows, the Y plane followed by interleaved V and U
+         */
+        static void nv21ToGray(const cv::Mat &nv21, cv::Mat &gray);
+        static void nv21ToRgb(const cv::Mat &nv21, cv::Mat &rgb);
     };
 }
 
-#endif 
+#endif
@@ -0,0 +1,439 @@
+
+#include "IncrementalCalibration.h"
+#include <algorithm>
+#include <cmath>
+#include <opencv2/calib3d/calib3d.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace ARDoor
+{
+    // coverage grid: position of the board centre, its size relative to the image and its tilt around both axes
+    static const int POSITION_BINS_X = 4;
+    static const int POSITION_BINS_Y = 3;
+    static const int SCALE_BINS = 3;
+    static const int TILT_BINS = 3;
+    static const int CELL_COUNT = POSITION_BINS_X * POSITION_BINS_Y * SCALE_BINS * TILT_BINS * TILT_BINS;
+
+    // log ratio of opposite board edges above which the board counts as tilted, about 15 percent
+    static const float TILT_THRESHOLD = 0.14f;
+
+    // fewer views do not determine the distortion coefficients
+    static const size_t MIN_VIEWS = 4;
+
+    static int bin(float value, int bins)
+    {
+        return std::min(std::max((int) (value * bins), 0), bins - 1);
+    }
+
+    static int tiltBin(float logRatio)
+    {
+        return logRatio < -TILT_THRESHOLD ? 0 : (logRatio > TILT_THRESHOLD ? 2 : 1);
+    }
+
+    IncrementalCalibration::IncrementalCalibration(CameraCalibration *calibration, cv::Size boardSize, int interval, int maxViewsPerCell)
+    {
+        this->calibration = calibration;
+        this->boardSize = boardSize;
+        this->interval = std::max(interval, 1);
+        this->maxViewsPerCell = std::max(maxViewsPerCell, 1);
+
+        cells.assign(CELL_COUNT, 0);
+        nextViewId = 0;
+        viewsSinceEstimate = 0;
+
+        running = true;
+        generation = 0;
+        hasPendingJob = false;
+        hasFinishedEstimate = false;
+        hasFailedEstimate = false;
+        busy = false;
+        worker = std::thread(&IncrementalCalibration::run, this);
+    }
+
+    IncrementalCalibration::~IncrementalCalibration()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        jobAvailable.notify_one();
+        worker.join();
+    }
+
+    bool IncrementalCalibration::addView(const std::vector<cv::Point2f> &imageCorners, const std::vector<cv::Point3f> &objectCorners, cv::Size imageSize)
+    {
+        if ((int) imageCorners.size() != boardSize.area() || imageCorners.size() != objectCorners.size())
+        {
+            return false;
+        }
+
+        if (imageSize != this->imageSize)
+        {
+            clear();
+            this->imageSize = imageSize;
+        }
+
+        int cell = findCell(imageCorners);
+        if (cells[cell] >= maxViewsPerCell)
+        {
+            return false;
+        }
+
+        CalibrationView view;
+        view.id = nextViewId++;
+        view.cell = cell;
+        view.imageCorners = imageCorners;
+        view.objectCorners = objectCorners;
+        view.error = -1;
+
+        views.push_back(view);
+        cells[cell]++;
+
+        if (++viewsSinceEstimate >= interval && views.size() >= MIN_VIEWS)
+        {
+            requestEstimate();
+        }
+
+        return true;
+    }
+
+    bool IncrementalCalibration::update()
+    {
+        CalibrationEstimate estimate;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (hasFailedEstimate)
+            {
+                failedViewIds.swap(failedJobViewIds);
+                hasFailedEstimate = false;
+            }
+
+            if (!hasFinishedEstimate)
+            {
+                return false;
+            }
+
+            estimate = finishedEstimate;
+            hasFinishedEstimate = false;
+        }
+
+        applyEstimate(estimate);
+
+        return true;
+    }
+
+    const CalibrationEstimate& IncrementalCalibration::getEstimate() const
+    {
+        return currentEstimate;
+    }
+
+    const std::vector<CalibrationView>& IncrementalCalibration::getViews() const
+    {
+        return views;
+    }
+
+    int IncrementalCalibration::getCoverage() const
+    {
+        return (int) std::count_if(cells.begin(), cells.end(), [](int count) { return count > 0; });
+    }
+
+    int IncrementalCalibration::dropOutliers(double maxError)
+    {
+        size_t previousSize = views.size();
+
+        for (std::vector<CalibrationView>::iterator it = views.begin(); it != views.end();)
+        {
+            if (it->error > maxError)
+            {
+                cells[it->cell]--;
+                it = views.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        int dropped = (int) (previousSize - views.size());
+        if (dropped > 0 && views.size() >= MIN_VIEWS)
+        {
+            requestEstimate();
+        }
+
+        return dropped;
+    }
+
+    void IncrementalCalibration::removeView(int id)
+    {
+        for (std::vector<CalibrationView>::iterator it = views.begin(); it != views.end(); ++it)
+        {
+            if (it->id == id)
+            {
+                cells[it->cell]--;
+                views.erase(it);
+                return;
+            }
+        }
+    }
+
+    void IncrementalCalibration::clear()
+    {
+        views.clear();
+        cells.assign(CELL_COUNT, 0);
+        viewsSinceEstimate = 0;
+        currentEstimate = CalibrationEstimate();
+        failedViewIds.clear();
+
+        // an estimate still running belongs to the old views
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+        hasPendingJob = false;
+        hasFinishedEstimate = false;
+        hasFailedEstimate = false;
+    }
+
+    bool IncrementalCalibration::requestFinalEstimate()
+    {
+        if (views.size() < MIN_VIEWS)
+        {
+            return false;
+        }
+
+        if (!isEstimateCurrent())
+        {
+            requestEstimate();
+        }
+
+        return true;
+    }
+
+    bool IncrementalCalibration::isEstimateCurrent() const
+    {
+        return currentEstimate.valid && coversViews(currentEstimate.viewIds);
+    }
+
+    bool IncrementalCalibration::hasEstimateFailed() const
+    {
+        return !failedViewIds.empty() && coversViews(failedViewIds);
+    }
+
+    bool IncrementalCalibration::isEstimating()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hasPendingJob || busy;
+    }
+
+    double IncrementalCalibration::applyEstimate()
+    {
+        if (!currentEstimate.valid)
+        {
+            return -1;
+        }
+
+        calibration->setIntrinsicsMatrix(currentEstimate.cameraMatrix.clone());
+        calibration->setDistortionCoeffs(currentEstimate.distCoeffs.clone());
+
+        return currentEstimate.rms;
+    }
+
+    bool IncrementalCalibration::coversViews(const std::vector<int> &viewIds) const
+    {
+        if (viewIds.size() != views.size())
+        {
+            return false;
+        }
+
+        // the ids of both lists are in the order the views were added
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            if (views[i].id != viewIds[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int IncrementalCalibration::findCell(const std::vector<cv::Point2f> &imageCorners) const
+    {
+        // outer corners of the board, the corners are stored row by row
+        const cv::Point2f &topLeft = imageCorners[0];
+        const cv::Point2f &topRight = imageCorners[boardSize.width - 1];
+        const cv::Point2f &bottomLeft = imageCorners[(boardSize.height - 1) * boardSize.width];
+        const cv::Point2f &bottomRight = imageCorners[boardSize.area() - 1];
+
+        cv::Point2f centre = (topLeft + topRight + bottomLeft + bottomRight) * 0.25f;
+
+        std::vector<cv::Point2f> outline;
+        outline.push_back(topLeft);
+        outline.push_back(topRight);
+        outline.push_back(bottomRight);
+        outline.push_back(bottomLeft);
+        float scale = std::sqrt((float) cv::contourArea(outline) / imageSize.area());
+
+        // a tilted board appears with one edge shorter than the opposite one
+        float left = (float) cv::norm(bottomLeft - topLeft);
+        float right = (float) cv::norm(bottomRight - topRight);
+        float top = (float) cv::norm(topRight - topLeft);
+        float bottom = (float) cv::norm(bottomRight - bottomLeft);
+        float tiltX = std::log(std::max(left, 1.0f) / std::max(right, 1.0f));
+        float tiltY = std::log(std::max(top, 1.0f) / std::max(bottom, 1.0f));
+
+        int cell = bin(centre.x / imageSize.width, POSITION_BINS_X);
+        cell = cell * POSITION_BINS_Y + bin(centre.y / imageSize.height, POSITION_BINS_Y);
+        cell = cell * SCALE_BINS + bin(scale, SCALE_BINS);
+        cell = cell * TILT_BINS + tiltBin(tiltX);
+        cell = cell * TILT_BINS + tiltBin(tiltY);
+
+        return cell;
+    }
+
+    void IncrementalCalibration::createJob(Job &job) const
+    {
+        job.generation = generation;
+        job.imageSize = imageSize;
+        job.viewIds.clear();
+        job.imagePoints.clear();
+        job.objectPoints.clear();
+
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            job.viewIds.push_back(views[i].id);
+            job.imagePoints.push_back(views[i].imageCorners);
+            job.objectPoints.push_back(views[i].objectCorners);
+        }
+
+        if (currentEstimate.valid)
+        {
+            job.cameraMatrix = currentEstimate.cameraMatrix.clone();
+            job.distCoeffs = currentEstimate.distCoeffs.clone();
+        }
+    }
+
+    void IncrementalCalibration::requestEstimate()
+    {
+        viewsSinceEstimate = 0;
+
+        {
+            // a job still waiting is outdated and replaced
+            std::lock_guard<std::mutex> lock(mutex);
+            createJob(pendingJob);
+            hasPendingJob = true;
+        }
+        jobAvailable.notify_one();
+    }
+
+    void IncrementalCalibration::applyEstimate(const CalibrationEstimate &estimate)
+    {
+        currentEstimate = estimate;
+
+        // views added after the job was created keep their error, removed views are skipped
+        for (size_t i = 0; i < estimate.viewIds.size(); i++)
+        {
+            for (size_t j = 0; j < views.size(); j++)
+            {
+                if (views[j].id == estimate.viewIds[i])
+                {
+                    views[j].error = estimate.viewErrors[i];
+                    break;
+                }
+            }
+        }
+    }
+
+    void IncrementalCalibration::run()
+    {
+        Job job;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this]() { return hasPendingJob || !running; });
+
+                if (!running)
+                {
+                    return;
+                }
+
+                std::swap(job, pendingJob);
+                hasPendingJob = false;
+                busy = true;
+            }
+
+            CalibrationEstimate result;
+            bool success = estimate(job, result);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = false;
+
+            // the views may have been cleared in the meantime
+            if (job.generation != generation)
+            {
+                continue;
+            }
+
+            if (success)
+            {
+                finishedEstimate = result;
+                hasFinishedEstimate = true;
+            }
+            else
+            {
+                failedJobViewIds = job.viewIds;
+                hasFailedEstimate = true;
+            }
+        }
+    }
+
+    bool IncrementalCalibration::estimate(const Job &job, CalibrationEstimate &result)
+    {
+        std::vector<cv::Mat> rotationVecs, translationVecs;
+        int flags = 0;
+
+        result.cameraMatrix = job.cameraMatrix.clone();
+        result.distCoeffs = job.distCoeffs.clone();
+        if (!result.cameraMatrix.empty())
+        {
+            // the previous estimate is close, which saves most of the iterations
+            flags |= CV_CALIB_USE_INTRINSIC_GUESS;
+        }
+
+        try
+        {
+            result.rms = cv::calibrateCamera(
+                job.objectPoints,
+                job.imagePoints,
+                job.imageSize,
+                result.cameraMatrix,
+                result.distCoeffs,
+                rotationVecs,
+                translationVecs,
+                flags
+            );
+        }
+        catch (const cv::Exception &e)
+        {
+            // degenerate views, the next estimate may succeed
+            std::cerr << "calibration failed: " << e.what() << std::endl;
+            return false;
+        }
+
+        result.viewIds = job.viewIds;
+        result.viewErrors.resize(job.viewIds.size());
+
+        std::vector<cv::Point2f> projected;
+        for (size_t i = 0; i < job.objectPoints.size(); i++)
+        {
+            cv::projectPoints(job.objectPoints[i], rotationVecs[i], translationVecs[i], result.cameraMatrix, result.distCoeffs, projected);
+
+            double error = cv::norm(job.imagePoints[i], projected, cv::NORM_L2);
+            result.viewErrors[i] = std::sqrt(error * error / projected.size());
+        }
+
+        result.valid = true;
+
+        return true;
+    }
+}
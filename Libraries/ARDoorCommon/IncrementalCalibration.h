@@ -0,0 +1,184 @@
+
+#ifndef __ARDoor__IncrementalCalibration__
+#define __ARDoor__IncrementalCalibration__
+
+#include <iostream>
+#include <vector>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <opencv2/core/core.hpp>
+#include "CameraCalibration.h"
+
+namespace ARDoor
+{
+    /**
+     * Chessboard view collected for the calibration
+     */
+    struct CalibrationView
+    {
+        int id;
+        // coverage grid cell of the view
+        int cell;
+        std::vector<cv::Point2f> imageCorners;
+        std::vector<cv::Point3f> objectCorners;
+        // RMS reprojection error in pixels of the latest estimate, negative until the view has been estimated
+        double error;
+    };
+
+    /**
+     * Intrinsics estimated from the views collected so far
+     */
+    struct CalibrationEstimate
+    {
+        bool valid;
+        double rms;
+        cv::Mat cameraMatrix;
+        cv::Mat distCoeffs;
+        // views the estimate was computed from and their reprojection errors
+        std::vector<int> viewIds;
+        std::vector<double> viewErrors;
+
+        CalibrationEstimate() : valid(false), rms(0) {}
+    };
+
+    /**
+     * Collects chessboard views while the camera is running and keeps the
+     * intrinsics up to date.
+     *
+     * Every view is sorted into a coverage grid over its position in the
+     * image, its size and its tilt. A view is rejected if its cell already
+     * holds enough views, so the collected views differ from each other
+     * instead of repeating the same pose. Every few accepted views the
+     * intrinsics are estimated again on a background thread, starting from
+     * the previous estimate. The estimate reports the reprojection error of
+     * every view, views with large errors can then be dropped.
+     */
+    class IncrementalCalibration
+    {
+    public:
+        /**
+         * @param calibration receives the intrinsics when applyEstimate is called
+         * @param boardSize number of inner corners per row and column of the board
+         * @param interval number of accepted views between two estimations
+         * @param maxViewsPerCell number of views accepted per coverage grid cell
+         */
+        IncrementalCalibration(CameraCalibration *calibration, cv::Size boardSize, int interval = 5, int maxViewsPerCell = 1);
+        ~IncrementalCalibration();
+
+        /**
+         * Adds a view if it covers a part of the grid which is not full yet.
+         * Views of a different image size replace all collected views.
+         * @return true if the view has been accepted
+         */
+        bool addView(const std::vector<cv::Point2f> &imageCorners, const std::vector<cv::Point3f> &objectCorners, cv::Size imageSize);
+
+        /**
+         * Takes over the result of a finished background estimation and
+         * updates the errors of the views. Has to be called regularly from
+         * the thread which adds the views.
+         * @return true if a new estimate is available
+         */
+        bool update();
+
+        const CalibrationEstimate& getEstimate() const;
+        const std::vector<CalibrationView>& getViews() const;
+
+        /**
+         * @return number of occupied coverage grid cells
+         */
+        int getCoverage() const;
+
+        /**
+         * Removes the views whose reprojection error exceeds the threshold and
+         * estimates the intrinsics again without them
+         * @param maxError maximal RMS reprojection error of a view in pixels
+         * @return number of removed views
+         */
+        int dropOutliers(double maxError);
+
+        void removeView(int id);
+        void clear();
+
+        /**
+         * Requests an estimate from all collected views on the background
+         * thread, unless the current estimate already covers them
+         * @return false if there are not enough views
+         */
+        bool requestFinalEstimate();
+
+        /**
+         * @return true if the current estimate was computed from exactly the collected views
+         */
+        bool isEstimateCurrent() const;
+
+        /**
+         * @return true if the last background estimation of exactly the collected views failed
+         */
+        bool hasEstimateFailed() const;
+
+        /**
+         * @return true while a background estimation is waiting or running
+         */
+        bool isEstimating();
+
+        /**
+         * Writes the current estimate to the camera calibration
+         * @return the re-projection error, negative if there is no valid estimate
+         */
+        double applyEstimate();
+
+    private:
+        struct Job
+        {
+            int generation;
+            cv::Size imageSize;
+            std::vector<int> viewIds;
+            std::vector< std::vector<cv::Point2f> > imagePoints;
+            std::vector< std::vector<cv::Point3f> > objectPoints;
+            // previous estimate used as initial guess, may be empty
+            cv::Mat cameraMatrix;
+            cv::Mat distCoeffs;
+        };
+
+        int findCell(const std::vector<cv::Point2f> &imageCorners) const;
+        void createJob(Job &job) const;
+        void requestEstimate();
+        void applyEstimate(const CalibrationEstimate &estimate);
+        bool coversViews(const std::vector<int> &viewIds) const;
+        void run();
+        static bool estimate(const Job &job, CalibrationEstimate &result);
+
+        CameraCalibration *calibration;
+        int interval;
+        int maxViewsPerCell;
+
+        cv::Size imageSize;
+        cv::Size boardSize;
+        std::vector<CalibrationView> views;
+        // number of views in every coverage grid cell
+        std::vector<int> cells;
+        int nextViewId;
+        int viewsSinceEstimate;
+        CalibrationEstimate currentEstimate;
+        // views of the last estimation which failed
+        std::vector<int> failedViewIds;
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable jobAvailable;
+        bool running;
+        // incremented whenever the views are cleared, outdated estimates are discarded
+        int generation;
+        bool hasPendingJob;
+        Job pendingJob;
+        bool hasFinishedEstimate;
+        CalibrationEstimate finishedEstimate;
+        bool hasFailedEstimate;
+        std::vector<int> failedJobViewIds;
+        // set while the worker estimates a job
+        bool busy;
+    };
+}
+
+#endif
@@ -0,0 +1,313 @@
+#include "OverlayRenderer.h"
+
+// SLProject includes GLEW, which has to come before any other GL header
+#include <stdafx.h>
+#include <SLGLBuffer.h>
+#include <SLGLShaderProgGeneric.h>
+
+#include <opencv2/calib3d/calib3d.hpp>
+#include <limits>
+
+namespace ARDoor {
+
+// largest vertex count addressable by the 16 bit indices, which are also available on GL ES
+static const size_t MAX_BATCH_VERTICES = std::numeric_limits<unsigned short>::max() + 1;
+
+static void appendPoint(std::vector<float>& buffer, const cv::Point3f& p)
+{
+    buffer.push_back(p.x);
+    buffer.push_back(p.y);
+    buffer.push_back(p.z);
+}
+
+OverlayRenderer::Batch::Batch(int material)
+    : material(material), indexCount(0), positionBuffer(0), normalBuffer(0), indexBuffer(0)
+{
+}
+
+OverlayRenderer::OverlayRenderer()
+    : m_lineCount(0), m_linePositionBuffer(0), m_lineColorBuffer(0), m_meshShader(0), m_lineShader(0)
+{
+    for (int i = 0; i < 16; i++) {
+        m_projection[i] = i % 5 == 0 ? 1.0f : 0.0f;
+    }
+}
+
+OverlayRenderer::~OverlayRenderer()
+{
+    // the buffers can only be deleted while their GL context is current, RenderingContext::release does that
+}
+
+int OverlayRenderer::addMaterial(const cv::Vec4f& diffuse)
+{
+    m_materials.push_back(diffuse);
+    return (int) m_materials.size() - 1;
+}
+
+void OverlayRenderer::addMesh(const std::vector<cv::Point3f>& positions, const std::vector<cv::Point3f>& normals, const std::vector<unsigned int>& indices, int material)
+{
+    CV_Assert(positions.size() == normals.size() && positions.size() <= MAX_BATCH_VERTICES);
+    CV_Assert(material >= 0 && material < (int) m_materials.size());
+
+    Batch& batch = batchFor(material, positions.size());
+    unsigned int first = (unsigned int) (batch.positions.size() / 3);
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        appendPoint(batch.positions, positions[i]);
+        appendPoint(batch.normals, normals[i]);
+    }
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        batch.indices.push_back((unsigned short) (first + indices[i]));
+    }
+}
+
+void OverlayRenderer::addBox(const cv::Point3f& min, const cv::Point3f& max, int material)
+{
+    std::vector<cv::Point3f> positions, normals;
+    std::vector<unsigned int> indices;
+
+    // every face has its own corners for flat shading
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            cv::Point3f normal(0, 0, 0);
+            (&normal.x)[axis] = side ? 1.0f : -1.0f;
+
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            unsigned int first = (unsigned int) positions.size();
+
+            for (int corner = 0; corner < 4; corner++) {
+                cv::Point3f p;
+                (&p.x)[axis] = side ? (&max.x)[axis] : (&min.x)[axis];
+                (&p.x)[u] = (corner == 1 || corner == 2) ? (&max.x)[u] : (&min.x)[u];
+                (&p.x)[v] = (corner >= 2) ? (&max.x)[v] : (&min.x)[v];
+
+                positions.push_back(p);
+                normals.push_back(normal);
+            }
+
+            // counter clockwise seen from outside
+            unsigned int quad[] = { 0, 1, 2, 0, 2, 3 };
+            unsigned int flipped[] = { 0, 2, 1, 0, 3, 2 };
+            for (int i = 0; i < 6; i++) {
+                indices.push_back(first + (side ? quad[i] : flipped[i]));
+            }
+        }
+    }
+
+    addMesh(positions, normals, indices, material);
+}
+
+void OverlayRenderer::addLine(const cv::Point3f& from, const cv::Point3f& to, const cv::Vec4f& color)
+{
+    appendPoint(m_linePositions, from);
+    appendPoint(m_linePositions, to);
+
+    for (int i = 0; i < 2; i++) {
+        m_lineColors.insert(m_lineColors.end(), color.val, color.val + 4);
+    }
+}
+
+void OverlayRenderer::initialize()
+{
+#ifdef __glew_h__
+    // GLEW resolves the entry points of the context created by the window system
+    glewInit();
+#endif
+
+#ifdef SL_SHADER_PATH
+    SLGLShaderProg::defaultPath = SL_SHADER_PATH;
+#endif
+
+    // diffuse lighting with uniforms only, the standard lit shaders need the light state of an SLScene
+    if (!m_meshShader) {
+        m_meshShader = new SLGLShaderProgGeneric("Diffuse.vert", "Diffuse.frag");
+        m_meshShader->init();
+    }
+    if (!m_lineShader) {
+        m_lineShader = new SLGLShaderProgGeneric("ColorAttribute.vert", "Color.frag");
+        m_lineShader->init();
+    }
+
+    upload();
+}
+
+void OverlayRenderer::setProjection(const cv::Mat& intrinsics, cv::Size imageSize, float nearPlane, float farPlane)
+{
+    cv::Mat_<double> K;
+    intrinsics.convertTo(K, CV_64F);
+
+    float w = (float) imageSize.width, h = (float) imageSize.height;
+    float fx = (float) K(0, 0), fy = (float) K(1, 1);
+    float cx = (float) K(0, 2), cy = (float) K(1, 2);
+
+    // maps the GL camera, looking down -z with y up, onto the pixels of the camera image
+    float projection[16] = {
+        2 * fx / w, 0,          0,                                                 0,
+        0,          2 * fy / h, 0,                                                 0,
+        1 - 2 * cx / w, 2 * cy / h - 1, -(farPlane + nearPlane) / (farPlane - nearPlane), -1,
+        0,          0,          -2 * farPlane * nearPlane / (farPlane - nearPlane), 0
+    };
+
+    std::copy(projection, projection + 16, m_projection);
+}
+
+void OverlayRenderer::draw(const Pose& pose)
+{
+    if (!pose.valid || !m_meshShader) {
+        return;
+    }
+
+    cv::Matx33d R;
+    cv::Rodrigues(pose.rotation, R);
+    cv::Mat_<double> t;
+    pose.translation.convertTo(t, CV_64F);
+
+    // OpenCV looks down +z with y pointing down, GL down -z with y up
+    cv::Matx44f modelView;
+    for (int row = 0; row < 3; row++) {
+        float sign = row == 0 ? 1.0f : -1.0f;
+        for (int col = 0; col < 3; col++) {
+            modelView(row, col) = sign * (float) R(row, col);
+            m_normalMatrix[col * 3 + row] = modelView(row, col);
+        }
+        modelView(row, 3) = sign * (float) t(row);
+    }
+    modelView(3, 0) = modelView(3, 1) = modelView(3, 2) = 0;
+    modelView(3, 3) = 1;
+
+    cv::Matx44f projection = cv::Matx44f(m_projection).t();
+    cv::Matx44f mvp = (projection * modelView).t();
+    std::copy(mvp.val, mvp.val + 16, m_modelViewProjection);
+
+    glEnable(GL_DEPTH_TEST);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    m_meshShader->useProgram();
+    m_meshShader->uniformMatrix4fv("u_mvpMatrix", 1, m_modelViewProjection);
+    m_meshShader->uniformMatrix3fv("u_nMatrix", 1, m_normalMatrix);
+    // the light shines from the camera
+    m_meshShader->uniform3f("u_lightDirVS", 0, 0, 1);
+    m_meshShader->uniform4f("u_lightDiffuse", 1, 1, 1, 1);
+
+    drawBatches(false);
+
+    // translucent materials last, so the opaque geometry behind them is already there
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    drawBatches(true);
+    glDepthMask(GL_TRUE);
+
+    if (m_lineCount > 0) {
+        m_lineShader->useProgram();
+        m_lineShader->uniformMatrix4fv("u_mvpMatrix", 1, m_modelViewProjection);
+
+        m_linePositionBuffer->bindAndEnableAttrib(m_lineShader->getAttribLocation("a_position"));
+        m_lineColorBuffer->bindAndEnableAttrib(m_lineShader->getAttribLocation("a_color"));
+        m_linePositionBuffer->drawArrayAs(SL_LINES, 0, m_lineCount * 2);
+        m_linePositionBuffer->disableAttribArray();
+        m_lineColorBuffer->disableAttribArray();
+    }
+
+    glDisable(GL_BLEND);
+    m_meshShader->endUse();
+
+    // the camera frame is drawn from client memory, which fails with buffers still bound
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void OverlayRenderer::release()
+{
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        delete m_batches[i].positionBuffer;
+        delete m_batches[i].normalBuffer;
+        delete m_batches[i].indexBuffer;
+    }
+    m_batches.clear();
+
+    delete m_linePositionBuffer;
+    delete m_lineColorBuffer;
+    m_linePositionBuffer = m_lineColorBuffer = 0;
+    m_lineCount = 0;
+
+    delete m_meshShader;
+    delete m_lineShader;
+    m_meshShader = m_lineShader = 0;
+}
+
+OverlayRenderer::Batch& OverlayRenderer::batchFor(int material, size_t vertexCount)
+{
+    // appends to the open batch of the material as long as its indices suffice
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        Batch& batch = m_batches[i];
+        if (batch.material == material && !batch.positionBuffer && batch.positions.size() / 3 + vertexCount <= MAX_BATCH_VERTICES) {
+            return batch;
+        }
+    }
+
+    m_batches.push_back(Batch(material));
+    return m_batches.back();
+}
+
+void OverlayRenderer::upload()
+{
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        Batch& batch = m_batches[i];
+        if (batch.positionBuffer || batch.indices.empty()) {
+            continue;
+        }
+
+        batch.positionBuffer = new SLGLBuffer();
+        batch.positionBuffer->generate(&batch.positions[0], (SLint) batch.positions.size() / 3, 3);
+        batch.normalBuffer = new SLGLBuffer();
+        batch.normalBuffer->generate(&batch.normals[0], (SLint) batch.normals.size() / 3, 3);
+        batch.indexBuffer = new SLGLBuffer();
+        batch.indexBuffer->generate(&batch.indices[0], (SLint) batch.indices.size(), 1, SL_UNSIGNED_SHORT, SL_ELEMENT_ARRAY_BUFFER);
+        batch.indexCount = (int) batch.indices.size();
+
+        // the GPU holds the only copy from now on
+        std::vector<float>().swap(batch.positions);
+        std::vector<float>().swap(batch.normals);
+        std::vector<unsigned short>().swap(batch.indices);
+    }
+
+    if ((int) m_linePositions.size() / 6 != m_lineCount && !m_linePositions.empty()) {
+        delete m_linePositionBuffer;
+        delete m_lineColorBuffer;
+
+        m_lineCount = (int) m_linePositions.size() / 6;
+        m_linePositionBuffer = new SLGLBuffer();
+        m_linePositionBuffer->generate(&m_linePositions[0], m_lineCount * 2, 3);
+        m_lineColorBuffer = new SLGLBuffer();
+        m_lineColorBuffer->generate(&m_lineColors[0], m_lineCount * 2, 4);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void OverlayRenderer::drawBatches(bool translucent)
+{
+    SLint positionLocation = m_meshShader->getAttribLocation("a_position");
+    SLint normalLocation = m_meshShader->getAttribLocation("a_normal");
+
+    for (size_t i = 0; i < m_batches.size(); i++) {
+        Batch& batch = m_batches[i];
+        const cv::Vec4f& diffuse = m_materials[batch.material];
+
+        if (!batch.positionBuffer || (diffuse[3] < 1.0f) != translucent) {
+            continue;
+        }
+
+        m_meshShader->uniform4fv("u_matDiffuse", 1, diffuse.val);
+        batch.positionBuffer->bindAndEnableAttrib(positionLocation);
+        batch.normalBuffer->bindAndEnableAttrib(normalLocation);
+        batch.indexBuffer->bindAndDrawElementsAs(SL_TRIANGLES, batch.indexCount);
+        batch.positionBuffer->disableAttribArray();
+        batch.normalBuffer->disableAttribArray();
+    }
+}
+
+}
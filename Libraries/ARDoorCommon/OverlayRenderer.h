@@ -0,0 +1,113 @@
+#ifndef OVERLAYRENDERER_H
+#define OVERLAYRENDERER_H
+
+#include "PoseFilter.h"
+#include <opencv2/core/core.hpp>
+#include <vector>
+
+class SLGLBuffer;
+class SLGLShaderProg;
+
+namespace ARDoor {
+
+/**
+ * Draws the augmented content with vertex buffer objects and GLSL shaders
+ * from SLProject. The geometry is collected on the CPU, uploaded once by
+ * initialize and only drawn afterwards. Meshes of the same material are
+ * merged into a batch, so every frame issues one draw call per material,
+ * or per 65536 vertices of a material because of the 16 bit indices.
+ *
+ * The SLProject headers pull in GLEW, so they are only included by the
+ * implementation and this header can be used next to other GL headers.
+ */
+class OverlayRenderer
+{
+public:
+    OverlayRenderer();
+    ~OverlayRenderer();
+
+    /**
+     * @param diffuse RGBA reflection, materials with alpha below 1 are blended over the camera image
+     * @return id of the material
+     */
+    int addMaterial(const cv::Vec4f& diffuse);
+
+    /**
+     * Adds an indexed triangle mesh in board coordinates, three indices per triangle
+     */
+    void addMesh(const std::vector<cv::Point3f>& positions, const std::vector<cv::Point3f>& normals, const std::vector<unsigned int>& indices, int material);
+
+    /**
+     * Adds an axis aligned box with flat shaded faces
+     */
+    void addBox(const cv::Point3f& min, const cv::Point3f& max, int material);
+
+    /**
+     * Adds a coloured line, all lines are drawn with a single call
+     */
+    void addLine(const cv::Point3f& from, const cv::Point3f& to, const cv::Vec4f& color);
+
+    /**
+     * Compiles the shaders and uploads the geometry, needs a current GL context.
+     * Geometry added afterwards is uploaded by the next call.
+     */
+    void initialize();
+
+    /**
+     * Builds the projection of the calibrated camera for the image the overlay is drawn on
+     * @param intrinsics camera matrix of the calibration
+     * @param imageSize size of the camera image filling the viewport
+     */
+    void setProjection(const cv::Mat& intrinsics, cv::Size imageSize, float nearPlane = 0.01f, float farPlane = 100.0f);
+
+    /**
+     * Draws all geometry placed on the board with the given pose
+     */
+    void draw(const Pose& pose);
+
+    /**
+     * Deletes buffers and shaders, needs the GL context they have been created in.
+     * Uploaded meshes are dropped, their vertices only exist on the GPU.
+     */
+    void release();
+
+private:
+    struct Batch
+    {
+        int material;
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<unsigned short> indices;
+        int indexCount;
+        SLGLBuffer *positionBuffer;
+        SLGLBuffer *normalBuffer;
+        SLGLBuffer *indexBuffer;
+
+        Batch(int material);
+    };
+
+    Batch& batchFor(int material, size_t vertexCount);
+    void upload();
+    void drawBatches(bool translucent);
+
+    std::vector<cv::Vec4f> m_materials;
+    std::vector<Batch>     m_batches;
+
+    std::vector<float>     m_linePositions;
+    std::vector<float>     m_lineColors;
+    int                    m_lineCount;
+    SLGLBuffer             *m_linePositionBuffer;
+    SLGLBuffer             *m_lineColorBuffer;
+
+    SLGLShaderProg         *m_meshShader;
+    SLGLShaderProg         *m_lineShader;
+
+    // column major, as expected by GL
+    float                  m_projection[16];
+    float                  m_modelViewProjection[16];
+    float                  m_normalMatrix[9];
+};
+
+}
+
+#endif // OVERLAYRENDERER_H
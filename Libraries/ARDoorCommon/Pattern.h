@@ -19,6 +19,17 @@ namespace ARDoor
         std::vector<cv::Point2f> points2d;
         std::vector<cv::Point3f> points3d;
     };
+    
+    /**
+     * Location of a pattern found in a camera frame
+     */
+    struct PatternTrackingInfo
+    {
+        // maps the pattern image onto the frame
+        cv::Mat homography;
+        // corners of the pattern in the frame, in the order of Pattern::points3d
+        std::vector<cv::Point2f> points2d;
+    };
 }
 
 #endif
@@ -0,0 +1,244 @@
+
+#include "PatternDatabase.h"
+#include "ImageUtils.h"
+#include <algorithm>
+#include <functional>
+
+namespace ARDoor
+{
+    // fewer matches do not determine a homography reliably
+    static const size_t MIN_INLIERS = 8;
+
+    static bool hasMoreInliers(const PatternMatch &a, const PatternMatch &b)
+    {
+        return a.inliers > b.inliers;
+    }
+
+    PatternDatabase::PatternDatabase(cv::Ptr<cv::FeatureDetector> detector, cv::Ptr<cv::DescriptorExtractor> descriptorExtractor)
+        : extractor(detector, descriptorExtractor)
+    {
+        ratioThreshold = 0.8f;
+
+        if (extractor.getDescriptorType() == CV_8U)
+        {
+            // hamming distance on binary descriptors
+            matcher = new cv::FlannBasedMatcher(new cv::flann::LshIndexParams(12, 20, 2));
+        }
+        else
+        {
+            matcher = new cv::FlannBasedMatcher(new cv::flann::KDTreeIndexParams(4));
+        }
+    }
+
+    int PatternDatabase::add(const cv::Mat &image, const std::string &name)
+    {
+        Pattern pattern;
+        extractor.extract(image, pattern);
+
+        return add(pattern, name);
+    }
+
+    int PatternDatabase::add(const Pattern &pattern, const std::string &name)
+    {
+        patterns.push_back(pattern);
+        names.push_back(name);
+
+        return (int) patterns.size() - 1;
+    }
+
+    void PatternDatabase::train()
+    {
+        matcher->clear();
+
+        // the position in this list becomes the image index of the matches, which is the pattern id
+        std::vector<cv::Mat> descriptors;
+        for (size_t i = 0; i < patterns.size(); i++)
+        {
+            descriptors.push_back(patterns[i].descriptors);
+        }
+
+        matcher->add(descriptors);
+        matcher->train();
+    }
+
+    bool PatternDatabase::findPatterns(const cv::Mat &image, std::vector<PatternMatch> &found, int maxCandidates)
+    {
+        found.clear();
+
+        if (patterns.empty() || matcher->empty())
+        {
+            return false;
+        }
+
+        ImageUtils::convertToGray(image, grayImage);
+
+        if (!extractor.extractFeatures(grayImage, queryKeypoints, queryDescriptors))
+        {
+            return false;
+        }
+
+        matcher->knnMatch(queryDescriptors, knnMatches, 2);
+
+        votes.resize(patterns.size());
+        for (size_t i = 0; i < votes.size(); i++)
+        {
+            votes[i].clear();
+        }
+
+        for (size_t i = 0; i < knnMatches.size(); i++)
+        {
+            const std::vector<cv::DMatch> &candidates = knnMatches[i];
+
+            if (candidates.size() == 2 && candidates[0].distance < ratioThreshold * candidates[1].distance)
+            {
+                votes[candidates[0].imgIdx].push_back(candidates[0]);
+            }
+        }
+
+        // only the patterns with the most votes are worth a homography
+        std::vector<std::pair<size_t, int> > ranking;
+        for (size_t i = 0; i < votes.size(); i++)
+        {
+            if (votes[i].size() >= MIN_INLIERS)
+            {
+                ranking.push_back(std::make_pair(votes[i].size(), (int) i));
+            }
+        }
+
+        size_t candidateCount = std::min(ranking.size(), (size_t) std::max(maxCandidates, 0));
+        std::partial_sort(ranking.begin(), ranking.begin() + candidateCount, ranking.end(), std::greater<std::pair<size_t, int> >());
+
+        for (size_t i = 0; i < candidateCount; i++)
+        {
+            PatternMatch match;
+            if (verify(ranking[i].second, votes[ranking[i].second], match))
+            {
+                found.push_back(match);
+            }
+        }
+
+        std::sort(found.begin(), found.end(), hasMoreInliers);
+
+        return !found.empty();
+    }
+
+    size_t PatternDatabase::size() const
+    {
+        return patterns.size();
+    }
+
+    const Pattern& PatternDatabase::getPattern(int id) const
+    {
+        return patterns[id];
+    }
+
+    const std::string& PatternDatabase::getName(int id) const
+    {
+        return names[id];
+    }
+
+    bool PatternDatabase::save(const std::string &path) const
+    {
+        cv::FileStorage storage(path, cv::FileStorage::WRITE);
+        if (!storage.isOpened())
+        {
+            return false;
+        }
+
+        storage << "patterns" << "[";
+        for (size_t i = 0; i < patterns.size(); i++)
+        {
+            const Pattern &pattern = patterns[i];
+
+            storage << "{";
+            storage << "name" << names[i];
+            storage << "width" << pattern.size.width;
+            storage << "height" << pattern.size.height;
+            cv::write(storage, "keypoints", pattern.keypoints);
+            storage << "descriptors" << pattern.descriptors;
+            storage << "points2d" << pattern.points2d;
+            storage << "points3d" << pattern.points3d;
+            storage << "}";
+        }
+        storage << "]";
+
+        return true;
+    }
+
+    bool PatternDatabase::load(const std::string &path)
+    {
+        cv::FileStorage storage(path, cv::FileStorage::READ);
+        if (!storage.isOpened())
+        {
+            return false;
+        }
+
+        cv::FileNode nodes = storage["patterns"];
+        if (nodes.type() != cv::FileNode::SEQ)
+        {
+            return false;
+        }
+
+        patterns.clear();
+        names.clear();
+
+        for (cv::FileNodeIterator it = nodes.begin(); it != nodes.end(); ++it)
+        {
+            const cv::FileNode &node = *it;
+            Pattern pattern;
+            std::string name;
+
+            node["name"] >> name;
+            node["width"] >> pattern.size.width;
+            node["height"] >> pattern.size.height;
+            cv::read(node["keypoints"], pattern.keypoints);
+            node["descriptors"] >> pattern.descriptors;
+            node["points2d"] >> pattern.points2d;
+            node["points3d"] >> pattern.points3d;
+
+            add(pattern, name);
+        }
+
+        train();
+
+        return true;
+    }
+
+    void PatternDatabase::setRatioThreshold(float ratio)
+    {
+        ratioThreshold = ratio;
+    }
+
+    bool PatternDatabase::verify(int patternId, const std::vector<cv::DMatch> &matches, PatternMatch &result)
+    {
+        const Pattern &pattern = patterns[patternId];
+
+        srcPoints.resize(matches.size());
+        dstPoints.resize(matches.size());
+
+        // the train index of a match is local to its pattern
+        for (size_t i = 0; i < matches.size(); i++)
+        {
+            srcPoints[i] = pattern.keypoints[matches[i].trainIdx].pt;
+            dstPoints[i] = queryKeypoints[matches[i].queryIdx].pt;
+        }
+
+        cv::Mat homography = cv::findHomography(srcPoints, dstPoints, CV_FM_RANSAC, 3, inliers);
+        if (homography.empty())
+        {
+            return false;
+        }
+
+        result.patternId = patternId;
+        result.inliers = cv::countNonZero(inliers);
+        if ((size_t) result.inliers < MIN_INLIERS)
+        {
+            return false;
+        }
+
+        result.info.homography = homography;
+        cv::perspectiveTransform(pattern.points2d, result.info.points2d, homography);
+
+        return true;
+    }
+}
@@ -0,0 +1,108 @@
+
+#ifndef __ARDoor__PatternDatabase__
+#define __ARDoor__PatternDatabase__
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Pattern.h"
+#include "PatternExtractor.h"
+
+namespace ARDoor
+{
+    /**
+     * Pattern recognised in a camera frame
+     */
+    struct PatternMatch
+    {
+        int patternId;
+        // matches confirmed by the homography
+        int inliers;
+        PatternTrackingInfo info;
+    };
+
+    /**
+     * Recognises many patterns at once. The descriptors of all patterns are
+     * merged into a single matcher index, every descriptor remembers the
+     * pattern it belongs to. The matches of a frame vote for their patterns
+     * and only the patterns with the most votes are verified with a
+     * homography, so the cost of a frame hardly grows with the number of
+     * patterns.
+     */
+    class PatternDatabase
+    {
+    public:
+        PatternDatabase(
+            cv::Ptr<cv::FeatureDetector> detector = new cv::ORB(1000),
+            cv::Ptr<cv::DescriptorExtractor> descriptorExtractor = new cv::FREAK(false, false)
+        );
+
+        /**
+         * Extracts the features of the image and adds it as a new pattern
+         * @return id of the pattern
+         */
+        int add(const cv::Mat &image, const std::string &name);
+
+        /**
+         * Adds a pattern whose features have already been extracted
+         * @return id of the pattern
+         */
+        int add(const Pattern &pattern, const std::string &name);
+
+        /**
+         * Builds the shared index, has to be called after patterns have been added
+         */
+        void train();
+
+        /**
+         * @param image camera frame, BGR, BGRA or GRAY
+         * @param found receives the recognised patterns, best first
+         * @param maxCandidates number of patterns verified per frame
+         * @return true if at least one pattern has been found
+         */
+        bool findPatterns(const cv::Mat &image, std::vector<PatternMatch> &found, int maxCandidates = 3);
+
+        size_t size() const;
+        const Pattern& getPattern(int id) const;
+        const std::string& getName(int id) const;
+
+        /**
+         * Writes names, keypoints and descriptors of all patterns, the pattern images are not stored
+         */
+        bool save(const std::string &path) const;
+
+        /**
+         * Replaces all patterns with the ones in the file and trains the index
+         * @return false if the file could not be read
+         */
+        bool load(const std::string &path);
+
+        /**
+         * Maximal distance ratio between the best and the second best match, default 0.8
+         */
+        void setRatioThreshold(float ratio);
+
+    private:
+        bool verify(int patternId, const std::vector<cv::DMatch> &matches, PatternMatch &result);
+
+        PatternExtractor extractor;
+        cv::Ptr<cv::DescriptorMatcher> matcher;
+        std::vector<Pattern> patterns;
+        std::vector<std::string> names;
+        float ratioThreshold;
+
+        // buffers reused from frame to frame
+        cv::Mat grayImage;
+        std::vector<cv::KeyPoint> queryKeypoints;
+        cv::Mat queryDescriptors;
+        std::vector<std::vector<cv::DMatch> > knnMatches;
+        // good matches grouped by pattern
+        std::vector<std::vector<cv::DMatch> > votes;
+        std::vector<cv::Point2f> srcPoints;
+        std::vector<cv::Point2f> dstPoints;
+        std::vector<unsigned char> inliers;
+    };
+}
+
+#endif
@@ -0,0 +1,167 @@
+
+#include "PatternDetector.h"
+#include "ImageUtils.h"
+
+namespace ARDoor
+{
+    // fewer matches do not determine a homography reliably
+    static const size_t MIN_INLIERS = 8;
+
+    PatternDetector::PatternDetector(cv::Ptr<cv::FeatureDetector> detector, cv::Ptr<cv::DescriptorExtractor> descriptorExtractor, bool refineHomography)
+        : extractor(detector, descriptorExtractor)
+    {
+        this->refineHomography = refineHomography;
+        ratioThreshold = 0.8f;
+        reprojectionThreshold = 3;
+
+        if (extractor.getDescriptorType() == CV_8U)
+        {
+            // hamming distance on binary descriptors
+            matcher = new cv::FlannBasedMatcher(new cv::flann::LshIndexParams(12, 20, 2));
+        }
+        else
+        {
+            matcher = new cv::FlannBasedMatcher(new cv::flann::KDTreeIndexParams(4));
+        }
+    }
+
+    void PatternDetector::train(const Pattern &pattern)
+    {
+        this->pattern = pattern;
+        previousCorners.clear();
+
+        matcher->clear();
+
+        std::vector<cv::Mat> descriptors(1);
+        descriptors[0] = pattern.descriptors.clone();
+        matcher->add(descriptors);
+
+        // builds the index, every frame afterwards only queries it
+        matcher->train();
+    }
+
+    bool PatternDetector::findPattern(const cv::Mat &image, PatternTrackingInfo &info)
+    {
+        if (pattern.descriptors.empty())
+        {
+            return false;
+        }
+
+        ImageUtils::convertToGray(image, grayImage);
+
+        // the pattern is searched close to where it was in the last frame first
+        cv::Rect region = previousCorners.empty() ? cv::Rect() : predictSearchRegion();
+        bool found = region.area() > 0 && findRoughHomography(region);
+
+        if (!found && !findRoughHomography(cv::Rect()))
+        {
+            previousCorners.clear();
+            return false;
+        }
+
+        info.homography = roughHomography;
+
+        if (refineHomography)
+        {
+            // the frame warped back onto the pattern only differs from it by a small residual homography
+            cv::warpPerspective(grayImage, warpedImage, roughHomography, pattern.size, cv::WARP_INVERSE_MAP | cv::INTER_CUBIC);
+
+            if (extractor.extractFeatures(warpedImage, queryKeypoints, queryDescriptors))
+            {
+                matchDescriptors(queryDescriptors, matches);
+                if (findHomography(queryKeypoints, matches, refinedHomography))
+                {
+                    info.homography = roughHomography * refinedHomography;
+                }
+            }
+        }
+
+        cv::perspectiveTransform(pattern.points2d, info.points2d, info.homography);
+        previousCorners = info.points2d;
+
+        return true;
+    }
+
+    void PatternDetector::reset()
+    {
+        previousCorners.clear();
+    }
+
+    void PatternDetector::setRatioThreshold(float ratio)
+    {
+        ratioThreshold = ratio;
+    }
+
+    void PatternDetector::setReprojectionThreshold(double threshold)
+    {
+        reprojectionThreshold = threshold;
+    }
+
+    bool PatternDetector::findRoughHomography(const cv::Rect &region)
+    {
+        if (!extractor.extractFeatures(grayImage, queryKeypoints, queryDescriptors, region))
+        {
+            return false;
+        }
+
+        matchDescriptors(queryDescriptors, matches);
+
+        return findHomography(queryKeypoints, matches, roughHomography);
+    }
+
+    cv::Rect PatternDetector::predictSearchRegion() const
+    {
+        cv::Rect bounds = cv::boundingRect(previousCorners);
+
+        // leaves room for the movement since the last frame
+        int marginX = bounds.width / 4;
+        int marginY = bounds.height / 4;
+
+        cv::Rect region(bounds.x - marginX, bounds.y - marginY, bounds.width + 2 * marginX, bounds.height + 2 * marginY);
+
+        return region & cv::Rect(0, 0, grayImage.cols, grayImage.rows);
+    }
+
+    void PatternDetector::matchDescriptors(const cv::Mat &descriptors, std::vector<cv::DMatch> &goodMatches)
+    {
+        goodMatches.clear();
+
+        matcher->knnMatch(descriptors, knnMatches, 2);
+
+        for (size_t i = 0; i < knnMatches.size(); i++)
+        {
+            const std::vector<cv::DMatch> &candidates = knnMatches[i];
+
+            // LSH may return less than two neighbours, such matches can not be told apart from ambiguous ones
+            if (candidates.size() == 2 && candidates[0].distance < ratioThreshold * candidates[1].distance)
+            {
+                goodMatches.push_back(candidates[0]);
+            }
+        }
+    }
+
+    bool PatternDetector::findHomography(const std::vector<cv::KeyPoint> &keypoints, const std::vector<cv::DMatch> &goodMatches, cv::Mat &homography)
+    {
+        if (goodMatches.size() < MIN_INLIERS)
+        {
+            return false;
+        }
+
+        srcPoints.resize(goodMatches.size());
+        dstPoints.resize(goodMatches.size());
+
+        for (size_t i = 0; i < goodMatches.size(); i++)
+        {
+            srcPoints[i] = pattern.keypoints[goodMatches[i].trainIdx].pt;
+            dstPoints[i] = keypoints[goodMatches[i].queryIdx].pt;
+        }
+
+        homography = cv::findHomography(srcPoints, dstPoints, CV_FM_RANSAC, reprojectionThreshold, inliers);
+        if (homography.empty())
+        {
+            return false;
+        }
+
+        return (size_t) cv::countNonZero(inliers) >= MIN_INLIERS;
+    }
+}
@@ -0,0 +1,85 @@
+
+#ifndef __ARDoor__PatternDetector__
+#define __ARDoor__PatternDetector__
+
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Pattern.h"
+#include "PatternExtractor.h"
+
+namespace ARDoor
+{
+    /**
+     * Finds a trained pattern in camera frames by matching feature
+     * descriptors. The descriptors of the pattern are indexed once when it
+     * is trained, binary descriptors (ORB, FREAK) with locality sensitive
+     * hashing, all others with randomized kd-trees.
+     */
+    class PatternDetector
+    {
+    public:
+        PatternDetector(
+            cv::Ptr<cv::FeatureDetector> detector = new cv::ORB(1000),
+            cv::Ptr<cv::DescriptorExtractor> descriptorExtractor = new cv::FREAK(false, false),
+            bool refineHomography = true
+        );
+
+        /**
+         * Builds the matcher index for the given pattern, replaces the previous pattern
+         */
+        void train(const Pattern &pattern);
+
+        /**
+         * @param image camera frame, BGR, BGRA or GRAY
+         * @param info receives the homography and the corners of the pattern in the frame
+         * @return true if the pattern has been found
+         */
+        bool findPattern(const cv::Mat &image, PatternTrackingInfo &info);
+
+        /**
+         * Forgets the last position, the next frame is searched completely
+         */
+        void reset();
+
+        /**
+         * Maximal distance ratio between the best and the second best match, default 0.8
+         */
+        void setRatioThreshold(float ratio);
+
+        /**
+         * Maximal reprojection error of RANSAC inliers in pixels, default 3
+         */
+        void setReprojectionThreshold(double threshold);
+
+    private:
+        bool findRoughHomography(const cv::Rect &region);
+        cv::Rect predictSearchRegion() const;
+        void matchDescriptors(const cv::Mat &descriptors, std::vector<cv::DMatch> &goodMatches);
+        bool findHomography(const std::vector<cv::KeyPoint> &keypoints, const std::vector<cv::DMatch> &goodMatches, cv::Mat &homography);
+
+        PatternExtractor extractor;
+        cv::Ptr<cv::DescriptorMatcher> matcher;
+        Pattern pattern;
+
+        bool refineHomography;
+        float ratioThreshold;
+        double reprojectionThreshold;
+
+        // buffers reused from frame to frame
+        cv::Mat grayImage;
+        cv::Mat warpedImage;
+        std::vector<cv::KeyPoint> queryKeypoints;
+        cv::Mat queryDescriptors;
+        std::vector<std::vector<cv::DMatch> > knnMatches;
+        std::vector<cv::DMatch> matches;
+        std::vector<cv::Point2f> srcPoints;
+        std::vector<cv::Point2f> dstPoints;
+        std::vector<unsigned char> inliers;
+        cv::Mat roughHomography;
+        cv::Mat refinedHomography;
+        // corners found in the last frame, empty if the pattern was lost
+        std::vector<cv::Point2f> previousCorners;
+    };
+}
+
+#endif
@@ -8,38 +8,160 @@ namespace ARDoor
     {
         featureDetector = detector;
         descriptorExtractor = extractor;
+        
+        cv::Ptr<cv::Feature2D> feature = detector.ptr<cv::Feature2D>();
+        if (!feature.empty() && feature == extractor.ptr<cv::Feature2D>())
+        {
+            feature2d = feature;
+        }
+        
+        pyramidLevels = 1;
+        pyramidScale = 1.5;
     }
     
-    void PatternExtractor::extract(const cv::Mat &img, Pattern &pattern)
+    bool PatternExtractor::extract(const cv::Mat &img, Pattern &pattern)
     {
         initializePattern(img, pattern);
-        extractFeatures(img, pattern.keypoints, pattern.descriptors);
+        return extractFeatures(pattern.grayImage, pattern.keypoints, pattern.descriptors);
+    }
+    
+    int PatternExtractor::getDescriptorType() const
+    {
+        return descriptorExtractor->descriptorType();
+    }
+    
+    void PatternExtractor::setPyramid(int levels, double scale)
+    {
+        pyramidLevels = std::max(levels, 1);
+        pyramidScale = scale;
     }
     
-    bool PatternExtractor::extractFeatures(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors) const
+    bool PatternExtractor::extractFeatures(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors, const cv::Rect &roi, const cv::Mat &mask)
     {
         assert(!img.empty());
         assert(img.channels() == 1);
+        assert(mask.empty() || mask.size() == img.size());
         
-        featureDetector->detect(img, keypoints);        
-        if (keypoints.empty())
+        cv::Rect bounds(0, 0, img.cols, img.rows);
+        cv::Rect region = roi.area() > 0 ? roi & bounds : bounds;
+        if (region.area() == 0)
         {
+            keypoints.clear();
             return false;
         }
         
-        descriptorExtractor->compute(img, keypoints, descriptors);
+        // views, nothing is copied
+        cv::Mat image = img(region);
+        cv::Mat regionMask = mask.empty() ? cv::Mat() : mask(region);
+        
+        if (pyramidLevels > 1)
+        {
+            extractLevels(image, regionMask, keypoints, descriptors);
+        }
+        else if (!feature2d.empty())
+        {
+            (*feature2d)(image, regionMask, keypoints, descriptors);
+        }
+        else
+        {
+            featureDetector->detect(image, keypoints, regionMask);
+            if (!keypoints.empty())
+            {
+                descriptorExtractor->compute(image, keypoints, descriptors);
+            }
+        }
+        
         if (keypoints.empty())
         {
             return false;
         }
         
+        if (region.x != 0 || region.y != 0)
+        {
+            cv::Point2f offset(region.x, region.y);
+            for (size_t i = 0; i < keypoints.size(); i++)
+            {
+                keypoints[i].pt += offset;
+            }
+        }
+        
         return true;
     }
     
+    void PatternExtractor::extractLevels(const cv::Mat &img, const cv::Mat &mask, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors)
+    {
+        pyramid.resize(pyramidLevels);
+        pyramidMasks.resize(pyramidLevels);
+        levelKeypoints.resize(pyramidLevels);
+        levelDescriptors.resize(pyramidLevels);
+        
+        int total = 0;
+        double scale = 1;
+        
+        for (int level = 0; level < pyramidLevels; level++, scale *= pyramidScale)
+        {
+            if (level == 0)
+            {
+                pyramid[0] = img;
+                pyramidMasks[0] = mask;
+            }
+            else
+            {
+                // every level is computed from the one before, which is cheaper than from the image
+                cv::Size size(cvRound(img.cols / scale), cvRound(img.rows / scale));
+                cv::resize(pyramid[level - 1], pyramid[level], size, 0, 0, cv::INTER_AREA);
+                if (!mask.empty())
+                {
+                    cv::resize(pyramidMasks[level - 1], pyramidMasks[level], size, 0, 0, cv::INTER_NEAREST);
+                }
+            }
+            
+            std::vector<cv::KeyPoint> &found = levelKeypoints[level];
+            
+            featureDetector->detect(pyramid[level], found, pyramidMasks[level]);
+            if (!found.empty())
+            {
+                descriptorExtractor->compute(pyramid[level], found, levelDescriptors[level]);
+            }
+            
+            // keypoints are reported at the scale of the image
+            for (size_t i = 0; i < found.size(); i++)
+            {
+                found[i].pt *= (float) scale;
+                found[i].size *= (float) scale;
+                found[i].octave = level;
+            }
+            
+            total += found.size();
+        }
+        
+        keypoints.clear();
+        if (total == 0)
+        {
+            return;
+        }
+        
+        descriptors.create(total, descriptorExtractor->descriptorSize(), descriptorExtractor->descriptorType());
+        
+        int row = 0;
+        for (int level = 0; level < pyramidLevels; level++)
+        {
+            const std::vector<cv::KeyPoint> &found = levelKeypoints[level];
+            if (found.empty())
+            {
+                continue;
+            }
+            
+            keypoints.insert(keypoints.end(), found.begin(), found.end());
+            levelDescriptors[level].copyTo(descriptors.rowRange(row, row + found.size()));
+            row += found.size();
+        }
+    }
+    
     void PatternExtractor::initializePattern(const cv::Mat &img, Pattern &pattern)
     {
         pattern.size = cv::Size(img.cols, img.rows);
-        pattern.frame = img.clone();
+        pattern.frame = img;
         ImageUtils::convertToGray(img, pattern.grayImage);
         
         pattern.points2d.resize(4);
@@ -13,13 +13,59 @@ namespace ARDoor
     {
     public:
         PatternExtractor(cv::Ptr<cv::FeatureDetector> detector, cv::Ptr<cv::DescriptorExtractor> extractor);
-        void extract(const cv::Mat &img, Pattern &pattern);
+        
+        /**
+         * Initializes the pattern from the image and extracts its features.
+         * The pattern references the image, it is not copied.
+         * @return false if no features have been found
+         */
+        bool extract(const cv::Mat &img, Pattern &pattern);
+        
+        /**
+         * Detects keypoints and computes their descriptors. If the detector is
+         * also the descriptor extractor, e.g. ORB, both run in one pass over
+         * the same image pyramid. The output vectors are reused, so callers
+         * should keep them from frame to frame.
+         * @param img gray scale image
+         * @param roi only this part of the image is searched, the keypoints are
+         *            still in image coordinates. An empty rectangle searches the whole image.
+         * @param mask optional, of the size of img, features are only detected where it is non-zero
+         * @return false if no features have been found
+         */
+        bool extractFeatures(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors,
+                             const cv::Rect &roi = cv::Rect(), const cv::Mat &mask = cv::Mat());
+        
+        /**
+         * Detects and describes features on each level of an image pyramid
+         * built once per image, for detector and extractor pairs which do
+         * not share a pyramid on their own (e.g. FAST and FREAK). The
+         * detector should then only work on a single scale.
+         * @param levels number of levels including the image, 1 turns the pyramid off
+         * @param scale factor between two levels
+         */
+        void setPyramid(int levels, double scale = 1.5);
+        
+        /**
+         * @return type of the descriptors, CV_8U for binary descriptors
+         */
+        int getDescriptorType() const;
         
     private:
         cv::Ptr<cv::FeatureDetector> featureDetector;
         cv::Ptr<cv::DescriptorExtractor> descriptorExtractor;
+        // set if detector and extractor are the same object
+        cv::Ptr<cv::Feature2D> feature2d;
+        
+        int pyramidLevels;
+        double pyramidScale;
+        
+        // buffers reused from image to image
+        std::vector<cv::Mat> pyramid;
+        std::vector<cv::Mat> pyramidMasks;
+        std::vector<std::vector<cv::KeyPoint> > levelKeypoints;
+        std::vector<cv::Mat> levelDescriptors;
         
-        bool extractFeatures(const cv::Mat &img, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors) const;
+        void extractLevels(const cv::Mat &img, const cv::Mat &mask, std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors);
         void initializePattern(const cv::Mat &img, Pattern &pattern);
     };
     
@@ -0,0 +1,236 @@
+#include "PipelineProfiler.h"
+#include <cmath>
+#include <iomanip>
+
+namespace ARDoor {
+
+// marks a window slot which has not been filled yet
+static const unsigned short EMPTY_SLOT = 0xFFFF;
+
+static long long nowInMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(PipelineProfiler::Clock::now().time_since_epoch()).count();
+}
+
+StageStatistics::StageStatistics(const std::string &name)
+    : name(name), frames(0), allocations(0), bytes(0)
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        histogram[i] = 0;
+    }
+
+    for (int i = 0; i < WINDOW_SIZE; ++i)
+    {
+        window[i] = EMPTY_SLOT;
+    }
+}
+
+void StageStatistics::record(double microseconds, unsigned int allocations, size_t bytes)
+{
+    unsigned int bucket = bucketOf((unsigned long) microseconds);
+    unsigned long frame = frames.fetch_add(1);
+
+    // the sample leaving the window is taken out of the histogram again
+    unsigned short evicted = window[frame % WINDOW_SIZE].exchange(bucket);
+    if (evicted != EMPTY_SLOT)
+    {
+        histogram[evicted].fetch_sub(1);
+    }
+    histogram[bucket].fetch_add(1);
+
+    this->allocations += allocations;
+    this->bytes += bytes;
+}
+
+const std::string& StageStatistics::getName() const
+{
+    return name;
+}
+
+unsigned long StageStatistics::getFrameCount() const
+{
+    return frames;
+}
+
+double StageStatistics::getPercentile(double percentile) const
+{
+    unsigned int counts[BUCKET_COUNT];
+    unsigned long total = 0;
+
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        counts[i] = histogram[i];
+        total += counts[i];
+    }
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    unsigned long rank = (unsigned long) std::ceil(percentile * total);
+    unsigned long seen = 0;
+
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank && counts[i] > 0)
+        {
+            return upperBoundOf(i);
+        }
+    }
+
+    return upperBoundOf(BUCKET_COUNT - 1);
+}
+
+double StageStatistics::getAllocationsPerFrame() const
+{
+    unsigned long count = frames;
+    return count == 0 ? 0 : (double) allocations / count;
+}
+
+double StageStatistics::getBytesPerFrame() const
+{
+    unsigned long count = frames;
+    return count == 0 ? 0 : (double) bytes / count;
+}
+
+unsigned int StageStatistics::bucketOf(unsigned long microseconds)
+{
+    if (microseconds < SUB_BUCKETS)
+    {
+        return microseconds;
+    }
+
+    unsigned int exponent = 0;
+    while ((microseconds >> (exponent + 1)) != 0)
+    {
+        ++exponent;
+    }
+
+    unsigned int bucket = (exponent - 2) * SUB_BUCKETS + ((microseconds >> (exponent - 3)) & (SUB_BUCKETS - 1));
+
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+double StageStatistics::upperBoundOf(unsigned int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+    {
+        return bucket + 1;
+    }
+
+    unsigned int exponent = bucket / SUB_BUCKETS + 2;
+    unsigned int subBucket = bucket % SUB_BUCKETS;
+
+    return std::ldexp((double) (SUB_BUCKETS + subBucket + 1), exponent - 3);
+}
+
+PipelineProfiler::PipelineProfiler()
+    : dumpInterval(0), lastDump(nowInMicroseconds())
+{
+}
+
+PipelineProfiler::~PipelineProfiler()
+{
+    setStages(std::vector<std::string>());
+}
+
+void PipelineProfiler::setStages(const std::vector<std::string> &names)
+{
+    for (std::vector<StageStatistics*>::iterator it = stages.begin(); it != stages.end(); ++it)
+    {
+        delete *it;
+    }
+    stages.clear();
+
+    for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it)
+    {
+        stages.push_back(new StageStatistics(*it));
+    }
+}
+
+void PipelineProfiler::record(size_t stage, double microseconds, unsigned int allocations, size_t bytes)
+{
+    if (stage < stages.size())
+    {
+        stages[stage]->record(microseconds, allocations, bytes);
+    }
+}
+
+void PipelineProfiler::frameFinished()
+{
+    long long interval = dumpInterval;
+    if (interval == 0)
+    {
+        return;
+    }
+
+    long long now = nowInMicroseconds();
+    long long last = lastDump;
+
+    // only the thread winning the exchange prints
+    if (now - last >= interval && lastDump.compare_exchange_strong(last, now))
+    {
+        dump(std::cout);
+    }
+}
+
+void PipelineProfiler::setDumpInterval(double seconds)
+{
+    dumpInterval = (long long) (seconds * 1e6);
+}
+
+std::vector<StageReport> PipelineProfiler::getReport() const
+{
+    std::vector<StageReport> report;
+
+    for (std::vector<StageStatistics*>::const_iterator it = stages.begin(); it != stages.end(); ++it)
+    {
+        StageStatistics* statistics = *it;
+        StageReport entry;
+
+        entry.name = statistics->getName();
+        entry.frames = statistics->getFrameCount();
+        entry.p50 = statistics->getPercentile(0.50);
+        entry.p95 = statistics->getPercentile(0.95);
+        entry.p99 = statistics->getPercentile(0.99);
+        entry.allocationsPerFrame = statistics->getAllocationsPerFrame();
+        entry.bytesPerFrame = statistics->getBytesPerFrame();
+
+        report.push_back(entry);
+    }
+
+    return report;
+}
+
+void PipelineProfiler::dump(std::ostream &out) const
+{
+    std::vector<StageReport> report = getReport();
+
+    out << std::left << std::setw(20) << "stage"
+        << std::right << std::setw(10) << "frames"
+        << std::setw(10) << "p50 ms"
+        << std::setw(10) << "p95 ms"
+        << std::setw(10) << "p99 ms"
+        << std::setw(10) << "allocs"
+        << std::setw(12) << "MB/frame" << std::endl;
+
+    for (std::vector<StageReport>::iterator it = report.begin(); it != report.end(); ++it)
+    {
+        out << std::left << std::setw(20) << it->name
+            << std::right << std::setw(10) << it->frames
+            << std::fixed << std::setprecision(2)
+            << std::setw(10) << it->p50 / 1000.0
+            << std::setw(10) << it->p95 / 1000.0
+            << std::setw(10) << it->p99 / 1000.0
+            << std::setw(10) << it->allocationsPerFrame
+            << std::setw(12) << it->bytesPerFrame / (1024.0 * 1024.0) << std::endl;
+    }
+
+    out.unsetf(std::ios_base::floatfield);
+    out.flush();
+}
+
+}
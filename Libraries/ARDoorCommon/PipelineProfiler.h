@@ -0,0 +1,104 @@
+#ifndef PIPELINEPROFILER_H
+#define PIPELINEPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ARDoor {
+
+/**
+ * Rolling statistics of a single pipeline stage. The stage's thread
+ * records samples while any other thread may read percentiles, neither
+ * side takes a lock.
+ */
+class StageStatistics
+{
+public:
+    StageStatistics(const std::string& name);
+
+    void record(double microseconds, unsigned int allocations, size_t bytes);
+
+    const std::string& getName() const;
+    unsigned long getFrameCount() const;
+
+    /**
+     * @param percentile value between 0 and 1
+     * @return upper bound of the processing time in microseconds within the recent window
+     */
+    double getPercentile(double percentile) const;
+    double getAllocationsPerFrame() const;
+    double getBytesPerFrame() const;
+
+private:
+    // samples taken into account for the percentiles
+    enum { WINDOW_SIZE = 512 };
+    // values up to 8us get their own bucket, above that every octave is split into 8 buckets
+    enum { SUB_BUCKETS = 8, BUCKET_COUNT = 30 * SUB_BUCKETS };
+
+    static unsigned int bucketOf(unsigned long microseconds);
+    static double upperBoundOf(unsigned int bucket);
+
+    std::string name;
+    std::atomic<unsigned long> frames;
+    std::atomic<unsigned long> allocations;
+    std::atomic<unsigned long long> bytes;
+    std::atomic<unsigned int> histogram[BUCKET_COUNT];
+    std::atomic<unsigned short> window[WINDOW_SIZE];
+};
+
+struct StageReport
+{
+    std::string name;
+    unsigned long frames;
+    double p50;
+    double p95;
+    double p99;
+    double allocationsPerFrame;
+    double bytesPerFrame;
+};
+
+/**
+ * Collects timing, allocation and memory traffic figures for every stage of
+ * an image pipeline and optionally prints them at a fixed interval.
+ */
+class PipelineProfiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    PipelineProfiler();
+    ~PipelineProfiler();
+
+    /**
+     * Resets the statistics, must not be called while frames are processed.
+     */
+    void setStages(const std::vector<std::string>& names);
+
+    void record(size_t stage, double microseconds, unsigned int allocations, size_t bytes);
+
+    /**
+     * Called once the last stage is done with a frame, prints the
+     * statistics if the dump interval has elapsed.
+     */
+    void frameFinished();
+
+    /**
+     * @param seconds time between two dumps to stdout, 0 disables them
+     */
+    void setDumpInterval(double seconds);
+
+    std::vector<StageReport> getReport() const;
+    void dump(std::ostream& out) const;
+
+private:
+    std::vector<StageStatistics*> stages;
+    std::atomic<long long> dumpInterval;
+    std::atomic<long long> lastDump;
+};
+
+}
+
+#endif // PIPELINEPROFILER_H
@@ -0,0 +1,185 @@
+#include "PoseFilter.h"
+#include <cmath>
+
+namespace ARDoor {
+
+// state: translation, quaternion (w, x, y, z), followed by their velocities
+static const int POSE_SIZE = 7;
+static const int STATE_SIZE = 2 * POSE_SIZE;
+
+// the motion of poses further apart says nothing about the current motion
+static const double MAX_TIME_STEP = 0.5;
+
+static void rotationToQuaternion(const cv::Mat &rotation, double *q)
+{
+    cv::Mat r;
+    rotation.convertTo(r, CV_64F);
+    double x = r.at<double>(0), y = r.at<double>(1), z = r.at<double>(2);
+    double angle = std::sqrt(x * x + y * y + z * z);
+
+    if (angle < 1e-12) {
+        q[0] = 1;
+        q[1] = q[2] = q[3] = 0;
+        return;
+    }
+
+    double s = std::sin(angle / 2) / angle;
+    q[0] = std::cos(angle / 2);
+    q[1] = x * s;
+    q[2] = y * s;
+    q[3] = z * s;
+}
+
+static cv::Mat quaternionToRotation(const double *q)
+{
+    double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    double w = q[0] / norm;
+    double v = std::sqrt(q[1] * q[1] + q[2] * q[2] + q[3] * q[3]) / norm;
+
+    cv::Mat rotation = cv::Mat::zeros(3, 1, CV_64F);
+    if (v < 1e-12) {
+        return rotation;
+    }
+
+    // q and -q are the same rotation, the shorter angle is returned
+    double angle = 2 * std::atan2(v, std::abs(w));
+    double s = (w < 0 ? -angle : angle) / (v * norm);
+    rotation.at<double>(0) = q[1] * s;
+    rotation.at<double>(1) = q[2] * s;
+    rotation.at<double>(2) = q[3] * s;
+
+    return rotation;
+}
+
+PoseFilter::PoseFilter(double translationNoise, double rotationNoise, double accelerationNoise)
+    : m_kalman(STATE_SIZE, POSE_SIZE, 0, CV_64F),
+      m_translationNoise(translationNoise),
+      m_rotationNoise(rotationNoise),
+      m_accelerationNoise(accelerationNoise),
+      m_initialized(false),
+      m_measurement(POSE_SIZE, 1, CV_64F)
+{
+    m_kalman.measurementMatrix = cv::Mat::eye(POSE_SIZE, STATE_SIZE, CV_64F);
+
+    m_kalman.measurementNoiseCov = cv::Mat::zeros(POSE_SIZE, POSE_SIZE, CV_64F);
+    for (int i = 0; i < POSE_SIZE; i++) {
+        m_kalman.measurementNoiseCov.at<double>(i, i) = i < 3 ? translationNoise : rotationNoise;
+    }
+}
+
+void PoseFilter::reset()
+{
+    m_initialized = false;
+}
+
+bool PoseFilter::isInitialized() const
+{
+    return m_initialized;
+}
+
+Pose PoseFilter::predict(Pose::Clock::time_point time)
+{
+    if (!m_initialized) {
+        return Pose();
+    }
+
+    double dt = std::chrono::duration<double>(time - m_timestamp).count();
+    if (dt > MAX_TIME_STEP) {
+        reset();
+        return Pose();
+    }
+
+    setTimeStep(std::max(dt, 0.0));
+    m_timestamp = time;
+
+    return statePose(m_kalman.predict(), time);
+}
+
+Pose PoseFilter::correct(const Pose &measurement)
+{
+    if (!measurement.valid) {
+        return measurement;
+    }
+
+    if (m_initialized && m_timestamp != measurement.timestamp) {
+        predict(measurement.timestamp);
+    }
+
+    double *z = m_measurement.ptr<double>();
+    cv::Mat translation;
+    measurement.translation.convertTo(translation, CV_64F);
+    for (int i = 0; i < 3; i++) {
+        z[i] = translation.at<double>(i);
+    }
+    rotationToQuaternion(measurement.rotation, z + 3);
+
+    if (!m_initialized) {
+        m_kalman.statePost = cv::Mat::zeros(STATE_SIZE, 1, CV_64F);
+        m_measurement.copyTo(m_kalman.statePost.rowRange(0, POSE_SIZE));
+
+        // the pose is known as well as a measurement, the velocity not at all
+        m_kalman.errorCovPost = cv::Mat::zeros(STATE_SIZE, STATE_SIZE, CV_64F);
+        m_kalman.measurementNoiseCov.copyTo(m_kalman.errorCovPost(cv::Rect(0, 0, POSE_SIZE, POSE_SIZE)));
+        for (int i = POSE_SIZE; i < STATE_SIZE; i++) {
+            m_kalman.errorCovPost.at<double>(i, i) = 1.0;
+        }
+
+        m_initialized = true;
+        m_timestamp = measurement.timestamp;
+
+        return statePose(m_kalman.statePost, measurement.timestamp);
+    }
+
+    // move the measurement to the hemisphere of the predicted quaternion
+    const double *predicted = m_kalman.statePre.ptr<double>() + 3;
+    if (predicted[0] * z[3] + predicted[1] * z[4] + predicted[2] * z[5] + predicted[3] * z[6] < 0) {
+        for (int i = 3; i < POSE_SIZE; i++) {
+            z[i] = -z[i];
+        }
+    }
+
+    cv::Mat state = m_kalman.correct(m_measurement);
+
+    // keep the quaternion a unit quaternion, otherwise its length drifts with the velocity
+    double *q = state.ptr<double>() + 3;
+    double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (int i = 0; i < 4; i++) {
+        q[i] /= norm;
+    }
+
+    return statePose(state, measurement.timestamp);
+}
+
+void PoseFilter::setTimeStep(double dt)
+{
+    m_kalman.transitionMatrix = cv::Mat::eye(STATE_SIZE, STATE_SIZE, CV_64F);
+
+    // discrete white noise acceleration, per component of the pose and its velocity
+    m_kalman.processNoiseCov = cv::Mat::zeros(STATE_SIZE, STATE_SIZE, CV_64F);
+    double q = m_accelerationNoise;
+    for (int i = 0; i < POSE_SIZE; i++) {
+        // quaternion components change at about half the angular rate
+        double scale = i < 3 ? q : q * 0.25;
+
+        m_kalman.transitionMatrix.at<double>(i, i + POSE_SIZE) = dt;
+        m_kalman.processNoiseCov.at<double>(i, i) = scale * dt * dt * dt / 3;
+        m_kalman.processNoiseCov.at<double>(i, i + POSE_SIZE) = scale * dt * dt / 2;
+        m_kalman.processNoiseCov.at<double>(i + POSE_SIZE, i) = scale * dt * dt / 2;
+        m_kalman.processNoiseCov.at<double>(i + POSE_SIZE, i + POSE_SIZE) = scale * dt;
+    }
+}
+
+Pose PoseFilter::statePose(const cv::Mat &state, Pose::Clock::time_point timestamp) const
+{
+    const double *s = state.ptr<double>();
+
+    Pose pose;
+    pose.valid = true;
+    pose.timestamp = timestamp;
+    pose.translation = (cv::Mat_<double>(3, 1) << s[0], s[1], s[2]);
+    pose.rotation = quaternionToRotation(s + 3);
+
+    return pose;
+}
+
+}
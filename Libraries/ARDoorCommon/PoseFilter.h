@@ -0,0 +1,82 @@
+#ifndef POSEFILTER_H
+#define POSEFILTER_H
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <chrono>
+
+namespace ARDoor {
+
+/**
+ * Pose of the chessboard relative to the camera, as returned by solvePnP.
+ */
+struct Pose
+{
+    typedef std::chrono::steady_clock Clock;
+
+    bool valid;
+    // capture time of the frame the pose was estimated from
+    Clock::time_point timestamp;
+    cv::Mat rotation;
+    cv::Mat translation;
+
+    Pose() : valid(false) {}
+};
+
+/**
+ * Smooths the poses of consecutive frames with a constant velocity Kalman
+ * filter. The state holds the translation, the rotation as a unit
+ * quaternion and the velocities of both. Quaternions do not suffer from
+ * the discontinuity of rotation vectors at 180 degrees, measurements are
+ * moved to the hemisphere of the prediction before they are filtered.
+ *
+ * The predicted pose of a frame is a good initial guess for solvePnP,
+ * predict has to be called with the capture time before the measured pose
+ * of the same frame is passed to correct.
+ */
+class PoseFilter
+{
+public:
+    /**
+     * @param translationNoise variance of measured translations
+     * @param rotationNoise variance of measured quaternion components
+     * @param accelerationNoise spectral density of the unmodelled acceleration
+     */
+    PoseFilter(double translationNoise = 2.5e-5, double rotationNoise = 2.5e-5, double accelerationNoise = 1.0);
+
+    /**
+     * Forgets the motion, the next measurement initializes the filter again
+     */
+    void reset();
+    bool isInitialized() const;
+
+    /**
+     * Advances the filter to the given time
+     * @return the predicted pose, invalid if the filter is not initialized or the last pose is too old
+     */
+    Pose predict(Pose::Clock::time_point time);
+
+    /**
+     * Updates the filter with a measured pose, predicting up to its timestamp if necessary
+     * @return the filtered pose
+     */
+    Pose correct(const Pose &measurement);
+
+private:
+    void setTimeStep(double dt);
+    Pose statePose(const cv::Mat &state, Pose::Clock::time_point timestamp) const;
+
+    cv::KalmanFilter m_kalman;
+    double m_translationNoise;
+    double m_rotationNoise;
+    double m_accelerationNoise;
+
+    bool m_initialized;
+    Pose::Clock::time_point m_timestamp;
+    // measurement vector reused from frame to frame
+    cv::Mat m_measurement;
+};
+
+}
+
+#endif // POSEFILTER_H
@@ -1,4 +1,6 @@
 #include "RenderingContext.h"
+// includes GLEW, which has to come before the other GL headers
+#include "ARSceneView.h"
 #include "DebugHelper.h"
 
 #if defined(__APPLE__) || defined(MACOSX)
@@ -17,12 +19,58 @@ namespace ARDoor {
 RenderingContext::RenderingContext(CameraCalibration *c)
 {
     m_calibration = c;
-    m_isTextureInitialized = false;
+    m_isBackgroundChanged = false;
+    m_extrapolatePose = false;
+    m_sceneView = NULL;
+    m_modelScale = 1.0f;
+    m_width = 0;
+    m_height = 0;
+
+    // coordinate axes and a translucent cube standing on the board, the z axis points away from the camera
+    m_overlay.addLine(cv::Point3f(0, 0, 0), cv::Point3f(1, 0, 0), cv::Vec4f(1, 0, 0, 1));
+    m_overlay.addLine(cv::Point3f(0, 0, 0), cv::Point3f(0, 1, 0), cv::Vec4f(0, 1, 0, 1));
+    m_overlay.addLine(cv::Point3f(0, 0, 0), cv::Point3f(0, 0, 1), cv::Vec4f(0, 0, 1, 1));
+
+    int cubeMaterial = m_overlay.addMaterial(cv::Vec4f(0.2f, 0.35f, 0.3f, 0.75f));
+    m_overlay.addBox(cv::Point3f(-0.25f, -0.25f, -0.5f), cv::Point3f(0.25f, 0.25f, 0), cubeMaterial);
+
+    updateCalibration();
+    m_visionWorker.start();
+}
+
+RenderingContext::~RenderingContext()
+{
+    delete m_sceneView;
 }
 
 void RenderingContext::updateBackground(const cv::Mat& frame)
 {
-    frame.copyTo(m_backgroundImage);
+    m_backgroundImage = frame;
+    m_isBackgroundChanged = true;
+    m_backgroundTimestamp = Pose::Clock::now();
+
+    m_visionWorker.pushFrame(m_backgroundImage, m_backgroundTimestamp);
+}
+
+void RenderingContext::setPoseExtrapolation(bool enabled)
+{
+    m_extrapolatePose = enabled;
+}
+
+void RenderingContext::setPoseFiltering(bool enabled)
+{
+    m_visionWorker.setFiltering(enabled);
+}
+
+void RenderingContext::updateCalibration()
+{
+    m_visionWorker.setCalibration(m_calibration->getIntrinsicsMatrix(), m_calibration->getDistortionCoeffs());
+}
+
+void RenderingContext::loadModel(const std::string& path, float scale)
+{
+    m_modelPath = path;
+    m_modelScale = scale;
 }
 
 void RenderingContext::initialize()
@@ -32,26 +80,26 @@ void RenderingContext::initialize()
 
     glClearColor(0.0, 0.0, 0.0, 0.0);
 
-    GLfloat light_ambient[] = {1.0, 1.0, 1.0, 1.0};
-    GLfloat light_diffuse[] = {1.0, 1.0, 1.0, 1.0};
-    GLfloat light_position[] = {1.0, 1.0, 1.0, 0.0};  /* Infinite light location. */
-
-    /* Enable a single OpenGL light. */
-    glLightfv(GL_LIGHT0, GL_AMBIENT, light_ambient);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, light_diffuse);
-    glLightfv(GL_LIGHT0, GL_POSITION, light_position);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_LIGHTING);
-
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(-1.0, 1.0, -1.0, 1.0, -1.0, 100.0);
-
     /* Use depth buffering for hidden surface elimination. */
     glEnable(GL_DEPTH_TEST);
 
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
+
+    m_overlay.initialize();
+}
+
+void RenderingContext::release()
+{
+    m_overlay.release();
+    m_backgroundStream.release();
+    m_isBackgroundChanged = true;
+
+    // the scene owns textures and buffers of its own
+    delete m_sceneView;
+    m_sceneView = NULL;
 }
 
 void RenderingContext::draw()
@@ -62,10 +110,24 @@ void RenderingContext::draw()
 
     std::cout << "draw()" << std::endl;
 
+    if (!m_modelPath.empty()) {
+        if (!m_sceneView) {
+            m_sceneView = new ARSceneView(m_calibration, m_width, m_height);
+        }
+        if (!m_sceneView->loadModel(m_modelPath, m_modelScale)) {
+            std::cout << "model not found: " << m_modelPath << std::endl;
+        }
+        m_modelPath.clear();
+    }
+
+    if (m_sceneView) {
+        drawSceneView();
+        return;
+    }
+
     glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
     drawCameraFrame();
-    detectChessboard();
     drawAugmentedScene();
 
     glFlush();
@@ -75,34 +137,19 @@ void RenderingContext::drawCameraFrame()
 {
     std::cout << "drawCameraFrame()" << std::endl;
 
-    // Initialize texture for background image
-    if (!m_isTextureInitialized)
+    // only new frames are uploaded, repaints reuse the texture
+    if (m_isBackgroundChanged)
     {
-        glGenTextures(1, &m_backgroundTextureId);
-        glBindTexture(GL_TEXTURE_2D, m_backgroundTextureId);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        m_isTextureInitialized = true;
+        m_backgroundStream.upload(m_backgroundImage);
+        m_isBackgroundChanged = false;
     }
 
     int w = m_backgroundImage.cols;
     int h = m_backgroundImage.rows;
-    glPixelStorei(GL_PACK_ALIGNMENT, 3);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 3);
-    glBindTexture(GL_TEXTURE_2D, m_backgroundTextureId);
-
-    // Upload new texture data:
-    if (m_backgroundImage.channels() == 3)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_BGR, GL_UNSIGNED_BYTE, m_backgroundImage.data);
-    else if(m_backgroundImage.channels() == 4)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_BGRA, GL_UNSIGNED_BYTE, m_backgroundImage.data);
-    else if (m_backgroundImage.channels()==1)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_backgroundImage.data);
+    cv::Point2f s = m_backgroundStream.getTextureScale();
 
     const GLfloat bgTextureVertices[] = { 0, 0, w, 0, 0, h, w, h };
-    const GLfloat bgTextureCoords[]   = { 1, 0, 1, 1, 0, 0, 0, 1 };
+    const GLfloat bgTextureCoords[]   = { s.x, 0, s.x, s.y, 0, 0, 0, s.y };
     const GLfloat proj[]              = { 0, -2.f/w, 0, 0, -2.f/h, 0, 0, 0, 0, 0, 1, 0, 1, 1, 0, 1 };
 
     //begin othogonal projection
@@ -113,7 +160,7 @@ void RenderingContext::drawCameraFrame()
     glLoadMatrixf(proj);
 
     glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, m_backgroundTextureId);
+    glBindTexture(GL_TEXTURE_2D, m_backgroundStream.getTextureId());
 
     // Update attribute values.
     glEnableClientState(GL_VERTEX_ARRAY);
@@ -139,277 +186,44 @@ void RenderingContext::drawAugmentedScene()
 {
     std::cout << "drawAugmentedScene()" << std::endl;
 
-      // Init augmentation projection
-      cv::Mat projectionMatrix;
-      int w = m_backgroundImage.cols;
-      int h = m_backgroundImage.rows;
-      buildProjectionMatrix(m_calibration, w, h, projectionMatrix);
-
-      glMatrixMode(GL_PROJECTION);
-      //glLoadMatrixf(reinterpret_cast<const GLfloat*>(&projectionMatrix.data[0]));
-
-      glMatrixMode(GL_MODELVIEW);
-      glLoadIdentity();
-
-      if (isPatternPresent)
-      {
-        // Set the pattern transformation
-        glLoadMatrixf(reinterpret_cast<const GLfloat*>(&objectPosition.data[0]));
-
-        // Render model
-        drawCoordinateAxis();
-        drawCubeModel();
-      }
-}
-
+    Pose pose = currentPose();
+    if (!pose.valid) {
+        return;
+    }
 
-void RenderingContext::buildProjectionMatrix(CameraCalibration* calibration, int screen_width, int screen_height, cv::Mat& projectionMatrix)
-{
-    std::cout << "buildProjectionMatrix()" << std::endl;
-
-  float nearPlane = 0.01f;  // Near clipping distance
-  float farPlane  = 100.0f;  // Far clipping distance
-
-  // Camera parameters
-  cv::Mat intrinsics = calibration->getIntrinsicsMatrix();
-  float f_x = intrinsics.at<float>(1, 1); // Focal length in x axis
-  float f_y = intrinsics.at<float>(0, 0); // Focal length in y axis (usually the same?)
-  float c_x = intrinsics.at<float>(0, 2); // Camera primary point x
-  float c_y = intrinsics.at<float>(1, 2); // Camera primary point y
-
-  projectionMatrix = cv::Mat(4, 4, CV_32F);
-
-  projectionMatrix.at<float>(0, 0) = -2.0f * f_x / screen_width;
-  projectionMatrix.at<float>(0, 1) = 0.0f;
-  projectionMatrix.at<float>(0, 2) = 0.0f;
-  projectionMatrix.at<float>(0, 3) = 0.0f;
-
-  projectionMatrix.at<float>(1, 0) = 0.0f;
-  projectionMatrix.at<float>(1, 1) = 2.0f * f_y / screen_height;
-  projectionMatrix.at<float>(1, 2) = 0.0f;
-  projectionMatrix.at<float>(1, 3) = 0.0f;
-
-  projectionMatrix.at<float>(2, 0) = 2.0f * c_x / screen_width - 1.0f;
-  projectionMatrix.at<float>(2, 1) = 2.0f * c_y / screen_height - 1.0f;
-  projectionMatrix.at<float>(2, 2) = -( farPlane + nearPlane) / ( farPlane - nearPlane );
-  projectionMatrix.at<float>(2, 3) = -1.0f;
-
-  projectionMatrix.at<float>(3, 0) = 0.0f;
-  projectionMatrix.at<float>(3, 1) = 0.0f;
-  projectionMatrix.at<float>(3, 2) = -2.0f * farPlane * nearPlane / ( farPlane - nearPlane );
-  projectionMatrix.at<float>(3, 3) = 0.0f;
+    // the camera image fills the viewport, so the projection is built for its size
+    m_overlay.setProjection(m_calibration->getIntrinsicsMatrix(), m_backgroundImage.size());
+    m_overlay.draw(pose);
 }
 
-void RenderingContext::drawCoordinateAxis()
+void RenderingContext::drawSceneView()
 {
-    std::cout << "drawCoordinateAxis()" << std::endl;
-
-    static float lineX[] = {0,0,0,1,0,0};
-    static float lineY[] = {0,0,0,0,1,0};
-    static float lineZ[] = {0,0,0,0,0,1};
-
-    glLineWidth(2);
-
-    glBegin(GL_LINES);
-
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glVertex3fv(lineX);
-    glVertex3fv(lineX + 3);
-
-    glColor3f(0.0f, 1.0f, 0.0f);
-    glVertex3fv(lineY);
-    glVertex3fv(lineY + 3);
-
-    glColor3f(0.0f, 0.0f, 1.0f);
-    glVertex3fv(lineZ);
-    glVertex3fv(lineZ + 3);
+    // the scene view keeps the frame until the next one and streams it into its texture
+    if (m_isBackgroundChanged)
+    {
+        m_sceneView->updateBackground(m_backgroundImage);
+        m_isBackgroundChanged = false;
+    }
 
-    glEnd();
+    m_sceneView->setPose(currentPose());
+    m_sceneView->paint();
 }
 
-void RenderingContext::drawCubeModel()
+Pose RenderingContext::currentPose()
 {
-    std::cout << "drawCubeModel()" << std::endl;
-
-    static const GLfloat LightAmbient[]=  { 0.25f, 0.25f, 0.25f, 1.0f };    // Ambient Light Values
-    static const GLfloat LightDiffuse[]=  { 0.1f, 0.1f, 0.1f, 1.0f };    // Diffuse Light Values
-    static const GLfloat LightPosition[]= { 0.0f, 0.0f, 2.0f, 1.0f };    // Light Position
-
-    glPushAttrib(GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_ENABLE_BIT | GL_LIGHTING_BIT | GL_POLYGON_BIT);
-
-    glColor4f(0.2f,0.35f,0.3f,0.75f);         // Full Brightness, 50% Alpha ( NEW )
-    glBlendFunc(GL_ONE,GL_ONE_MINUS_SRC_ALPHA);       // Blending Function For Translucency Based On Source Alpha
-    glEnable(GL_BLEND);
-
-    glShadeModel(GL_SMOOTH);
-
-    glEnable(GL_LIGHTING);
-    glDisable(GL_LIGHT0);
-    glEnable(GL_LIGHT1);
-    glLightfv(GL_LIGHT1, GL_AMBIENT, LightAmbient);
-    glLightfv(GL_LIGHT1, GL_DIFFUSE, LightDiffuse);
-    glLightfv(GL_LIGHT1, GL_POSITION, LightPosition);
-    glEnable(GL_COLOR_MATERIAL);
-
-    glScalef(0.25,0.25, 0.25);
-    glTranslatef(0, 0, 1);
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glBegin(GL_QUADS);
-    // Front Face
-    glNormal3f( 0.0f, 0.0f, 1.0f);    // Normal Pointing Towards Viewer
-    glVertex3f(-1.0f, -1.0f,  1.0f);  // Point 1 (Front)
-    glVertex3f( 1.0f, -1.0f,  1.0f);  // Point 2 (Front)
-    glVertex3f( 1.0f,  1.0f,  1.0f);  // Point 3 (Front)
-    glVertex3f(-1.0f,  1.0f,  1.0f);  // Point 4 (Front)
-    // Back Face
-    glNormal3f( 0.0f, 0.0f,-1.0f);    // Normal Pointing Away From Viewer
-    glVertex3f(-1.0f, -1.0f, -1.0f);  // Point 1 (Back)
-    glVertex3f(-1.0f,  1.0f, -1.0f);  // Point 2 (Back)
-    glVertex3f( 1.0f,  1.0f, -1.0f);  // Point 3 (Back)
-    glVertex3f( 1.0f, -1.0f, -1.0f);  // Point 4 (Back)
-    // Top Face
-    glNormal3f( 0.0f, 1.0f, 0.0f);    // Normal Pointing Up
-    glVertex3f(-1.0f,  1.0f, -1.0f);  // Point 1 (Top)
-    glVertex3f(-1.0f,  1.0f,  1.0f);  // Point 2 (Top)
-    glVertex3f( 1.0f,  1.0f,  1.0f);  // Point 3 (Top)
-    glVertex3f( 1.0f,  1.0f, -1.0f);  // Point 4 (Top)
-    // Bottom Face
-    glNormal3f( 0.0f,-1.0f, 0.0f);    // Normal Pointing Down
-    glVertex3f(-1.0f, -1.0f, -1.0f);  // Point 1 (Bottom)
-    glVertex3f( 1.0f, -1.0f, -1.0f);  // Point 2 (Bottom)
-    glVertex3f( 1.0f, -1.0f,  1.0f);  // Point 3 (Bottom)
-    glVertex3f(-1.0f, -1.0f,  1.0f);  // Point 4 (Bottom)
-    // Right face
-    glNormal3f( 1.0f, 0.0f, 0.0f);    // Normal Pointing Right
-    glVertex3f( 1.0f, -1.0f, -1.0f);  // Point 1 (Right)
-    glVertex3f( 1.0f,  1.0f, -1.0f);  // Point 2 (Right)
-    glVertex3f( 1.0f,  1.0f,  1.0f);  // Point 3 (Right)
-    glVertex3f( 1.0f, -1.0f,  1.0f);  // Point 4 (Right)
-    // Left Face
-    glNormal3f(-1.0f, 0.0f, 0.0f);    // Normal Pointing Left
-    glVertex3f(-1.0f, -1.0f, -1.0f);  // Point 1 (Left)
-    glVertex3f(-1.0f, -1.0f,  1.0f);  // Point 2 (Left)
-    glVertex3f(-1.0f,  1.0f,  1.0f);  // Point 3 (Left)
-    glVertex3f(-1.0f,  1.0f, -1.0f);  // Point 4 (Left)
-    glEnd();
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glColor4f(0.2f,0.65f,0.3f,0.35f); // Full Brightness, 50% Alpha ( NEW )
-    glBegin(GL_QUADS);
-    // Front Face
-    glNormal3f( 0.0f, 0.0f, 1.0f);    // Normal Pointing Towards Viewer
-    glVertex3f(-1.0f, -1.0f,  1.0f);  // Point 1 (Front)
-    glVertex3f( 1.0f, -1.0f,  1.0f);  // Point 2 (Front)
-    glVertex3f( 1.0f,  1.0f,  1.0f);  // Point 3 (Front)
-    glVertex3f(-1.0f,  1.0f,  1.0f);  // Point 4 (Front)
-    // Back Face
-    glNormal3f( 0.0f, 0.0f,-1.0f);    // Normal Pointing Away From Viewer
-    glVertex3f(-1.0f, -1.0f, -1.0f);  // Point 1 (Back)
-    glVertex3f(-1.0f,  1.0f, -1.0f);  // Point 2 (Back)
-    glVertex3f( 1.0f,  1.0f, -1.0f);  // Point 3 (Back)
-    glVertex3f( 1.0f, -1.0f, -1.0f);  // Point 4 (Back)
-    // Top Face
-    glNormal3f( 0.0f, 1.0f, 0.0f);    // Normal Pointing Up
-    glVertex3f(-1.0f,  1.0f, -1.0f);  // Point 1 (Top)
-    glVertex3f(-1.0f,  1.0f,  1.0f);  // Point 2 (Top)
-    glVertex3f( 1.0f,  1.0f,  1.0f);  // Point 3 (Top)
-    glVertex3f( 1.0f,  1.0f, -1.0f);  // Point 4 (Top)
-    // Bottom Face
-    glNormal3f( 0.0f,-1.0f, 0.0f);    // Normal Pointing Down
-    glVertex3f(-1.0f, -1.0f, -1.0f);  // Point 1 (Bottom)
-    glVertex3f( 1.0f, -1.0f, -1.0f);  // Point 2 (Bottom)
-    glVertex3f( 1.0f, -1.0f,  1.0f);  // Point 3 (Bottom)
-    glVertex3f(-1.0f, -1.0f,  1.0f);  // Point 4 (Bottom)
-    // Right face
-    glNormal3f( 1.0f, 0.0f, 0.0f);    // Normal Pointing Right
-    glVertex3f( 1.0f, -1.0f, -1.0f);  // Point 1 (Right)
-    glVertex3f( 1.0f,  1.0f, -1.0f);  // Point 2 (Right)
-    glVertex3f( 1.0f,  1.0f,  1.0f);  // Point 3 (Right)
-    glVertex3f( 1.0f, -1.0f,  1.0f);  // Point 4 (Right)
-    // Left Face
-    glNormal3f(-1.0f, 0.0f, 0.0f);    // Normal Pointing Left
-    glVertex3f(-1.0f, -1.0f, -1.0f);  // Point 1 (Left)
-    glVertex3f(-1.0f, -1.0f,  1.0f);  // Point 2 (Left)
-    glVertex3f(-1.0f,  1.0f,  1.0f);  // Point 3 (Left)
-    glVertex3f(-1.0f,  1.0f, -1.0f);  // Point 4 (Left)
-    glEnd();
-
-    glPopAttrib();
+    return m_extrapolatePose ? m_visionWorker.getPose(m_backgroundTimestamp) : m_visionWorker.getPose();
 }
 
-void RenderingContext::detectChessboard()
+void RenderingContext::resize(int width, int height)
 {
-    std::cout << "detectChessboard()" << std::endl;
-
-    cv::Size boardSize = cv::Size(9, 6);
-
-    std::vector<cv::Point2f> corners;
-    float a = 0.1f;						// The widht/height of each square of the chessboard object
-    std::vector<cv::Point3f> _3DPoints;	// Vector that contains the 3D coordinates for each chessboard corner
-
-    // Initialising the 3D-Points for the chessboard
-    cv::Point3f _3DPoint;
-    float y = (((boardSize.height-1.0f)/2.0f)*a)+(a/2.0f);
-    float x = 0.0f;
-    for (int h = 0; h < boardSize.height; h++, y+=a) {
-        x = (((boardSize.height-2.0f)/2.0f)*(-a))-(a/2.0f);
-        for (int w = 0; w < boardSize.width; w++, x+=a) {
-            _3DPoint.x = x;
-            _3DPoint.y = y;
-            _3DPoint.z = 0.0f;
-            _3DPoints.push_back(_3DPoint);
-        }
-    }
+    m_width = width;
+    m_height = height;
 
-    isPatternPresent = cv::findChessboardCorners(m_backgroundImage, boardSize, corners, CV_CALIB_CB_ADAPTIVE_THRESH | CV_CALIB_CB_FILTER_QUADS);
+    glViewport(0, 0, width, height);
 
-    if (isPatternPresent)
-    {
-        cv::Mat M = m_calibration->getIntrinsicsMatrix();
-        cv::Mat D = m_calibration->getDistortionCoeffs();
-
-        cv::Mat_<float> Rvec;
-        cv::Mat_<float> Tvec;
-        cv::Mat raux, taux;
-        cv::solvePnP(cv::Mat(_3DPoints), cv::Mat(corners), M, D, raux, taux);		//Calculate the Rotation and Translation vector
-
-        raux.convertTo(Rvec, CV_32F);
-        taux.convertTo(Tvec, CV_32F);
-
-        cv::Mat_<float> rotMat(3, 3);
-        cv::Rodrigues(Rvec, rotMat);
-
-        cv::Mat projectionMatrix(4, 4, CV_32F);
-        projectionMatrix.at<float>(0, 0) = rotMat.at<float>(0, 0);
-        projectionMatrix.at<float>(0, 1) = rotMat.at<float>(0, 1);
-        projectionMatrix.at<float>(0, 2) = rotMat.at<float>(0, 2);
-        projectionMatrix.at<float>(0, 3) = Rvec.at<float>(0, 0);
-
-        projectionMatrix.at<float>(1, 0) = rotMat.at<float>(1, 0);
-        projectionMatrix.at<float>(1, 1) = rotMat.at<float>(1, 1);
-        projectionMatrix.at<float>(1, 2) = rotMat.at<float>(1, 2);
-        projectionMatrix.at<float>(1, 3) = Rvec.at<float>(1, 0);
-
-        projectionMatrix.at<float>(2, 0) = rotMat.at<float>(2, 0);
-        projectionMatrix.at<float>(2, 1) = rotMat.at<float>(2, 1);
-        projectionMatrix.at<float>(2, 2) = rotMat.at<float>(2, 2);
-        projectionMatrix.at<float>(2, 3) = Rvec.at<float>(2, 0);
-
-        projectionMatrix.at<float>(3, 0) = 0;
-        projectionMatrix.at<float>(3, 1) = 0;
-        projectionMatrix.at<float>(3, 2) = 0;
-        projectionMatrix.at<float>(3, 3) = 1;
-
-        objectPosition = projectionMatrix.inv();
-        //objectPosition = projectionMatrix;
+    if (m_sceneView) {
+        m_sceneView->onResize(width, height);
     }
-
-}
-
-void RenderingContext::resize(int width, int height)
-{
-    glViewport(0, 0, width, height);
 }
 
 }
@@ -2,38 +2,91 @@
 #define RENDERINGCONTEXT_H
 
 #include "CameraCalibration.h"
+#include "VisionWorker.h"
+#include "BackgroundStream.h"
+#include "OverlayRenderer.h"
+#include <string>
 #include <vector>
 
 namespace ARDoor {
 
+class ARSceneView;
+
 class RenderingContext
 {
 public:
     RenderingContext(CameraCalibration *c);
+    ~RenderingContext();
 
     void initialize();
     void draw();
 
+    /**
+     * Deletes the buffers, shaders and textures of the overlay, the camera
+     * frame and the scene view of a loaded model, the model is dropped.
+     * Needs the GL context to be current, so it has to be called before the
+     * context is destroyed.
+     */
+    void release();
+
+    /**
+     * Sets the next camera frame. The frame is referenced and not copied,
+     * callers which reuse their buffer have to pass a clone.
+     */
     void updateBackground(const cv::Mat& frame);
     void resize(int width, int height);
 
+    /**
+     * Predicts the pose at the capture time of the displayed frame instead
+     * of drawing the last estimated pose, which lags behind the camera.
+     */
+    void setPoseExtrapolation(bool enabled);
+
+    /**
+     * Smooths the estimated poses to keep the overlay from jittering, enabled by default
+     */
+    void setPoseFiltering(bool enabled);
+
+    /**
+     * Hands a copy of the current intrinsics and distortion to the pose
+     * estimation, has to be called whenever the calibration has changed.
+     */
+    void updateCalibration();
+
+    /**
+     * Draws a 3DS model with an SLProject scene view instead of the built-in
+     * overlay. The model is loaded by the next draw, which runs in the GL context.
+     * @param scale converts model units to board units
+     */
+    void loadModel(const std::string& path, float scale = 1.0f);
+
 private:
     void drawCameraFrame();
     void drawAugmentedScene();
-    void drawCoordinateAxis();
-    void drawCubeModel();
-
-    void buildProjectionMatrix(CameraCalibration* calibration, int screen_width, int screen_height, cv::Mat& projectionMatrix);
-    void detectChessboard();
+    void drawSceneView();
+    Pose currentPose();
 
 private:
-    bool               m_isTextureInitialized;
-    unsigned int       m_backgroundTextureId;
+    BackgroundStream   m_backgroundStream;
+    // set when the background image has not been uploaded yet
+    bool               m_isBackgroundChanged;
     CameraCalibration  *m_calibration;
     cv::Mat            m_backgroundImage;
+    Pose::Clock::time_point m_backgroundTimestamp;
+
+    // geometry lives in buffer objects, uploaded once by initialize
+    OverlayRenderer    m_overlay;
+
+    // replaces the overlay once a model has been loaded
+    ARSceneView        *m_sceneView;
+    std::string        m_modelPath;
+    float              m_modelScale;
+    int                m_width;
+    int                m_height;
 
-    bool isPatternPresent;
-    cv::Mat objectPosition;
+    // estimates the pose, the paint thread only picks up its results
+    VisionWorker       m_visionWorker;
+    bool               m_extrapolatePose;
 };
 
 }
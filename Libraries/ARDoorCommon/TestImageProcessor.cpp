@@ -14,7 +14,10 @@ std::string TestImageProcessor::getName() {
 
 void TestImageProcessor::processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame)
 {
-    inputFrame.copyTo(outputFrame);
+    if (outputFrame.data != inputFrame.data)
+    {
+        inputFrame.copyTo(outputFrame);
+    }
 
     //cv::Mat grey;
     //cv::cvtColor(inputFrame, grey, CV_RGB2GRAY);
@@ -13,6 +13,7 @@ public:
 
     std::string getName();
     void processFrame(const cv::Mat& inputFrame, cv::Mat& outputFrame);
+    bool isInPlace() { return true; }
 
 private:
     CameraCalibration& calibration;
@@ -0,0 +1,222 @@
+#include "VisionWorker.h"
+#include <opencv2/calib3d/calib3d.hpp>
+
+namespace ARDoor {
+
+// poses further apart are not used to derive the motion of the board
+static const std::chrono::milliseconds MAX_MOTION_INTERVAL(250);
+// the prediction never reaches further ahead than this
+static const std::chrono::milliseconds MAX_EXTRAPOLATION(100);
+
+VisionWorker::VisionWorker(cv::Size boardSize, float squareSize)
+    : m_chessboardTracker(boardSize), m_filtering(true), m_running(false), m_hasPendingFrame(false), m_hasPendingCalibration(false)
+{
+    float a = squareSize;
+
+    // Initialising the 3D-Points for the chessboard
+    cv::Point3f _3DPoint;
+    float y = (((boardSize.height-1.0f)/2.0f)*a)+(a/2.0f);
+    float x = 0.0f;
+    for (int h = 0; h < boardSize.height; h++, y+=a) {
+        x = (((boardSize.height-2.0f)/2.0f)*(-a))-(a/2.0f);
+        for (int w = 0; w < boardSize.width; w++, x+=a) {
+            _3DPoint.x = x;
+            _3DPoint.y = y;
+            _3DPoint.z = 0.0f;
+            m_boardPoints.push_back(_3DPoint);
+        }
+    }
+}
+
+VisionWorker::~VisionWorker()
+{
+    stop();
+}
+
+void VisionWorker::start()
+{
+    if (m_running)
+    {
+        return;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&VisionWorker::run, this);
+}
+
+void VisionWorker::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_running = false;
+    }
+    m_frameAvailable.notify_one();
+    m_thread.join();
+
+    m_chessboardTracker.reset();
+    m_poseFilter.reset();
+}
+
+bool VisionWorker::isRunning() const
+{
+    return m_running;
+}
+
+void VisionWorker::setFiltering(bool enabled)
+{
+    m_filtering = enabled;
+}
+
+void VisionWorker::setCalibration(const cv::Mat &intrinsics, const cv::Mat &distortion)
+{
+    // copied outside the lock, the caller may change its matrices afterwards
+    cv::Mat intrinsicsCopy = intrinsics.clone();
+    cv::Mat distortionCopy = distortion.clone();
+
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    m_pendingIntrinsics = intrinsicsCopy;
+    m_pendingDistortion = distortionCopy;
+    m_hasPendingCalibration = true;
+}
+
+void VisionWorker::pushFrame(const cv::Mat &frame, Pose::Clock::time_point timestamp)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_frameMutex);
+        m_pendingFrame = frame;
+        m_pendingTimestamp = timestamp;
+        m_hasPendingFrame = true;
+    }
+    m_frameAvailable.notify_one();
+}
+
+Pose VisionWorker::getPose() const
+{
+    std::lock_guard<std::mutex> lock(m_poseMutex);
+    return m_pose;
+}
+
+Pose VisionWorker::getPose(Pose::Clock::time_point time) const
+{
+    Pose latest, previous;
+    {
+        std::lock_guard<std::mutex> lock(m_poseMutex);
+        latest = m_pose;
+        previous = m_previousPose;
+    }
+
+    if (!latest.valid || !previous.valid || time <= latest.timestamp)
+    {
+        return latest;
+    }
+
+    Pose::Clock::duration interval = latest.timestamp - previous.timestamp;
+    if (interval <= Pose::Clock::duration::zero() || interval > MAX_MOTION_INTERVAL)
+    {
+        return latest;
+    }
+
+    Pose::Clock::duration ahead = std::min<Pose::Clock::duration>(time - latest.timestamp, MAX_EXTRAPOLATION);
+    double factor = std::chrono::duration<double>(ahead).count() / std::chrono::duration<double>(interval).count();
+
+    // rotation between the last two poses, scaled on its axis
+    cv::Mat latestRotation, previousRotation, deltaRotation, delta;
+    cv::Rodrigues(latest.rotation, latestRotation);
+    cv::Rodrigues(previous.rotation, previousRotation);
+    cv::Rodrigues(latestRotation * previousRotation.t(), delta);
+    cv::Rodrigues(delta * factor, deltaRotation);
+
+    Pose predicted;
+    predicted.valid = true;
+    predicted.timestamp = latest.timestamp + ahead;
+    cv::Rodrigues(deltaRotation * latestRotation, predicted.rotation);
+    predicted.translation = latest.translation + (latest.translation - previous.translation) * factor;
+
+    return predicted;
+}
+
+void VisionWorker::run()
+{
+    while (true)
+    {
+        Pose::Clock::time_point timestamp;
+        {
+            std::unique_lock<std::mutex> lock(m_frameMutex);
+            while (m_running && !m_hasPendingFrame)
+            {
+                m_frameAvailable.wait(lock);
+            }
+
+            if (!m_running)
+            {
+                return;
+            }
+
+            m_frame = m_pendingFrame;
+            m_pendingFrame.release();
+            timestamp = m_pendingTimestamp;
+            m_hasPendingFrame = false;
+
+            if (m_hasPendingCalibration)
+            {
+                m_intrinsics = m_pendingIntrinsics;
+                m_distortion = m_pendingDistortion;
+                m_pendingIntrinsics.release();
+                m_pendingDistortion.release();
+                m_hasPendingCalibration = false;
+            }
+        }
+
+        estimate(m_frame, timestamp);
+    }
+}
+
+void VisionWorker::estimate(const cv::Mat &frame, Pose::Clock::time_point timestamp)
+{
+    std::vector<cv::Point2f> corners;
+    Pose pose;
+    pose.timestamp = timestamp;
+
+    // only searches the whole frame when the corners of the last frame could not be followed
+    if (!m_intrinsics.empty() && m_chessboardTracker.track(frame, corners))
+    {
+        cv::Mat M = m_intrinsics;
+        cv::Mat D = m_distortion;
+
+        // starting from the predicted pose saves most of the iterations
+        Pose predicted = m_filtering ? m_poseFilter.predict(timestamp) : Pose();
+        if (predicted.valid)
+        {
+            pose.rotation = predicted.rotation;
+            pose.translation = predicted.translation;
+        }
+
+        cv::solvePnP(cv::Mat(m_boardPoints), cv::Mat(corners), M, D, pose.rotation, pose.translation, predicted.valid);		//Calculate the Rotation and Translation vector
+        pose.valid = true;
+
+        if (m_filtering)
+        {
+            pose = m_poseFilter.correct(pose);
+        }
+        else
+        {
+            m_poseFilter.reset();
+        }
+    }
+    else
+    {
+        // the motion of the board is unknown once it has been lost
+        m_poseFilter.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(m_poseMutex);
+    m_previousPose = m_pose.valid && pose.valid ? m_pose : Pose();
+    m_pose = pose;
+}
+
+}
@@ -0,0 +1,104 @@
+#ifndef VISIONWORKER_H
+#define VISIONWORKER_H
+
+#include "ChessboardTracker.h"
+#include "PoseFilter.h"
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ARDoor {
+
+/**
+ * Estimates the chessboard pose on its own thread. Frames are handed over
+ * without waiting for the estimation, a frame arriving while the worker
+ * is busy replaces the one still waiting, so the worker always continues
+ * with the newest frame.
+ *
+ * The poses are smoothed with a PoseFilter, whose prediction for the frame
+ * also serves as initial guess for solvePnP.
+ *
+ * The worker estimates with its own copy of the camera calibration, which
+ * is handed over like the frames. No pose is estimated before the first
+ * calibration has been set.
+ */
+class VisionWorker
+{
+public:
+    VisionWorker(cv::Size boardSize = cv::Size(9, 6), float squareSize = 0.1f);
+    ~VisionWorker();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    /**
+     * Enables smoothing of the estimated poses, enabled by default
+     */
+    void setFiltering(bool enabled);
+
+    /**
+     * Hands the calibration to the worker. Both matrices are copied, the
+     * worker picks them up before it estimates the next frame.
+     */
+    void setCalibration(const cv::Mat &intrinsics, const cv::Mat &distortion);
+
+    /**
+     * Hands a frame to the worker. The frame is referenced and not copied,
+     * callers which reuse their buffer have to pass a clone.
+     */
+    void pushFrame(const cv::Mat &frame, Pose::Clock::time_point timestamp);
+
+    /**
+     * @return the pose of the most recent frame the worker has finished
+     */
+    Pose getPose() const;
+
+    /**
+     * Predicts the pose at the given time from the motion between the last
+     * two estimations. Falls back to the latest pose if there is no motion
+     * to extrapolate from or the prediction would reach too far ahead.
+     */
+    Pose getPose(Pose::Clock::time_point time) const;
+
+private:
+    void run();
+    void estimate(const cv::Mat &frame, Pose::Clock::time_point timestamp);
+
+    // 3D coordinates of the chessboard corners
+    std::vector<cv::Point3f> m_boardPoints;
+    ChessboardTracker  m_chessboardTracker;
+    PoseFilter         m_poseFilter;
+    std::atomic<bool>  m_filtering;
+
+    std::thread        m_thread;
+    std::atomic<bool>  m_running;
+
+    // frame waiting for the worker
+    mutable std::mutex m_frameMutex;
+    std::condition_variable m_frameAvailable;
+    cv::Mat            m_pendingFrame;
+    Pose::Clock::time_point m_pendingTimestamp;
+    bool               m_hasPendingFrame;
+    cv::Mat            m_frame;
+
+    // calibration waiting for the worker and the copy the worker estimates with
+    cv::Mat            m_pendingIntrinsics;
+    cv::Mat            m_pendingDistortion;
+    bool               m_hasPendingCalibration;
+    cv::Mat            m_intrinsics;
+    cv::Mat            m_distortion;
+
+    mutable std::mutex m_poseMutex;
+    Pose               m_pose;
+    // last valid pose before m_pose, used for extrapolation
+    Pose               m_previousPose;
+};
+
+}
+
+#endif // VISIONWORKER_H
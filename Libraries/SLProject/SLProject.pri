@@ -0,0 +1,160 @@
+##############################################################################
+#  File:      SLProject.pri
+#  Purpose:   Compiles the SLProject scene graph, GL wrappers and mesh loaders
+#             into the including project, without the GLFW application main.
+#             Include it from projects which embed SLProject rendering.
+##############################################################################
+
+DEFINES += SL_SHADER_PATH=\\\"$$PWD/_globals/oglsl/\\\"
+
+CONFIG(debug, debug|release) {
+   LIBS += -L$$PWD/_external/_debug/ -lCG-External
+} else {
+   LIBS += -L$$PWD/_external/_release/ -lCG-External
+}
+
+macx {
+    LIBS += -framework OpenGL
+    LIBS += -lgomp
+    QMAKE_CXXFLAGS += -fopenmp
+}
+unix:!macx {
+    LIBS += -lGL
+    LIBS += -lgomp
+    LIBS += -lX11
+    QMAKE_CXXFLAGS += -fopenmp
+}
+
+INCLUDEPATH += \
+    $$PWD/_external \
+    $$PWD/_external/glew/include \
+    $$PWD/_external/glfw/include \
+    $$PWD/_external/zlib \
+    $$PWD/_external/png \
+    $$PWD/_external/randomc \
+    $$PWD/_external/jpeg-8 \
+    $$PWD/_globals \
+    $$PWD/_globals/SL \
+    $$PWD/_globals/GL \
+    $$PWD/_globals/math \
+    $$PWD/_globals/MeshLoader \
+    $$PWD/_globals/SpacePartitioning \
+    $$PWD/chXX_Final/include
+
+HEADERS += \
+    $$PWD/_globals/GL/glUtils.h \
+    $$PWD/_globals/GL/SLGLBuffer.h \
+    $$PWD/_globals/GL/SLGLShader.h \
+    $$PWD/_globals/GL/SLGLShaderProg.h \
+    $$PWD/_globals/GL/SLGLShaderProgGeneric.h \
+    $$PWD/_globals/GL/SLGLShaderUniform.h \
+    $$PWD/_globals/GL/SLGLState.h \
+    $$PWD/_globals/GL/SLGLTexture.h \
+    $$PWD/_globals/math/SLCurve.h \
+    $$PWD/_globals/math/SLCurveBezier.h \
+    $$PWD/_globals/math/SLMat3.h \
+    $$PWD/_globals/math/SLMat4.h \
+    $$PWD/_globals/math/SLMath.h \
+    $$PWD/_globals/math/SLPlane.h \
+    $$PWD/_globals/math/SLQuat4.h \
+    $$PWD/_globals/math/SLVec2.h \
+    $$PWD/_globals/math/SLVec3.h \
+    $$PWD/_globals/math/SLVec4.h \
+    $$PWD/_globals/math/TriangleBoxIntersect.h \
+    $$PWD/_globals/MeshLoader/SL3DSMesh.h \
+    $$PWD/_globals/MeshLoader/SL3DSMeshFile.h \
+    $$PWD/_globals/SL/SL.h \
+    $$PWD/_globals/SL/SLDrawBits.h \
+    $$PWD/_globals/SL/SLEventHandler.h \
+    $$PWD/_globals/SL/SLFileSystem.h \
+    $$PWD/_globals/SL/SLImage.h \
+    $$PWD/_globals/SL/SLInterface.h \
+    $$PWD/_globals/SL/SLObject.h \
+    $$PWD/_globals/SL/SLTexFont.h \
+    $$PWD/_globals/SL/SLTimer.h \
+    $$PWD/_globals/SL/SLUtils.h \
+    $$PWD/_globals/SL/SLVector.h \
+    $$PWD/_globals/SL/stdafx.h \
+    $$PWD/_globals/SpacePartitioning/SLAccelStruct.h \
+    $$PWD/_globals/SpacePartitioning/SLKDNode.h \
+    $$PWD/_globals/SpacePartitioning/SLKDTree.h \
+    $$PWD/_globals/SpacePartitioning/SLUniformGrid.h \
+    $$PWD/chXX_Final/include/SLAABBox.h \
+    $$PWD/chXX_Final/include/SLAnimation.h \
+    $$PWD/chXX_Final/include/SLBox.h \
+    $$PWD/chXX_Final/include/SLButton.h \
+    $$PWD/chXX_Final/include/SLCamera.h \
+    $$PWD/chXX_Final/include/SLCone.h \
+    $$PWD/chXX_Final/include/SLCylinder.h \
+    $$PWD/chXX_Final/include/SLGroup.h \
+    $$PWD/chXX_Final/include/SLKeyframe.h \
+    $$PWD/chXX_Final/include/SLLight.h \
+    $$PWD/chXX_Final/include/SLLightRect.h \
+    $$PWD/chXX_Final/include/SLLightSphere.h \
+    $$PWD/chXX_Final/include/SLMaterial.h \
+    $$PWD/chXX_Final/include/SLMesh.h \
+    $$PWD/chXX_Final/include/SLNode.h \
+    $$PWD/chXX_Final/include/SLPolygon.h \
+    $$PWD/chXX_Final/include/SLRay.h \
+    $$PWD/chXX_Final/include/SLRaytracer.h \
+    $$PWD/chXX_Final/include/SLRectangle.h \
+    $$PWD/chXX_Final/include/SLRefGroup.h \
+    $$PWD/chXX_Final/include/SLRefShape.h \
+    $$PWD/chXX_Final/include/SLRevolver.h \
+    $$PWD/chXX_Final/include/SLSamples2D.h \
+    $$PWD/chXX_Final/include/SLScene.h \
+    $$PWD/chXX_Final/include/SLSceneView.h \
+    $$PWD/chXX_Final/include/SLShape.h \
+    $$PWD/chXX_Final/include/SLShapeBVH.h \
+    $$PWD/chXX_Final/include/SLSphere.h \
+    $$PWD/chXX_Final/include/SLText.h
+
+SOURCES += \
+    $$PWD/_globals/GL/glUtils.cpp \
+    $$PWD/_globals/GL/SLGLBuffer.cpp \
+    $$PWD/_globals/GL/SLGLShader.cpp \
+    $$PWD/_globals/GL/SLGLShaderProg.cpp \
+    $$PWD/_globals/GL/SLGLState.cpp \
+    $$PWD/_globals/GL/SLGLTexture.cpp \
+    $$PWD/_globals/math/SLCurveBezier.cpp \
+    $$PWD/_globals/math/SLPlane.cpp \
+    $$PWD/_globals/MeshLoader/SL3DSMesh.cpp \
+    $$PWD/_globals/MeshLoader/SL3DSMeshFile.cpp \
+    $$PWD/_globals/SL/SL.cpp \
+    $$PWD/_globals/SL/SLFileSystem.cpp \
+    $$PWD/_globals/SL/SLImage.cpp \
+    $$PWD/_globals/SL/SLInterface.cpp \
+    $$PWD/_globals/SL/SLTexFont.cpp \
+    $$PWD/_globals/SL/SLTimer.cpp \
+    $$PWD/_globals/SpacePartitioning/SLKDTree.cpp \
+    $$PWD/_globals/SpacePartitioning/SLUniformGrid.cpp \
+    $$PWD/chXX_Final/source/SLAABBox.cpp \
+    $$PWD/chXX_Final/source/SLAnimation.cpp \
+    $$PWD/chXX_Final/source/SLBox.cpp \
+    $$PWD/chXX_Final/source/SLButton.cpp \
+    $$PWD/chXX_Final/source/SLCamera.cpp \
+    $$PWD/chXX_Final/source/SLCone.cpp \
+    $$PWD/chXX_Final/source/SLCylinder.cpp \
+    $$PWD/chXX_Final/source/SLGroup.cpp \
+    $$PWD/chXX_Final/source/SLLight.cpp \
+    $$PWD/chXX_Final/source/SLLightRect.cpp \
+    $$PWD/chXX_Final/source/SLLightSphere.cpp \
+    $$PWD/chXX_Final/source/SLMaterial.cpp \
+    $$PWD/chXX_Final/source/SLMesh.cpp \
+    $$PWD/chXX_Final/source/SLPolygon.cpp \
+    $$PWD/chXX_Final/source/SLRay.cpp \
+    $$PWD/chXX_Final/source/SLRaytracer.cpp \
+    $$PWD/chXX_Final/source/SLRectangle.cpp \
+    $$PWD/chXX_Final/source/SLRefGroup.cpp \
+    $$PWD/chXX_Final/source/SLRefShape.cpp \
+    $$PWD/chXX_Final/source/SLRevolver.cpp \
+    $$PWD/chXX_Final/source/SLSamples2D.cpp \
+    $$PWD/chXX_Final/source/SLScene.cpp \
+    $$PWD/chXX_Final/source/SLSceneView.cpp \
+    $$PWD/chXX_Final/source/SLScene_onLoad.cpp \
+    $$PWD/chXX_Final/source/SLShape.cpp \
+    $$PWD/chXX_Final/source/SLShapeBVH.cpp \
+    $$PWD/chXX_Final/source/SLSphere.cpp \
+    $$PWD/chXX_Final/source/SLText.cpp \
+    $$PWD/chXX_Final/source/SLPhotonMapper.cpp \
+    $$PWD/chXX_Final/source/SLPhotonMap.cpp
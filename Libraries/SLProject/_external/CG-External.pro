@@ -51,6 +51,9 @@ unix:!macx {
     LIBS += -lX11
     QMAKE_CXXFLAGS += -fopenmp
     QMAKE_CXXFLAGS += -Wunused-parameter
+    # also linked into shared libraries like ARDoorCommon
+    QMAKE_CFLAGS += -fPIC
+    QMAKE_CXXFLAGS += -fPIC
 }
 
 
@@ -83,11 +83,13 @@ void SLGLState::initAll()
    
    globalAmbientLight.set(0.2f,0.2f,0.2f,0.0f);
    
-   _glVersion     = SLstring((char*)glGetString(GL_VERSION));
-   _glVendor      = SLstring((char*)glGetString(GL_VENDOR));
-   _glRenderer    = SLstring((char*)glGetString(GL_RENDERER));
-   _glGLSLVersion = SLstring((char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
-   _glExtensions  = SLstring((char*)glGetString(GL_EXTENSIONS));
+   // glGetString returns 0 if there is no current context (e.g. in tests)
+   const GLubyte* str;
+   _glVersion     = (str = glGetString(GL_VERSION))  ? (char*)str : "";
+   _glVendor      = (str = glGetString(GL_VENDOR))   ? (char*)str : "";
+   _glRenderer    = (str = glGetString(GL_RENDERER)) ? (char*)str : "";
+   _glGLSLVersion = (str = glGetString(GL_SHADING_LANGUAGE_VERSION)) ? (char*)str : "";
+   _glExtensions  = (str = glGetString(GL_EXTENSIONS)) ? (char*)str : "";
    
    //initialize states a unset
    _blend = false;
@@ -273,6 +273,75 @@ void SLGLTexture::fullUpdate()
 }
 //-----------------------------------------------------------------------------
 /*!
+SLGLTexture::copyVideoImage streams a video image into the texture. The image
+is copied into _img[0] and the texture is only created for the first frame or
+when the size or format changes. All further frames are written with
+glTexSubImage2D into the existing texture storage. Video images are neither
+resized to a power of 2 nor mipmapped. The source lines may be padded, 
+bytesPerLine=0 means tightly packed lines.
+*/
+void SLGLTexture::copyVideoImage(SLint    width,
+                                 SLint    height,
+                                 SLenum   format,
+                                 SLubyte* data,
+                                 SLint    bytesPerLine)
+{  assert(data && width>0 && height>0);
+   assert(_target == GL_TEXTURE_2D);
+   
+   SLbool sizeChanged = _img[0].width()  != (SLuint)width ||
+                        _img[0].height() != (SLuint)height ||
+                        _img[0].format() != format;
+   
+   _img[0].allocate(width, height, format);
+   
+   // copy line by line because SLImage lines are 4 byte aligned
+   SLuint lineBytes = _img[0].bytesPerPixel() * width;
+   if (bytesPerLine <= 0) bytesPerLine = lineBytes;
+   for (SLint y=0; y<height; ++y)
+      memcpy(_img[0].data() + y*_img[0].bytesPerLine(), 
+             data + y*bytesPerLine, 
+             lineBytes);
+   
+   _min_filter   = GL_LINEAR;
+   _mag_filter   = GL_LINEAR;
+   _wrap_s       = GL_CLAMP_TO_EDGE;
+   _wrap_t       = GL_CLAMP_TO_EDGE;
+   _resizeToPow2 = false;
+   
+   _stateGL->activeTexture(GL_TEXTURE0);
+   
+   if (!_texName || sizeChanged)
+   {  // unbind first, the new texture may get the name of the deleted one
+      if (_texName) 
+      {  _stateGL->bindTexture(_target, 0);
+         glDeleteTextures(1, &_texName);
+      }
+      glGenTextures(1, &_texName);
+      _stateGL->bindTexture(_target, _texName);
+      glTexParameteri(_target, GL_TEXTURE_MIN_FILTER, _min_filter);
+      glTexParameteri(_target, GL_TEXTURE_MAG_FILTER, _mag_filter);
+      glTexParameteri(_target, GL_TEXTURE_WRAP_S, _wrap_s);
+      glTexParameteri(_target, GL_TEXTURE_WRAP_T, _wrap_t);
+      
+      // BGR(A) is only allowed as pixel transfer format
+      SLint internalFormat = format;
+      #ifndef SL_GLES2
+      if (format == GL_BGR)  internalFormat = GL_RGB;
+      if (format == GL_BGRA) internalFormat = GL_RGBA;
+      #endif
+      
+      glTexImage2D(_target, 0, internalFormat, width, height, 0,
+                   format, GL_UNSIGNED_BYTE, (GLvoid*)_img[0].data());
+   } else
+   {  _stateGL->bindTexture(_target, _texName);
+      glTexSubImage2D(_target, 0, 0, 0, width, height,
+                      format, GL_UNSIGNED_BYTE, (GLvoid*)_img[0].data());
+   }
+   
+   GET_GL_ERROR;
+}
+//-----------------------------------------------------------------------------
+/*!
 getTexelf returns a pixel color with its s & t texture coordinates.
 If the OpenGL filtering is set to GL_LINEAR a bilinear interpolated color out
 of four neighbouring pixels is return. Otherwise the nearest pixel is returned.
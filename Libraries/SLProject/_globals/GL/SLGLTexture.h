@@ -76,6 +76,11 @@ class SLGLTexture : public SLObject
       void           build       (SLint texID=0);
       void           bindActive  (SLint texID=0);
       void           fullUpdate  ();
+      void           copyVideoImage(SLint    width,
+                                    SLint    height,
+                                    SLenum   format,
+                                    SLubyte* data,
+                                    SLint    bytesPerLine = 0);
       
       // Setters
       void           texType     (SLTexType bt)   {_texType = bt;}
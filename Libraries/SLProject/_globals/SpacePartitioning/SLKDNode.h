@@ -19,43 +19,89 @@
 #define YAXIS 1
 #define ZAXIS 2
 #define NOAXIS 3
+// Number of nodes an SLKDNodeArena allocates at once
+#define SL_KD_ARENABLOCK 1024
 
 //-----------------------------------------------------------------------------
 struct SLKdTriaAABB
 {  SLVec3f min;   //!< minimal corner of AABB
    SLVec3f max;   //!< maximal corner of AABB
-   SLfloat sa;    //!< surface area
 };
 //-----------------------------------------------------------------------------
+//! SLKDNode is an inner node or a leaf of the SLKDTree.
+/*! The nodes are allocated by an SLKDNodeArena and don't own their children.
+*/
 class SLKDNode
 {  public:
                      SLKDNode()
                      {  child1 = 0;
                         child2 = 0;
                         splitAxis = NOAXIS;
-                        kdNodeCnt++;
+                        splitDist = 0;
                      }
-                    ~SLKDNode()
-                     {  if (child1) delete child1;
-                        if (child2) delete child2;
-                     }
-                     
-      void           draw(SLVec3f minV, SLVec3f maxV);
       
       SLKDNode*      child1;
       SLKDNode*      child2;
       SLVushort      tria;
       SLuchar        splitAxis; //0=x, 1=y, 2=z and 3=noAxis=leaf node
       SLfloat        splitDist;
-      static SLuint  kdNodeCnt;
 };
 //-----------------------------------------------------------------------------
+//! SLKDNodeArena allocates kd-nodes in blocks and deletes them all at once.
+/*! An arena is not thread safe. The parallel kd-tree build gives every
+subtree that is built on its own thread a separate arena.
+*/
+class SLKDNodeArena
+{  public:
+                     SLKDNodeArena() {_numNodes = 0;}
+                    ~SLKDNodeArena() {clear();}
+
+      SLKDNode*      newNode()
+                     {  SLuint i = _numNodes % SL_KD_ARENABLOCK;
+                        if (i == 0)
+                           _blocks.push_back(new SLKDNode[SL_KD_ARENABLOCK]);
+                        _numNodes++;
+                        return &_blocks.back()[i];
+                     }
+      void           clear()
+                     {  for (SLuint b=0; b<_blocks.size(); ++b)
+                           delete[] _blocks[b];
+                        _blocks.clear();
+                        _numNodes = 0;
+                     }
+
+      SLuint         numNodes() {return _numNodes;}
+      SLuint         numBytes() {return _blocks.size() * SL_KD_ARENABLOCK *
+                                        sizeof(SLKDNode);}
+   private:
+      vector<SLKDNode*> _blocks;    //!< blocks of SL_KD_ARENABLOCK nodes
+      SLuint         _numNodes;     //!< No. of nodes handed out
+};
+//-----------------------------------------------------------------------------
+//! SLKDFlatNode is the 8 byte kd-tree node used for the traversal.
+/*! SLKDTree flattens the built tree depth first into one array, so child1 of
+an inner node is the next node in the array and only the index of child2 is
+stored. The triangle indexes of all leaves are packed into one array.
+*/
+struct SLKDFlatNode
+{  union
+   {  SLfloat  splitDist;  //!< inner node: position of the split plane
+      SLuint   firstTria;  //!< leaf: index of the first triangle index
+   };
+   SLuint      bits;       //!< bits 0-1: split axis or NOAXIS for leaves,
+                           //!< bits 2-31: index of child2 or No. of triangles
+
+   SLuint      axis     () {return bits & 3;}
+   SLuint      child2   () {return bits >> 2;}
+   SLuint      numTria  () {return bits >> 2;}
+};
+typedef std::vector<SLKDFlatNode> SLVKDFlatNode;
+//-----------------------------------------------------------------------------
 // Entry for stack operation.
 struct SLKdStackElem
-{  SLKDNode* node;   // pointer to far child
-   SLfloat   t;      // the entry/exit signed distance
-   SLVec3f   p;      // the coordinates of entry/exit point
-   SLint     prev;   // the pointer to the previous stack item
+{  SLuint    node;   // index of far child
+   SLfloat   tmin;   // the entry signed distance
+   SLfloat   tmax;   // the exit signed distance
 };
 //-----------------------------------------------------------------------------
 #endif // SLKDNODE_H
\ No newline at end of file
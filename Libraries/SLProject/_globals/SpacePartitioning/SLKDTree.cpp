@@ -10,6 +10,9 @@
 #ifdef SL_MEMLEAKDETECT
 #include <nvwa/debug_new.h>   // memory leak detector
 #endif
+#ifdef SL_OMP
+#include <omp.h>              // OpenMP
+#endif
 
 #include <SLGroup.h>
 #include <SLMesh.h>
@@ -20,10 +23,17 @@
 #include <SLKDNode.h>
 #include <SLKDTree.h>
 
-//-----------------------------------------------------------------------------
-SLuint SLKDNode::kdNodeCnt = 0;
 //-----------------------------------------------------------------------------
 #define MIN_FACES_FOR_ACCELERATION 3
+#define NEXTAXIS(a) (((a)+1) % 3)
+//-----------------------------------------------------------------------------
+// Surface area heuristic (SAH) parameters, see findSplit3
+#define SL_KD_NUMBINS      32    // No. of bins per axis for the split search
+#define SL_KD_COSTTRAVERSE 1.0f  // cost of a traversal step
+#define SL_KD_COSTINTERSECT 1.5f // cost of a ray-triangle intersection test
+#define SL_KD_EMPTYBONUS   0.2f  // cost reduction for cutting off empty space
+// No. of subtrees that are built in parallel
+#define SL_KD_NUMTASKS     32
 //-----------------------------------------------------------------------------
 SLKDTree::SLKDTree(SLMesh* m) : SLAccelStruct(m)
 {   
@@ -32,43 +42,60 @@ SLKDTree::SLKDTree(SLMesh* m) : SLAccelStruct(m)
    _voxMaxTria  = 0;
    _voxAvgTria  = 0;
    _kdRoot      = 0;
+   _kdArenas    = 0;
+   _kdDump      = false;
+   _kdNodeCnt   = 0;
    _kdMaxDepth  = 0;  
+   _kdNumBytes  = 0;
+   _kdTriaAB    = 0;
 }
 //-----------------------------------------------------------------------------
 SLKDTree::~SLKDTree()
 {  
-   if (_kdRoot) delete _kdRoot;
+   deleteTree();
+}
+//-----------------------------------------------------------------------------
+/*! SLKDTree::deleteTree deletes the flat nodes and the build nodes by
+deleting their arenas.
+*/
+void SLKDTree::deleteTree()
+{
+   if (_kdArenas) delete[] _kdArenas;
+   _kdArenas   = 0;
+   _kdRoot     = 0;
+   SLVKDFlatNode().swap(_kdNodes);
+   SLVushort().swap(_kdTriaIdx);
+   _kdNodeCnt  = 0;
+   _kdNumBytes = 0;
+   if (_bufP.id()) _bufP.dispose();
 }
 //-----------------------------------------------------------------------------
-/*! SLKDTree::draw implements the abstact draw method from SLAccelStruct
+/*! SLKDTree::draw implements the abstact draw method from SLAccelStruct. It
+draws the outlines of all split planes.
 */
 void SLKDTree::draw(SLSceneView* sv)
 {  
-   //if (sv->drawingBits() & SL_DB_VOXELS || _m->drawingBits() & SL_DB_VOXELS)
-   //{  
-   //   // push OGL matrix & attributes
-   //   glPushMatrix();
-   //   glPushAttrib(GL_LIGHTING_BIT | GL_TEXTURE_BIT);
-   //   glDisable(GL_LIGHTING);
-   //   glDisable(GL_TEXTURE_2D);
-   //   
-   //   // set the initial camera view
-   //   sv->camera()->setView();
-   //   
-   //   // call the recursive kd-tree drawing method 
-   //   drawNode(_kdRoot, 0, _minV, _maxV);  
-   //    
-   //   // pop back OGL matrix & attributes
-   //   glEnable(GL_LIGHTING);
-   //   glPopAttrib();
-   //   glPopMatrix();
-   //}
+   (void)sv; // avoid unused parameter warning
+   
+   if (_kdNodes.size())
+   {
+      if (!_bufP.id())
+      {  SLVVec3f lines;
+         drawNode(0, _minV, _maxV, lines);
+         if (lines.size() == 0) return;
+         _bufP.generate(&lines[0], lines.size(), 3);
+      }
+
+      _bufP.drawArrayAsConstantColorLines(SLCol3f::MAGENTA);
+   }
 }
 //-----------------------------------------------------------------------------
 /*! Updates the parent groups statistics.
 */
 void SLKDTree::updateStats(SLGroup* parent)
-{  
+{  assert(parent != 0);
+
+   parent->numBytesAccel += _kdNumBytes;
    parent->numVoxels    += _voxCnt;
    parent->numVoxEmpty  += _voxCntEmpty;
    if (_voxMaxTria > parent->numVoxMaxTria)
@@ -76,164 +103,134 @@ void SLKDTree::updateStats(SLGroup* parent)
 }
 //-----------------------------------------------------------------------------
 /*! SLKDTree::build starts the kd-tree building by calling the recursive 
-SLKDTree::buildTree method.
+SLKDTree::buildTree method. The max. depth of 8 + 1.3 log2(N) is the rule of
+thumb from Havran's thesis, limited by the size of the traversal stack.
 */
 void SLKDTree::build(SLVec3f minV, SLVec3f maxV)
 {  
    _minV = minV;
    _maxV = maxV;
-   buildTree(1, minV, maxV);
+
+   SLint maxDepth = (SLint)(8.0f + 1.3f*log((SLfloat)_m->numF)/log(2.0f));
+   if (maxDepth > MAXSTACKDEPTH-4) maxDepth = MAXSTACKDEPTH-4;
+
+   buildTree(maxDepth, minV, maxV);
 }
 
 //-----------------------------------------------------------------------------
 /*! 
-SLKDTree::intersect implements the kd-tree traversale algorithm TA_B_rec
-from Vlasimil Havran's thesis "Heuristic Ray Schooting Algorithms". The 
-recursion is removed with a stack with elements of SLKdStackElem.
+SLKDTree::intersect traverses the flat kd-tree front to back. The far
+children are pushed on a stack together with the signed distances where the
+ray enters and leaves them. The traversal stops as soon as a hit lies before
+the entry of the next node.
 */
 SLbool SLKDTree::intersect(SLRay* ray)
-{  if (_kdRoot)
+{
+   // Check first if the AABB is hit at all
+   if (!_m->aabb()->isHitInOS(ray)) return false;
+
+   SLbool wasHit = false;
+
+   if (_kdNodes.size())
    {  
-      SLfloat tmin = 0, tmax = 0; // hit distance to aabb
-      if (_m->aabb().isHit(ray, tmin, tmax))
-      {  
-         SLfloat t; // signed distance to the splitting plane
-         SLVec3f O = ray->origin;
-         SLVec3f D = ray->dir;
-         
-         // stack required for traversal to store far children
-         SLKdStackElem stack[MAXSTACKDEPTH];
-         
-         SLKDNode* farChild;
-         SLKDNode* curNode = _kdRoot;  // start from the kd-tree root node
-         SLint     enPt    = 0;        // setup initial entry point
-         SLint     exPt    = 1;        // pointer to the stack
-
-         stack[enPt].t = tmin;   // set the signed distance
-
-         // distinguish between internal and external origin
-         if (tmin >= 0.0) 
-              stack[enPt].p.add(O,D*tmin);   // a ray with external origin
-         else stack[enPt].p = O;             // a ray with internal origin
-                
-         // setup initial exit point in the stack
-         stack[exPt].t = tmax;
-         stack[exPt].p.add(O,D*tmax);
-         stack[exPt].node = 0; // set termination flag
-
-         // loop through the whole kd-tree, until an object is intersected 
-         // or ray leaves the scene
-         while (curNode)
-         {
-            // loop until a nonempty leaf is found 
-            while (curNode->splitAxis != NOAXIS)
-            {
-               // retrieve axis and position of splitting plane
-               SLfloat splitDist = curNode->splitDist;
-               SLint   axis      = curNode->splitAxis;     
-               
-               // check next node to descend
-               if (stack[enPt].p[axis] <= splitDist)
-               {  if (stack[exPt].p[axis] <= splitDist)
-                  {  // case N1, N2, N3, P5, Z2, and Z3
-                     curNode = curNode->child1;   
-                     continue;
-                  }
-                  if (stack[exPt].p[axis] == splitDist)
-                  {  // case Z1
-                     curNode = curNode->child2;  
-                     continue; 
-                  }
-
-                  // case N4
-                  farChild = curNode->child2;
-                  curNode  = curNode->child1;
-               }
-               else
-               {  // (stack[enPt].p[axis] > splitDist)
-                  if (splitDist < stack[exPt].p[axis])
-                  {  // case P1, P2, P3, and N5
-                     curNode = curNode->child2;  
-                     continue;
-                  }
-
-                  // case P4
-                  farChild = curNode->child1;
-                  curNode  = curNode->child2;
-               }
-
-               // case P4 or N4 -> traverse both children: add nodes to stack
-               // signed distance to the splitting plane
-               t = (splitDist - O[axis]) / D[axis];
-
-               // setup the new exit point
-               SLint tmp = exPt;
-               exPt++;
-
-               // possibly skip current entry point so not to overwrite the data
-               if (exPt == enPt) exPt++;
-
-               // push values onto the stack
-               SLuint axis1 = NEXTAXIS(axis);
-               SLuint axis2 = NEXTAXIS(axis1);
-               stack[exPt].prev = tmp;
-               stack[exPt].t = t;
-               stack[exPt].node = farChild;
-               stack[exPt].p[axis]  = splitDist;         
-               stack[exPt].p[axis1] = O[axis1] + t*D[axis1];
-               stack[exPt].p[axis2] = O[axis2] + t*D[axis2];
+      SLVec3f O    = ray->originOS;
+      SLVec3f D    = ray->dirOS;
+      SLVec3f invD = ray->invDirOS;
+      SLfloat tmin = ray->tmin;  // entry & exit distance of current node
+      SLfloat tmax = ray->tmax;
+
+      // stack required for traversal to store far children
+      SLKdStackElem stack[MAXSTACKDEPTH];
+      SLint         stackPtr = 0;
+      SLuint        curNode  = 0;  // start from the kd-tree root node
+
+      // loop until the ray leaves the tree or a hit is in front of the node
+      while (ray->length >= tmin)
+      {
+         SLKDFlatNode& node = _kdNodes[curNode];
+         SLuint axis = node.axis();
+
+         if (axis != NOAXIS)
+         {  // the near child is the one on the side of the ray origin
+            SLbool  belowFirst = (O.comp[axis] <  node.splitDist) ||
+                                 (O.comp[axis] == node.splitDist && 
+                                  D.comp[axis] <= 0);
+            SLuint  nearChild  = belowFirst ? curNode+1 : node.child2();
+            SLuint  farChild   = belowFirst ? node.child2() : curNode+1;
+
+            // a ray parallel to the plane stays on the side of its origin.
+            // In the plane tPlane would be 0*inf = NaN, the triangles in the
+            // plane are in both children anyway.
+            if (D.comp[axis] == 0)
+            {  curNode = nearChild;
+               continue;
             }
 
-            // current node is the leaf, empty or full
-            // intersect ray with each object in the object list, discarding
-            // those lying before stack[enPt].t or farther than stack[exPt].t
-            if (curNode->tria.size() > 0)
-            {  for(SLuint i=0; i<curNode->tria.size(); i++)
-                  _m->hitTriangleOS(ray, curNode->tria[i]);
-      	         
-               if (ray->length > stack[enPt].t && 
-                   ray->length <= stack[exPt].t) return;
+            // signed distance to the splitting plane
+            SLfloat tPlane = (node.splitDist - O.comp[axis]) * invD.comp[axis];
+
+            if (tPlane > tmax || tPlane <= 0)
+               curNode = nearChild;    // the ray only passes the near child
+            else if (tPlane < tmin)
+               curNode = farChild;     // the ray only passes the far child
+            else
+            {  // traverse both children, the far one later
+               stack[stackPtr].node = farChild;
+               stack[stackPtr].tmin = tPlane;
+               stack[stackPtr].tmax = tmax;
+               stackPtr++;
+               curNode = nearChild;
+               tmax = tPlane;
             }
-            
+         }
+         else
+         {  // intersect ray with each triangle of the leaf
+            SLushort* tria = &_kdTriaIdx[0] + node.firstTria;
+            for (SLuint i=0; i<node.numTria(); ++i)
+            {  if (_m->hitTriangleOS(ray, tria[i])) wasHit = true;
+            }
+
             // get next node from stack
-            enPt = exPt; // the signed distance intervals are adjacent
-            curNode = stack[exPt].node;
-            exPt = stack[enPt].prev;
+            if (stackPtr == 0) break;
+            stackPtr--;
+            curNode = stack[stackPtr].node;
+            tmin    = stack[stackPtr].tmin;
+            tmax    = stack[stackPtr].tmax;
          }
       }
-   } 
+   }
    else // not enough trias to build tree
-   {  SLfloat tmin = 0, tmax = 0; // hit distance to aabb
-      if (_m->aabb().isHit(ray, tmin, tmax))
-      {  for (SLuint t=0; t<_m->numF; ++t)
-         {  _m->hitTriangleOS(ray, t);
-         }
+   {  for (SLuint t=0; t<_m->numF; ++t)
+      {  if (_m->hitTriangleOS(ray, t)) wasHit = true;
       }
    }
+   return wasHit;
 }
 //-----------------------------------------------------------------------------
 /*! 
-SLKDTree::buildTree builds a kd tree by recursively splitting up its AABB
+SLKDTree::buildTree builds a kd tree by recursively splitting up its AABB.
+The nodes near the root are split in breadth first order on one thread until
+there are SL_KD_NUMTASKS open subtrees. These subtrees are then built in
+parallel, each with its own node arena and build statistics, so the threads
+share nothing but the read only triangle data.
 */
 void SLKDTree::buildTree(SLint maxDepth, SLVec3f minV, SLVec3f maxV)
 {
-   _kdDump = false;
-   maxDepth = 100;
-   
-   // create new tree
-   SLKDNode::kdNodeCnt = 0;
+   // delete the old tree
+   deleteTree();
    _kdMaxDepth = 0;
-   if (_kdRoot) delete _kdRoot;
-   _kdRoot = new SLKDNode();
-   _kdRoot->tria.reserve(_m->numF);
    
    _kdTriaAB = new SLKdTriaAABB[_m->numF];
 
+   // arena 0 is for the nodes split before the parallel build
+   _kdArenas = new SLKDNodeArena[SL_KD_NUMTASKS+1];
+   _kdRoot = _kdArenas[0].newNode();
+   _kdRoot->tria.reserve(_m->numF);
+
    //add all polygons to the root node
    for(SLuint i=0; i<_m->numF; i++)
    {  _kdRoot->tria.push_back(i);
-      // for findSplit3 calculate AABB and surface area  
-      _m->P[_m->F[i].iA].x;    
+      // for findSplit3 calculate AABB
       _kdTriaAB[i].min.x = SL_min(_m->P[_m->F[i].iA].x, 
                                   _m->P[_m->F[i].iB].x, 
                                   _m->P[_m->F[i].iC].x);
@@ -252,68 +249,158 @@ void SLKDTree::buildTree(SLint maxDepth, SLVec3f minV, SLVec3f maxV)
       _kdTriaAB[i].max.z = SL_max(_m->P[_m->F[i].iA].z, 
                                   _m->P[_m->F[i].iB].z, 
                                   _m->P[_m->F[i].iC].z);
-      
-      SLVec3f size(_kdTriaAB[i].max - _kdTriaAB[i].min);
-      _kdTriaAB[i].sa = 2*(size.x*size.y + size.x*size.z + size.y*size.z);
    }
    
-   if (_kdDump) printf("\n\nNew kdTree (max. depth: %d)\n", maxDepth);
+   if (_kdDump) SL_LOG("\n\nNew kdTree (max. depth: %d)\n", maxDepth);
    
-   splitNode(_kdRoot, 0, maxDepth, minV, maxV);
+   SLKDBuildStats stats = {0, 0, 0, 0, 0};
    
-   if (_kdDump) printf("\n\nMax. depth reached: %d\n", _kdMaxDepth);
+   // split the upper levels until there are enough subtrees
+   vector<SLKDBuildTask> tasks;
+   SLKDBuildTask root = {_kdRoot, 0, minV, maxV};
+   tasks.push_back(root);
+   SLuint next = 0;
+   while (next < tasks.size() && tasks.size()-next < SL_KD_NUMTASKS)
+   {  SLKDBuildTask task = tasks[next++];
+      if (splitNode(task.node, task.depth, maxDepth, task.minV, task.maxV,
+                    &_kdArenas[0], &stats))
+      {  SLKDBuildTask task1 = task, task2 = task;
+         task1.node = task.node->child1;
+         task2.node = task.node->child2;
+         task1.depth = task2.depth = task.depth+1;
+         task1.maxV.comp[task.node->splitAxis] = task.node->splitDist;
+         task2.minV.comp[task.node->splitAxis] = task.node->splitDist;
+         tasks.push_back(task1);
+         tasks.push_back(task2);
+      }
+   }
+
+   // build the open subtrees in parallel
+   SLint numTasks = (SLint)(tasks.size()-next);
+   SLKDBuildStats* taskStats = new SLKDBuildStats[SL_KD_NUMTASKS];
+
+   #ifdef SL_OMP
+   #pragma omp parallel for schedule(dynamic, 1)
+   #endif
+   for (SLint i=0; i<numTasks; ++i)
+   {  SLKDBuildTask& task = tasks[next+i];
+      SLKDBuildStats& s = taskStats[i];
+      s.numLeaves = s.numLeavesEmpty = s.numLeafTria = s.maxTria = 0;
+      s.maxDepth = 0;
+      buildNode(task.node, task.depth, maxDepth, task.minV, task.maxV,
+                &_kdArenas[i+1], &s);
+   }
+
+   // merge the statistics of the subtrees
+   for (SLint i=0; i<numTasks; ++i)
+   {  stats.numLeaves      += taskStats[i].numLeaves;
+      stats.numLeavesEmpty += taskStats[i].numLeavesEmpty;
+      stats.numLeafTria    += taskStats[i].numLeafTria;
+      stats.maxTria  = SL_max(stats.maxTria,  taskStats[i].maxTria);
+      stats.maxDepth = SL_max(stats.maxDepth, taskStats[i].maxDepth);
+   }
+   delete[] taskStats;
+
+   _voxCnt      = stats.numLeaves;
+   _voxCntEmpty = stats.numLeavesEmpty;
+   _voxMaxTria  = stats.maxTria;
+   _voxAvgTria  = (_voxCnt > _voxCntEmpty) ?
+                  (SLfloat)stats.numLeafTria / (_voxCnt-_voxCntEmpty) : 0;
+   _kdMaxDepth  = stats.maxDepth;
+   _kdNodeCnt   = 0;
+   for (SLint a=0; a<=SL_KD_NUMTASKS; ++a)
+      _kdNodeCnt += _kdArenas[a].numNodes();
+
+   // flatten the tree for the traversal and delete the build nodes
+   _kdNodes.reserve(_kdNodeCnt);
+   _kdTriaIdx.reserve(stats.numLeafTria);
+   flattenNode(_kdRoot);
+   delete[] _kdArenas;
+   _kdArenas = 0;
+   _kdRoot = 0;
+   _kdNumBytes = _kdNodes.capacity()*sizeof(SLKDFlatNode) +
+                 _kdTriaIdx.capacity()*sizeof(SLushort);
+
+   if (_kdDump)
+      SL_LOG("Nodes: %d, leaves: %d, empty: %d, max. depth reached: %d\n",
+             _kdNodeCnt, _voxCnt, _voxCntEmpty, _kdMaxDepth);
    
    // delete aabb's of triangles
-   if (_kdTriaAB) delete _kdTriaAB;
+   delete[] _kdTriaAB;
+   _kdTriaAB = 0;
+}
+//-----------------------------------------------------------------------------
+/*!
+SLKDTree::flattenNode appends node and its subtree depth first to the flat
+nodes. The triangle indexes of the leaves are appended to _kdTriaIdx.
+*/
+void SLKDTree::flattenNode(SLKDNode* node)
+{
+   SLuint i = _kdNodes.size();
+   _kdNodes.push_back(SLKDFlatNode());
+
+   if (node->splitAxis == NOAXIS)
+   {  _kdNodes[i].firstTria = _kdTriaIdx.size();
+      _kdNodes[i].bits = NOAXIS | (node->tria.size() << 2);
+      _kdTriaIdx.insert(_kdTriaIdx.end(), node->tria.begin(), node->tria.end());
+   }
+   else
+   {  // child1 follows its parent, child2 follows the subtree of child1
+      _kdNodes[i].splitDist = node->splitDist;
+      flattenNode(node->child1);
+      _kdNodes[i].bits = node->splitAxis | (_kdNodes.size() << 2);
+      flattenNode(node->child2);
+   }
+}
+//-----------------------------------------------------------------------------
+/*!
+SLKDTree::buildNode recursively builds the subtree below node. All nodes are
+allocated in the passed arena and the statistics go to stats, so that
+subtrees can be built on different threads.
+*/
+void SLKDTree::buildNode(SLKDNode* node, SLint depth, SLint maxDepth,
+                         SLVec3f minV, SLVec3f maxV,
+                         SLKDNodeArena* arena, SLKDBuildStats* stats)
+{
+   if (splitNode(node, depth, maxDepth, minV, maxV, arena, stats))
+   {  // child1 is below and child2 above the split plane
+      SLVec3f maxV1 = maxV, minV2 = minV;
+      maxV1.comp[node->splitAxis] = node->splitDist;
+      minV2.comp[node->splitAxis] = node->splitDist;
+
+      buildNode(node->child1, depth+1, maxDepth, minV, maxV1, arena, stats);
+      buildNode(node->child2, depth+1, maxDepth, minV2, maxV, arena, stats);
+   }
 }
 //-----------------------------------------------------------------------------
 /*! 
 SLKDTree::splitNode splits a kd node into 2 children and distributes the 
-triangles to them. The core method is one of the spit position finding routine
-kdFindSplit methods
+triangles to them. The split position is found by findSplit3 that also decides
+with the SAH whether the split is cheaper than a leaf. Returns false if the
+node becomes a leaf.
 */
-void SLKDTree::splitNode(SLKDNode* node, SLint depth, SLint maxDepth,
-                         SLVec3f minV, SLVec3f maxV)
+SLbool SLKDTree::splitNode(SLKDNode* node, SLint depth, SLint maxDepth,
+                           SLVec3f minV, SLVec3f maxV,
+                           SLKDNodeArena* arena, SLKDBuildStats* stats)
 {
-   static SLint i = 0;
-   static SLuchar axis = 0;
-   static const SLuint MINTRIAS = 10;
+   if (depth > stats->maxDepth) stats->maxDepth = depth;
  
-   if (depth > _kdMaxDepth) _kdMaxDepth = depth;
-   
-   if (depth >= maxDepth)
-   {  if (node->tria.size()>_voxMaxTria) _voxMaxTria = node->tria.size();
-      if (node->tria.size()==0) _voxCntEmpty++;
-      _voxCnt++;
-      return;
-   }
-   
-   i++;
-   
-   if (_kdDump) printf("Split %d: ", i);
-   
-   if(node->tria.size() < MINTRIAS) 
-   {  if (_kdDump) printf("Leaf: %d\n", node->tria.size());
-      if (node->tria.size()>_voxMaxTria) _voxMaxTria = node->tria.size();
-      if (node->tria.size()==0) _voxCntEmpty++;
-      _voxCnt++;
-      return;
+   if (depth >= maxDepth || !findSplit3(node, depth, minV, maxV))
+   {  SLuint numTria = node->tria.size();
+      if (_kdDump) SL_LOG("Leaf: %d\n", numTria);
+      if (numTria > stats->maxTria) stats->maxTria = numTria;
+      if (numTria == 0) stats->numLeavesEmpty++;
+      stats->numLeafTria += numTria;
+      stats->numLeaves++;
+      node->splitAxis = NOAXIS;
+      return false;
    }
    
-   // keep the parent size before
-   SLuint parentSize = node->tria.size();
-   
-   //////////////////////////////////////
-   findSplit1(node, depth, minV, maxV);
-   //////////////////////////////////////
-   
    // Set min & max corners of child nodes
    SLVec3f minV1 = minV, minV2 = minV;
    SLVec3f maxV1 = maxV, maxV2 = maxV;
-   if(node->splitAxis == XAXIS)  maxV1.x = minV2.x = node->splitDist; else 
-   if(node->splitAxis == YAXIS)  maxV1.y = minV2.y = node->splitDist; else 
-   if(node->splitAxis == ZAXIS)  maxV1.z = minV2.z = node->splitDist;
-   else printf("Error\n");
+   maxV1.comp[node->splitAxis] = node->splitDist;
+   minV2.comp[node->splitAxis] = node->splitDist;
    
    // Calculate voxel extention and center for triangle box overlap test
    SLVec3f voxExt1, voxExt2, center1, center2;
@@ -324,8 +411,8 @@ void SLKDTree::splitNode(SLKDNode* node, SLint depth, SLint maxDepth,
    SLfloat vert[3][3];
       
    // Create new children
-   node->child1 = new SLKDNode();
-   node->child2 = new SLKDNode();
+   node->child1 = arena->newNode();
+   node->child2 = arena->newNode();
      
    // loop through all triangle and add them to the left or right or both children
    for(SLuint i=0; i<node->tria.size(); ++i)
@@ -341,38 +428,24 @@ void SLKDTree::splitNode(SLKDNode* node, SLint depth, SLint maxDepth,
       vert[2][1] = _m->P[_m->F[iT].iC].y; 
       vert[2][2] = _m->P[_m->F[iT].iC].z;
    
-      if (triBoxOverlap(center1, voxExt1, vert))
-      {  node->child1->tria.push_back(node->tria[i]);
+      if (triBoxOverlap(center1.comp, voxExt1.comp, vert))
+      {  node->child1->tria.push_back(iT);
       } 
-      if(triBoxOverlap(center2, voxExt2, vert))
-      {  node->child2->tria.push_back(node->tria[i]);
+      if(triBoxOverlap(center2.comp, voxExt2.comp, vert))
+      {  node->child2->tria.push_back(iT);
       }
    }
      
-   // all trias are now in the childs so empty now the parent
-   node->tria.clear();
+   // all trias are now in the childs so free the parents list
+   SLVushort().swap(node->tria);
    
    if (_kdDump)
-   {  for(SLint t=0; t<depth; ++t) printf(" ");
-      printf("parent: %d, left: %d, right: %d\n", 
-              node->tria.size(),
-              node->child1->tria.size(),
-              node->child2->tria.size());
+   {  for(SLint t=0; t<depth; ++t) SL_LOG(" ");
+      SL_LOG("axis: %d, left: %d, right: %d\n", node->splitAxis,
+              (SLint)node->child1->tria.size(),
+              (SLint)node->child2->tria.size());
    }
-   
-   // termination if parent has the same size as child1
-   if (node->child1->tria.size() == parentSize &&
-       node->child2->tria.size() == parentSize)
-   {  if (_kdDump) printf("can't split anymore\n");
-      if (node->child1->tria.size()>_voxMaxTria) _voxMaxTria = node->child1->tria.size();
-      if (node->child2->tria.size()>_voxMaxTria) _voxMaxTria = node->child2->tria.size();
-      _voxCnt+=2;
-      return;
-   }
-     
-   // split children
-   splitNode(node->child1, depth+1, maxDepth, minV1, maxV1);
-   splitNode(node->child2, depth+1, maxDepth, minV2, maxV2);
+   return true;
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -381,6 +454,8 @@ SLKDTree::findSplit1 splits at center of the node and on its biggest axis
 void SLKDTree::findSplit1(SLKDNode* node, SLint depth, 
                           SLVec3f minV, SLVec3f maxV)
 {  
+   (void)depth; // avoid unused parameter warning
+   
    // Splitpoint is in the middle
    SLVec3f midPt;
    midPt.add(minV, maxV);
@@ -389,7 +464,7 @@ void SLKDTree::findSplit1(SLKDNode* node, SLint depth,
    // Split axis is the one that has the biggest extent
    SLVec3f size(maxV-minV);
    node->splitAxis = size.maxAxis();
-   node->splitDist = midPt[node->splitAxis];
+   node->splitDist = midPt.comp[node->splitAxis];
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -454,7 +529,7 @@ void SLKDTree::findSplit2(SLKDNode* node, SLint depth,
       // Split axis is the one that has the biggest extent
       SLVec3f size(maxV-minV);
       node->splitAxis = size.maxAxis();
-      node->splitDist = midPt[node->splitAxis];
+      node->splitDist = midPt.comp[node->splitAxis];
    } 
    else // if new MinMax is smaller that the parents MinMax there is empty space
    {
@@ -467,155 +542,140 @@ void SLKDTree::findSplit2(SLKDNode* node, SLint depth,
       
       if (maxDiffMin > maxDiffMax)
       {  node->splitAxis = maxAxisMin;
-         node->splitDist = newMin[maxAxisMin];
+         node->splitDist = newMin.comp[maxAxisMin];
       
       } else
       {  node->splitAxis = maxAxisMax;
-         node->splitDist = newMax[maxAxisMax];
+         node->splitDist = newMax.comp[maxAxisMax];
       }      
    }	
 }
 
 //-----------------------------------------------------------------------------
 /*! 
-SLKDTree::findSplit3: not finished
+SLKDTree::findSplit3 finds the split plane with the surface area heuristic
+(SAH). The cost of a split is the traversal cost plus the intersection costs
+of both children, weighted with the probability that a ray through the node
+also passes the child. This probability is the ratio of the surface areas.
+The SAH is only evaluated at the boundaries of SL_KD_NUMBINS bins per axis:
+The triangle AABB's, clipped to the node, are counted into the bin where they
+start and the bin where they end, so one sweep over the bins gives the No. of
+triangles left and right of every boundary. Returns false if no split is
+cheaper than intersecting all triangles in a leaf.
 */
-void SLKDTree::findSplit3(SLKDNode* node, SLint depth, 
-                          SLVec3f minV, SLVec3f maxV)
+SLbool SLKDTree::findSplit3(SLKDNode* node, SLint depth,
+                            SLVec3f minV, SLVec3f maxV)
 {  
-   // calculate size of parent node and the deltas of the bins
-   SLuint numBin = 16;
+   (void)depth; // avoid unused parameter warning
+   
+   SLuint  numTria = node->tria.size();
    SLVec3f size(maxV-minV);
-   SLVec3f delta(size/(SLfloat)numBin);
+   SLfloat SA = 2*(size.x*size.y + size.x*size.z + size.y*size.z);
+   if (numTria == 0 || SA <= 0) return false;
+   SLfloat invSA = 1.0f / SA;
    
-   // Loof over all axis & calculate minimal cost
-   for (SLuint axis=XAXIS; axis<=ZAXIS; ++axis)
+   // the cost of a leaf is the termination criterion
+   SLfloat minCost = SL_KD_COSTINTERSECT * numTria;
+   SLbool  found   = false;
+
+   // Loop over all axis & calculate minimal cost
+   for (SLint axis=XAXIS; axis<=ZAXIS; ++axis)
    {
-      // allocate bins for counting AABB min & max 
-      SLVuint* binMin = new SLVuint[numBin];
-      SLVuint* binMax = new SLVuint[numBin];
+      if (size.comp[axis] <= 0) continue;
+
+      SLuint binMin[SL_KD_NUMBINS];  // No. of AABB's starting in a bin
+      SLuint binMax[SL_KD_NUMBINS];  // No. of AABB's ending in a bin
+      memset(binMin, 0, sizeof(binMin));
+      memset(binMax, 0, sizeof(binMax));
    
       ////////////////////////////////////////
       // STEP 1: Fill in the min & max bins //
       ////////////////////////////////////////
       
-      // loop over triangles of bin & increment start and end bin
-      for(SLuint i=0; i<node->tria.size(); ++i)
-      {  
-         // loop through bins & search the triangles min & max bin
-         SLfloat minBound = minV[axis];
-         SLbool  foundMin = false;
-         for (SLuint b=0; b<numBin; ++b)
-         {  // check if the triangle minimum is in this bin
-            if (!foundMin && 
-                _kdTriaAB[i].min[axis] > minBound && 
-                _kdTriaAB[i].min[axis] <= minBound+delta[axis])
-            {  binMin[b].push_back(i);    // add the index of the triangle to this bin
-               foundMin = true;           // don't look for the minimum anymore     
-            }
-            // check if the triangle maximum is in this bin
-            if ( foundMin && 
-                _kdTriaAB[i].max[axis] > minBound && 
-                _kdTriaAB[i].max[axis] <= minBound+delta[axis])
-            {  binMax[b].push_back(i);   // add the index of the triangle to this bin
-               break;                     // found min & max
-            }
-            minBound += delta[axis];      // increment the left boundry of the bin
-         }
+      SLfloat delta    = size.comp[axis] / SL_KD_NUMBINS;
+      SLfloat invDelta = SL_KD_NUMBINS / size.comp[axis];
+
+      for(SLuint i=0; i<numTria; ++i)
+      {  SLKdTriaAABB& ab = _kdTriaAB[node->tria[i]];
+         SLint bMin = (SLint)((ab.min.comp[axis] - minV.comp[axis]) * invDelta);
+         SLint bMax = (SLint)((ab.max.comp[axis] - minV.comp[axis]) * invDelta);
+         binMin[SL_clamp(bMin, 0, SL_KD_NUMBINS-1)]++;
+         binMax[SL_clamp(bMax, 0, SL_KD_NUMBINS-1)]++;
       }
       
       ///////////////////////////////////////////////////////
       // STEP 2: Calculate the SAH on all in bin boundries //
       ///////////////////////////////////////////////////////
       
-      SLfloat* cost    = new SLfloat[numBin-1];   // SAH cost at x-boundries
-      SLfloat* SALeft  = new SLfloat[numBin-1];   // surface are to the left at x-boundries
-      SLfloat* SARight = new SLfloat[numBin-1];   // surface are to the right at x-boundries
+      // the surface area of a child is linear in its length along the axis
+      SLint   axis1    = NEXTAXIS(axis);
+      SLint   axis2    = NEXTAXIS(axis1);
+      SLfloat capArea  = size.comp[axis1] * size.comp[axis2];
+      SLfloat capPerim = size.comp[axis1] + size.comp[axis2];
       
-      for (SLuint b=0; b<numBin-1; ++b)
+      SLuint numLeft  = 0;
+      SLuint numRight = numTria;
+
+      for (SLint b=1; b<SL_KD_NUMBINS; ++b)
       {  
-         cost[b] = 0;
-         SALeft[b] = 0;
-         SARight[b] = 0;
+         numLeft  += binMin[b-1];
+         numRight -= binMax[b-1];
          
-         // sum up SA of all AABB that have their max to the left
-         SLuint leftBin;
-         for (leftBin=0; leftBin<b+1; ++leftBin)
-         {  for (SLuint i=0; i<binMax[leftBin].size()-1; ++i)
-            {  SALeft[b] += _kdTriaAB[binMax[leftBin][i]].sa;
-            }
-         }
-         // add the SA of all AABB the have their min in the bin to the left
-         for (SLuint i=0; i<binMax[leftBin].size()-1; ++i)
-         {  SALeft[b] += _kdTriaAB[binMax[leftBin][i]].sa;
+         SLfloat lenLeft  = b*delta;
+         SLfloat lenRight = size.comp[axis] - lenLeft;
+         SLfloat SALeft   = 2*(capArea + capPerim*lenLeft);
+         SLfloat SARight  = 2*(capArea + capPerim*lenRight);
+
+         SLfloat cost = SL_KD_COSTTRAVERSE + SL_KD_COSTINTERSECT *
+                        (SALeft*invSA*numLeft + SARight*invSA*numRight);
+
+         // prefer splits that cut off empty space
+         if (numLeft == 0 || numRight == 0) cost *= 1.0f - SL_KD_EMPTYBONUS;
+
+         if (cost < minCost)
+         {  minCost = cost;
+            node->splitAxis = (SLuchar)axis;
+            node->splitDist = minV.comp[axis] + lenLeft;
+            found = true;
          }
-         
       }
-      
-      //////////////
-      // clean up //
-      //////////////
-      
-      if (cost)    delete cost;
-      if (SALeft)  delete SALeft;
-      if (SARight) delete SARight;
-      if (binMin)  delete binMin;
-      if (binMax)  delete binMax;
-      
    } // for loop axis
+         
+   return found;
 }
 
 //-----------------------------------------------------------------------------
-/*! 
-SLKDTree::drawNode recursively draws all split planes of all nodes
+/*!
+SLKDTree::drawNode recursively adds the outlines of all split planes as line
+vertices.
 */
-void SLKDTree::drawNode(SLKDNode* node, SLint depth, 
-                        SLVec3f minV, SLVec3f maxV)
-{  if (node==0) return;
-   if (node->splitAxis==NOAXIS) return;
-   
-   // draw split plane
-   glDisable(GL_CULL_FACE);
-   glEnable(GL_BLEND);
-   glBegin(GL_QUADS);
-   if (node->splitAxis==XAXIS) 
-   {  glColor4f(1, 0, 1, 0.5f); 
-      // right rect
-      glVertex3r(node->splitDist, minV.y, minV.z);
-      glVertex3r(node->splitDist, maxV.y, minV.z);
-      glVertex3r(node->splitDist, maxV.y, maxV.z);
-      glVertex3r(node->splitDist, minV.y, maxV.z);
-   } else if (node->splitAxis==YAXIS) 
-   {  glColor4f(1, 1, 0, 0.5f); 
-      glVertex3r(minV.x, node->splitDist, minV.z);
-      glVertex3r(maxV.x, node->splitDist, minV.z);
-      glVertex3r(maxV.x, node->splitDist, maxV.z);
-      glVertex3r(minV.x, node->splitDist, maxV.z);
-   } else if (node->splitAxis==ZAXIS)
-   {  glColor4f(0, 1, 1, 0.5f);
-      glVertex3r(minV.x, minV.y, node->splitDist); 
-      glVertex3r(minV.x, maxV.y, node->splitDist);
-      glVertex3r(maxV.x, maxV.y, node->splitDist);
-      glVertex3r(maxV.x, minV.y, node->splitDist);
-   } 
-   glEnd();
-   glDisable(GL_BLEND);
-   glEnable(GL_CULL_FACE);
-   
+void SLKDTree::drawNode(SLuint node, SLVec3f minV, SLVec3f maxV,
+                        SLVVec3f& lines)
+{  SLKDFlatNode& n = _kdNodes[node];
+   if (n.axis()==NOAXIS) return;
+
+   // corners of the split rectangle
+   SLint   axis  = n.axis();
+   SLint   axis1 = NEXTAXIS(axis);
+   SLint   axis2 = NEXTAXIS(axis1);
+   SLVec3f corner[4];
+   for (SLint c=0; c<4; ++c)
+   {  corner[c].comp[axis] = n.splitDist;
+      corner[c].comp[axis1] = (c==1 || c==2) ? maxV.comp[axis1] : minV.comp[axis1];
+      corner[c].comp[axis2] = (c >= 2)       ? maxV.comp[axis2] : minV.comp[axis2];
+   }
+   for (SLint c=0; c<4; ++c)
+   {  lines.push_back(corner[c]);
+      lines.push_back(corner[(c+1)%4]);
+   }
+
    // Set min & max corners of child nodes
-   SLVec3f minV1 = minV;
-   SLVec3f minV2 = minV;
-   SLVec3f maxV1 = maxV;
-   SLVec3f maxV2 = maxV;
-   if(node->splitAxis == 0) 
-      maxV1.x = minV2.x = node->splitDist; 
-   else if(node->splitAxis == 1)  
-      maxV1.y = minV2.y = node->splitDist; 
-   else if(node->splitAxis == 2)
-      maxV1.z = minV2.z = node->splitDist;
-   
+   SLVec3f maxV1 = maxV, minV2 = minV;
+   maxV1.comp[axis] = n.splitDist;
+   minV2.comp[axis] = n.splitDist;
+
    // draw children by recurse
-   drawNode(node->child1, depth+1, minV1, maxV1);
-   drawNode(node->child2, depth+1, minV2, maxV2);   
+   drawNode(node+1,     minV, maxV1, lines);
+   drawNode(n.child2(), minV2, maxV, lines);
 }
 //-----------------------------------------------------------------------------
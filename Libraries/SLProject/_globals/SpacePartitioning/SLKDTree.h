@@ -13,11 +13,32 @@
 #include <SLAccelStruct.h>
 #include <SLKDNode.h>
 
+//-----------------------------------------------------------------------------
+//! Statistics of a kd-tree or subtree build
+struct SLKDBuildStats
+{  SLuint   numLeaves;     //!< No. of leaf nodes
+   SLuint   numLeavesEmpty;//!< No. of empty leaf nodes
+   SLuint   numLeafTria;   //!< Sum of triangle references in all leaves
+   SLuint   maxTria;       //!< max. No. of triangles in a leaf
+   SLint    maxDepth;      //!< max. depth reached
+};
+//-----------------------------------------------------------------------------
+//! Node of the kd-tree that is still to be built with its cell
+struct SLKDBuildTask
+{  SLKDNode*   node;
+   SLint       depth;
+   SLVec3f     minV;
+   SLVec3f     maxV;
+};
 //-----------------------------------------------------------------------------
 //! SLKDTree implements the kd-tree space partitioning structure.
 /*! A kd-tree is an axis aligned binary space partitioning (BSP) structure that
 recursively splits the space on one dimension x, y or z. The art is the fast
 finding of the optimal split position in a way that produce big empty cells.
+The split positions are found with the surface area heuristic (SAH) in
+findSplit3. The upper levels are split on one thread and the subtrees below
+are built in parallel, each into its own SLKDNodeArena. The built tree is
+then flattened into an array of 8 byte SLKDFlatNode's for the traversal.
 */
 class SLKDTree: public SLAccelStruct 
 {  public:                     
@@ -29,25 +50,45 @@ class SLKDTree: public SLAccelStruct
                void           draw        (SLSceneView* sv);
                SLbool         intersect   (SLRay* ray);
                
+               // Delete the vertex buffer object if not rendered anymore
+               void           disposeBuffers (){ if (_bufP.id()) _bufP.dispose();}
+
                void           buildTree   (SLint maxDepth,
                                            SLVec3f minV, SLVec3f maxV);
-               void           splitNode   (SLKDNode* node, 
+               void           buildNode   (SLKDNode* node,
                                            SLint depth, SLint maxDepth, 
-                                           SLVec3f minV, SLVec3f maxV);
+                                           SLVec3f minV, SLVec3f maxV,
+                                           SLKDNodeArena* arena,
+                                           SLKDBuildStats* stats);
+               SLbool         splitNode   (SLKDNode* node,
+                                           SLint depth, SLint maxDepth,
+                                           SLVec3f minV, SLVec3f maxV,
+                                           SLKDNodeArena* arena,
+                                           SLKDBuildStats* stats);
                void           findSplit1  (SLKDNode* node, SLint depth,
                                            SLVec3f minV, SLVec3f maxV);
                void           findSplit2  (SLKDNode* node, SLint depth,
                                            SLVec3f minV, SLVec3f maxV);
-               void           findSplit3  (SLKDNode* node, SLint depth,
-                                           SLVec3f minV, SLVec3f maxV);
-               void           drawNode    (SLKDNode* node, SLint depth,
+               SLbool         findSplit3  (SLKDNode* node, SLint depth,
                                            SLVec3f minV, SLVec3f maxV);
+               void           flattenNode (SLKDNode* node);
+               void           drawNode    (SLuint node,
+                                           SLVec3f minV, SLVec3f maxV,
+                                           SLVVec3f& lines);
    private:
-               SLKDNode*	   _kdRoot;       //!< pointer to root kd-node
+               void           deleteTree  ();
+
+               SLKDNode*	   _kdRoot;       //!< pointer to root kd-node while building
+               SLKDNodeArena* _kdArenas;     //!< node arenas, one per subtree task
+               SLVKDFlatNode  _kdNodes;      //!< flattened nodes, root first
+               SLVushort      _kdTriaIdx;    //!< packed triangle indexes of all leaves
                SLbool         _kdDump;       //!< flag for tree dump
-               SLuint         _kdNodeCnt;    //!< Num. of leaf nodes
+               SLuint         _kdNodeCnt;    //!< Num. of nodes
                SLint          _kdMaxDepth;   //!< max. depth of kd splits
+               SLuint         _kdNumBytes;   //!< Num. of bytes of flat nodes & leaf lists
                SLKdTriaAABB*  _kdTriaAB;     //!< array with aabb's of triangles
+
+               SLGLBuffer     _bufP;         //!< Buffer object for split planes
 };
 //-----------------------------------------------------------------------------
 #endif //SLKDTREE_H
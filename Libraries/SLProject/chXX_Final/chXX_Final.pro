@@ -50,6 +50,8 @@ HEADERS += \
     ../_globals/SL/SLVector.h \
     ../_globals/SL/stdafx.h \
     ../_globals/SpacePartitioning/SLAccelStruct.h \
+    ../_globals/SpacePartitioning/SLKDNode.h \
+    ../_globals/SpacePartitioning/SLKDTree.h \
     ../_globals/SpacePartitioning/SLUniformGrid.h \
     include/SLAABBox.h \
     include/SLAnimation.h \
@@ -77,6 +79,7 @@ HEADERS += \
     include/SLScene.h \
     include/SLSceneView.h \
     include/SLShape.h \
+    include/SLShapeBVH.h \
     include/SLSphere.h \
     include/SLText.h
 
@@ -98,6 +101,7 @@ SOURCES += \
     ../_globals/SL/SLInterface.cpp \
     ../_globals/SL/SLTexFont.cpp \
     ../_globals/SL/SLTimer.cpp \
+    ../_globals/SpacePartitioning/SLKDTree.cpp \
     ../_globals/SpacePartitioning/SLUniformGrid.cpp \
     source/SLAABBox.cpp \
     source/SLAnimation.cpp \
@@ -124,6 +128,7 @@ SOURCES += \
     source/SLSceneView.cpp \
     source/SLScene_onLoad.cpp \
     source/SLShape.cpp \
+    source/SLShapeBVH.cpp \
     source/SLSphere.cpp \
     source/SLText.cpp \
     source/SLPhotonMapper.cpp \
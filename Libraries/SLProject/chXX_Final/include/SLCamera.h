@@ -122,6 +122,11 @@ class SLCamera: public SLShape
                void        lensDiameter   (const SLfloat d)    {_lensDiameter = d;}
                void        lensSamples    (SLint x, SLint y)   {_lensSamples.samples(x, y);}
                void        eyeSep         (const SLfloat es)   {_eyeSep = es;}
+               void        intrinsics     (const SLfloat fx, const SLfloat fy,
+                                           const SLfloat cx, const SLfloat cy,
+                                           const SLint imgW, const SLint imgH);
+               void        vm             (const SLMat4f& vm)  {_vm = vm; 
+                                                                setWMandState();}
                
                // Getters
                SLMat4f     vm             () {return _vm;}
@@ -138,6 +143,7 @@ class SLCamera: public SLShape
                SLfloat     lensDiameter   () {return _lensDiameter;}
                SLSamples2D* lensSamples   () {return &_lensSamples;} 
                SLfloat     eyeSep         () {return _eyeSep;}
+               SLbool      hasIntrinsics  () {return _fx > 0;}
                SLfloat     focalDistScrW  ();
                SLfloat     focalDistScrH  ();
                SLRay*      lookAtRay      () {return &_lookAtRay;}
@@ -182,6 +188,11 @@ class SLCamera: public SLShape
 
                // Stereo rendering
                SLfloat     _eyeSep;       //!< eye separation for stereo mode
+               
+               // Calibrated pinhole camera (augmented reality)
+               SLfloat     _fx, _fy;      //!< focal lengths in pixels, 0=not calibrated
+               SLfloat     _cx, _cy;      //!< principal point in pixels
+               SLint       _imgW, _imgH;  //!< size of the calibrated camera image
 };
 //-----------------------------------------------------------------------------
 #endif
@@ -13,6 +13,7 @@
 #include <stdafx.h>
 #include "SLShape.h"
 #include "SLAABBox.h"
+#include "SLShapeBVH.h"
 
 class SLSceneView;
 class SLNode;
@@ -24,6 +25,8 @@ class SLRay;
 The SLGroup represents a group of children nodes in the scenegraph. Because it
 is a node it has a draw method that just calls all its children's draw methods.
 Because it is derived from SLShape it also has it's own local transformation.
+For ray tracing the group builds a bounding volume hierarchy (SLShapeBVH) over
+its children in buildAABB, so a ray is not tested against every child.
 */
 //-----------------------------------------------------------------------------
 class SLGroup : public SLShape
@@ -36,6 +39,7 @@ class SLGroup : public SLShape
                SLShape*    shapeCopy   ();
                void        updateStats (SLGroup* parent);               
                SLAABBox&   buildAABB   ();
+               SLAABBox&   updateAABB  ();
                SLbool      shapeHit    (SLRay* ray);
                void        preShade    (SLRay* ray){(void)ray;}
 
@@ -68,6 +72,7 @@ class SLGroup : public SLShape
    protected:    
                SLNode*     _first;        //!< Pointer to the first child node
                SLNode*     _last;         //!< Pointer to the last child node
+               SLShapeBVH  _bvh;          //!< Hierarchy over the children for RT
 };
 //-----------------------------------------------------------------------------
 #endif
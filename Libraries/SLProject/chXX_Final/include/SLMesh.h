@@ -40,6 +40,13 @@ struct SLMatFaces
    SLMaterial* mat;  //!< pointer to material in scene material
 };
 //-----------------------------------------------------------------------------
+//! Acceleration structure for the ray-mesh intersection
+typedef enum
+{  accelNone,        // all triangles are tested (brute force)
+   accelUniformGrid, // SLUniformGrid
+   accelKDTree       // SLKDTree with SAH split planes
+} SLAccelType;
+//-----------------------------------------------------------------------------
 //!The SLMesh class represents a triangle mesh object w. a face-vertex list.
 /*!
 The SLMesh class represents a single triangle mesh object. The vertex 
@@ -75,6 +82,10 @@ class SLMesh: public SLShape
                void           calcMinMax     (SLVec3f &minV, SLVec3f &maxV);
                void           calcCenterRad  (SLVec3f& center, SLfloat& radius);
                SLbool         hitTriangleOS  (SLRay* ray, SLushort iT);
+               
+               // Setters & Getters
+               void           accelType      (SLAccelType type);
+               SLAccelType    accelType      () {return _accelType;}
                               
                SLVec3f*       P;       //!< Array of vertex positions
                SLVec3f*       N;       //!< Array of vertex normals
@@ -87,6 +98,9 @@ class SLMesh: public SLShape
                SLushort       numV;    //!< Number of elements in P, N, T, B & Tc   
                SLuint         numF;    //!< Number of elements in F           
                SLushort       numM;    //!< Number of elements in M
+               
+               //! Acceleration structure type of new meshes
+               static SLAccelType defaultAccelType;
    
    protected:
                SLGLBuffer     _bufP;   //!< Buffer for vertex positions
@@ -103,6 +117,7 @@ class SLMesh: public SLShape
                SLbool         _isVolume;
                
                SLAccelStruct* _accelStruct;  //!< KD-tree or uniform grid
+               SLAccelType    _accelType;    //!< type of _accelStruct
 };
 //-----------------------------------------------------------------------------
 #endif //SLMESH_H
@@ -22,6 +22,50 @@ enum SLRayType {PRIMARY=0, REFLECTED=1, TRANSMITTED=2, SHADOW=3};
 #define SL_MAXTRACE    15
 #define SL_MAXRAYCACHE 3 * SL_MAXTRACE + 1  // max.type * SL_MAXTRACE
 
+//-----------------------------------------------------------------------------
+//! Ray tracing statistics of one thread
+/*!
+Every thread of SLRaytracer::render counts into its own instance which is 
+merged into the ray tracers statistics at the end. Rays get the instance of 
+their primary ray, so the counters are never shared between threads.
+*/
+struct SLRayStats
+{           SLRayStats  () {reset();}
+   
+   void     reset       ()
+            {  reflectedRays = refractedRays = shadowRays = tirRays = 0;
+               tests = intersections = 0;
+               subsampledRays = subsampledPixels = 0;
+               depthReached = 1;
+               maxDepthReached = 0;
+               avgDepth = 0.0f;
+            }
+            
+   void     add         (const SLRayStats& s)
+            {  reflectedRays    += s.reflectedRays;
+               refractedRays    += s.refractedRays;
+               shadowRays       += s.shadowRays;
+               tirRays          += s.tirRays;
+               tests            += s.tests;
+               intersections    += s.intersections;
+               subsampledRays   += s.subsampledRays;
+               subsampledPixels += s.subsampledPixels;
+               maxDepthReached   = SL_max(maxDepthReached, s.maxDepthReached);
+               avgDepth         += s.avgDepth;
+            }
+   
+   SLuint   reflectedRays;    //!< NO. of reflected rays
+   SLuint   refractedRays;    //!< NO. of transmitted rays
+   SLuint   shadowRays;       //!< NO. of shadow rays
+   SLuint   tirRays;          //!< NO. of TIR refraction rays
+   SLuint   tests;            //!< NO. of intersection tests
+   SLuint   intersections;    //!< NO. of intersection
+   SLuint   subsampledRays;   //!< NO. of of subsampled rays
+   SLuint   subsampledPixels; //!< NO. of of subsampled pixels
+   SLint    depthReached;     //!< depth reached for the current primary ray
+   SLint    maxDepthReached;  //!< max. depth reached for all rays
+   SLfloat  avgDepth;         //!< sum of the depths reached by the primary rays
+};
 //-----------------------------------------------------------------------------
 //! Ray class with ray and intersection properties
 /*!
@@ -70,6 +114,11 @@ class SLRay
                                        sign[1]=(invDir.y<0);
                                        sign[2]=(invDir.z<0);
                                     }    
+            //! Counts the depth of a secondary ray for its primary ray
+     inline void        countDepth  (SLint d)
+                                    {  if (d > stats->depthReached) 
+                                          stats->depthReached = d;
+                                    }
      inline void        setDirOS    (SLVec3f Dir)
                                     {  dirOS = Dir;
                                        invDirOS.x=(SLfloat)(1/dirOS.x);
@@ -119,21 +168,14 @@ class SLRay
             SLint       signOS[3];     //!< Sign of invDir for fast AABB hit in OS
             SLfloat     tmin;          //!< min. dist. of last AABB intersection
             SLfloat     tmax;          //!< max. dist. of last AABB intersection
+            
+            // Statistics
+            SLRayStats* stats;         //!< Counters of the thread tracing the ray
 
-     // static variables for statistics
+     // static variables for ray tracing
      static SLint       maxDepth;         //!< Max. recursion depth
      static SLfloat     minContrib;       //!< Min. contibution to color (1/256)
-     static SLuint      reflectedRays;    //!< NO. of reflected rays
-     static SLuint      refractedRays;    //!< NO. of transmitted rays
-     static SLuint      shadowRays;       //!< NO. of shadow rays
-     static SLuint      tirRays;          //!< NO. of TIR refraction rays
-     static SLuint      tests;            //!< NO. of intersection tests
-     static SLuint      intersections;    //!< NO. of intersection
-     static SLint       depthReached;     //!< depth reached for a primary ray
-     static SLint       maxDepthReached;  //!< max. depth reached for all rays
-     static SLfloat     avgDepth;         //!< average depth reached
-     static SLuint      subsampledRays;   //!< NO. of of subsampled rays
-     static SLuint      subsampledPixels; //!< NO. of of subsampled pixels
+     static SLRayStats  defaultStats;     //!< Counters of rays outside of ray tracing
 
      //statistics for photonmapping
      static SLlong      emittedPhotons;   //!< NO. of emitted photons from all lightsources
@@ -13,11 +13,12 @@
 #include <stdafx.h>
 #include <SLGLTexture.h>
 #include <SLGLBuffer.h>
-#include <SLEventhandler.h>
+#include <SLEventHandler.h>
+#include <SLRay.h>
 
 class SLScene;
 class SLSceneView;
-class SLRay;
+class SLCamera;
 class SLMaterial;
 
 //-----------------------------------------------------------------------------
@@ -29,16 +30,26 @@ typedef enum
    rtMoveGL,   // RT is finished and GL camera is moving
 } SLStateRT;
 //-----------------------------------------------------------------------------
+//! Ray tracing pass over all tiles
+typedef enum
+{  rtPassPreview, // one ray per SL_RTPREVIEW x SL_RTPREVIEW pixels
+   rtPassFull,    // all pixels not done in the preview
+   rtPassAA       // subsampling of the pixels with high contrast
+} SLRTPass;
+//-----------------------------------------------------------------------------
+#define SL_RTTILESIZE 32   // width and height of a tile in pixels
+#define SL_RTPREVIEW  8    // pixel size of the preview, divides SL_RTTILESIZE
+//-----------------------------------------------------------------------------
 // callback function typedef for ray tracing gui window update
 typedef SLbool (SL_STDCALL *cbRTWndUpdate)(void);
 //-----------------------------------------------------------------------------
-//! Pixel index struct used in anti aliasing in ray tracing
-struct SLRTAAPixel
-{  SLRTAAPixel(SLushort X=0, SLushort Y=0) {x=X;y=Y;}
-   SLushort x;      //!< Unsigned short x-pixel index
-   SLushort y;      //!< Unsigned short x-pixel index
+//! Tile struct used for the parallel scheduling of the ray tracing
+struct SLRTTile
+{  SLRTTile(SLushort X=0, SLushort Y=0) {x=X;y=Y;}
+   SLushort x;      //!< Unsigned short x-pixel index of the left column
+   SLushort y;      //!< Unsigned short y-pixel index of the bottom row
 };
-typedef SLVector<SLRTAAPixel, SLuint> SLVPixel;
+typedef SLVector<SLRTTile, SLuint> SLVTile;
 //-----------------------------------------------------------------------------
 //! SLRaytracer hold all the methods for Whitted style Ray Tracing.
 /*!      
@@ -58,15 +69,28 @@ class SLRaytracer: public SLGLTexture, public SLEventHandler
             SLCol4f     trace          (SLRay* ray);
             SLCol4f     shade          (SLRay* ray);
             
+            // tile scheduling
+            void        createTiles    (SLint width, SLint height);
+            void        renderTiles    (SLRTPass pass, 
+                                        SLint pcStart, SLint pcEnd);
+            void        renderTile     (const SLRTTile& tile, 
+                                        SLRTPass pass, 
+                                        SLRayStats* stats);
+            SLCol4f     primaryColor   (SLint x, SLint y, SLRayStats* stats);
+            SLCol4f     tracePrimary   (SLRay* primaryRay, SLRayStats* stats);
+            void        markAAPixels   ();
+            
             // additional ray tracer functions 
             SLCol4f     subSample      (SLint x, SLint y, 
                                         SLCol4f centerColor, 
                                         SLVec3f EYE, SLVec3f TL, 
                                         SLVec3f LR, SLVec3f LU, 
-                                        SLfloat pixel);
+                                        SLfloat pixel,
+                                        SLRayStats* stats);
             SLCol4f     fogBlend       (SLfloat z, SLCol4f color);
             void        printStats     (SLfloat sec);
             void        initStats      (SLint depth);
+            void        mergeStats     (const SLRayStats& stats);
             
             // Setters
             void        state          (SLStateRT state) {if (_state!=rtBusy) _state=state;}
@@ -83,6 +107,7 @@ class SLRaytracer: public SLGLTexture, public SLEventHandler
             SLint       pcRendered     () {return _pcRendered;}
             SLfloat     aaThreshold    () {return _aaThreshold;}
             SLfloat     renderSec      () {return _renderSec;}
+      const SLRayStats& stats          () {return _stats;}
             
             // Render target image
             void        createImage    (SLint width, SLint height);
@@ -106,6 +131,25 @@ class SLRaytracer: public SLGLTexture, public SLEventHandler
             SLfloat      _aaThreshold; //!< threshold for anti aliasing
             SLint        _aaSamples;   //!< SQRT of uneven num. of AA samples
             SLint        _numThreads;  //!< Num. of threads used for RT
+            SLRayStats   _stats;       //!< Merged statistics of the last rendering
+            
+            // variables for the tile scheduling
+            SLVTile      _tiles;       //!< Tiles in Morton order
+            SLbool       _preview;     //!< Flag if a preview pass is rendered
+            SLbool*      _aaPixels;    //!< Flags of the pixels to subsample
+            volatile SLbool _stop;     //!< Flag that cancels all threads
+            SLTimer      _timer;       //!< Wall clock timer of the rendering
+            SLfloat      _lastGUIUpdate; //!< Time of the last GUI update
+            
+            // camera values of the current rendering
+            SLCamera*    _cam;         //!< Camera of the active scene view
+            SLVec3f      _EYE;         //!< Eye position in WS
+            SLVec3f      _LR;          //!< Look right vector
+            SLVec3f      _LU;          //!< Look up vector
+            SLVec3f      _BL;          //!< Vector to the bottom left pixel
+            SLfloat      _pxSize;      //!< Pixel size in WS
+            SLVec3f      _lensRadiusX; //!< Lens radius along LR
+            SLVec3f      _lensRadiusY; //!< Lens radius along LU
             
             SLGLBuffer   _bufP;        //!< Buffer object for vertex positions
             SLGLBuffer   _bufT;        //!< Buffer object for vertex texcoords
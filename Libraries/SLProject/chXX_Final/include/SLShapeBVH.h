@@ -0,0 +1,68 @@
+//#############################################################################
+//  File:      SLShapeBVH.h
+//  Date:      May 2013
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#ifndef SLSHAPEBVH_H
+#define SLSHAPEBVH_H
+
+#include <stdafx.h>
+#include "SLShape.h"
+
+class SLGroup;
+class SLRay;
+
+#define SL_BVH_MINSHAPES 8    // min. no. of shapes worth building a BVH
+#define SL_BVH_LEAFSIZE  2    // max. no. of shapes in a leaf
+#define SL_BVH_MAXDEPTH  64   // max. depth of the traversal stack
+
+//-----------------------------------------------------------------------------
+//! Node of a SLShapeBVH
+struct SLShapeBVHNode
+{  SLVec3f  minWS;   //!< Min. corner of the node in world space
+   SLVec3f  maxWS;   //!< Max. corner of the node in world space
+   SLint    first;   //!< Index of the first shape for leaves or the left child
+   SLint    count;   //!< NO. of shapes for leaves, 0 for inner nodes
+};
+typedef std::vector<SLShapeBVHNode> SLVShapeBVHNode;
+//-----------------------------------------------------------------------------
+//! Bounding volume hierarchy over the world space AABBs of a groups children
+/*!
+The SLShapeBVH is the top level of the two level acceleration structure for
+ray tracing: It finds the child shapes of a group hit by a ray, while the 
+meshes use their own acceleration structures (SLAccelStruct) for their 
+triangles. Without it every ray is tested against every child AABB.
+The tree is built in SLGroup::buildAABB with an object median split along the
+axis with the largest extent of the shape centers. When animations move the
+shapes SLGroup::updateAABB only refits the node bounds, because the 
+neighbourhood of the shapes changes little from frame to frame. The right 
+child of an inner node always follows its left child in the node array and 
+children always come after their parent.
+*/
+class SLShapeBVH
+{  public:
+                           SLShapeBVH  ();
+                          ~SLShapeBVH  () {;}
+               
+               void        build       (SLGroup* group);
+               void        refit       ();
+               void        clear       ();
+               SLbool      hit         (SLRay* ray);
+               
+               // Getters
+               SLbool      isBuilt     () {return _nodes.size() > 0;}
+               SLuint      numNodes    () {return (SLuint)_nodes.size();}
+               SLuint      numBytes    () {return (SLuint)(_nodes.size()*sizeof(SLShapeBVHNode) + 
+                                                           _shapes.size()*sizeof(SLShape*));}
+   private:
+               void        subdivide   (SLint iNode, SLint first, SLint count);
+               void        fitNode     (SLShapeBVHNode& node);
+               SLbool      isHitInWS   (SLShapeBVHNode& node, SLRay* ray, SLfloat& tmin);
+               
+               SLVShapeBVHNode _nodes; //!< Nodes with the root at index 0
+               SLVShape    _shapes;    //!< Shapes sorted by the leaves
+};
+//-----------------------------------------------------------------------------
+#endif
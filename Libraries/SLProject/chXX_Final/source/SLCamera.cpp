@@ -42,6 +42,10 @@ SLCamera::SLCamera() : SLShape("Camera")
    
    _eyeSep = _focalDist / 30.0f;
    _speedLimit = 2.0f;
+   
+   // not calibrated
+   _fx = _fy = _cx = _cy = 0.0f;
+   _imgW = _imgH = 0;
 }
 //-----------------------------------------------------------------------------
 //! Destructor: Be sure to delete the OpenGL display list.
@@ -253,7 +257,15 @@ void SLCamera::setProjection(const SLEye eye)
    
    switch (_projection) 
    {  case monoPerspective:
-         stateGL->projectionMatrix.perspective(_fov, aspect, _clipNear, _clipFar);
+         if (hasIntrinsics())
+         {  // frustum of the real camera, its image fills the viewport
+            left   = -_cx * _clipNear / _fx;
+            right  = ((SLfloat)_imgW - _cx) * _clipNear / _fx;
+            top    = _cy * _clipNear / _fy;
+            bottom = -((SLfloat)_imgH - _cy) * _clipNear / _fy;
+            stateGL->projectionMatrix.frustum(left,right,bottom,top,_clipNear,_clipFar);
+         } else
+            stateGL->projectionMatrix.perspective(_fov, aspect, _clipNear, _clipFar);
          break; 
       case monoOrthographic:
          top    = tan(SL_DEG2RAD*_fov/2) * pos.length();
@@ -295,9 +307,10 @@ void SLCamera::setProjection(const SLEye eye)
    
    
    // Clear Buffers
-   if (eye==rightEye) 
+   if (eye==rightEye || hasIntrinsics()) 
       // Do not clear color on right eye because it contains the color of the
-      // left eye. The right eye must be drawn after the left into the same buffer
+      // left eye. The right eye must be drawn after the left into the same buffer.
+      // A calibrated camera draws over its video image that is drawn before.
       stateGL->clearDepthBuffer();
    else 
       stateGL->clearColorDepthBuffer();
@@ -366,6 +379,30 @@ void SLCamera::setView(const SLEye eye)
    } 
 }
 //-----------------------------------------------------------------------------
+/*!
+SLCamera::intrinsics turns the camera into a calibrated pinhole camera whose 
+image fills the viewport. The mono perspective projection is then built from
+the focal lengths fx, fy and the principal point cx, cy in pixels of an image 
+with imgW x imgH pixels instead of the field of view. The image origin is top
+left with y down as in the camera calibration, the view matrix must still 
+transform into the GL eye space looking down -z with y up. The fov is updated
+for the ray casting. fx=0 switches back to the fov based projection.
+*/
+void SLCamera::intrinsics(const SLfloat fx, const SLfloat fy,
+                          const SLfloat cx, const SLfloat cy,
+                          const SLint imgW, const SLint imgH)
+{  
+   _fx = fx;
+   _fy = fy;
+   _cx = cx;
+   _cy = cy;
+   _imgW = imgW;
+   _imgH = imgH;
+   
+   if (fy > 0) 
+      _fov = 2.0f * atan(0.5f * (SLfloat)imgH / fy) * SL_RAD2DEG;
+}
+//-----------------------------------------------------------------------------
 //! SLCamera::animationStr()
 SLstring SLCamera::animationStr()
 {  
@@ -50,6 +50,7 @@ void SLGroup::addNode(SLNode* toAdd)
    }
    toAdd->parent(this);
    numNodes++;
+   _bvh.clear();
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -72,6 +73,7 @@ void SLGroup::insertNode(SLNode* toInsert, SLNode* after)
    toInsert->parent(this);
    after->next(toInsert);
    numNodes++;
+   _bvh.clear();
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -110,6 +112,7 @@ void SLGroup::deleteNode(SLNode* toDelete)
       toDelete->parent(0);
    }
    numNodes--;                          
+   _bvh.clear();
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -220,6 +223,8 @@ void SLGroup::updateStats(SLGroup* parent)
       current = current->next();
    }
    
+   numBytesAccel += _bvh.numBytes();
+   
    if (parent)
    {  ((SLGroup*)parent)->numBytes      += numBytes;
       ((SLGroup*)parent)->numBytesAccel += numBytesAccel;
@@ -254,11 +259,13 @@ SLNode* SLGroup::getNode(SLstring name)
 }
 //-----------------------------------------------------------------------------
 /*!
-SLGroup::intersect loops over all child nodes of the group and calls their
-intersect method.  
+SLGroup::intersect traverses the BVH over the child nodes or, for groups too
+small for a BVH, loops over all child nodes and calls their intersect method.
 */
 SLbool SLGroup::shapeHit(SLRay* ray)
 {  assert(ray != 0);
+   
+   if (_bvh.isBuilt()) return _bvh.hit(ray);
 
    SLNode* current = _first;
    SLbool wasHit = false;
@@ -292,6 +299,19 @@ SLAABBox& SLGroup::buildAABB()
    }
    
    _aabb.fromWStoOS(_aabb.minWS(), _aabb.maxWS(), _wmI);
+   
+   // the children AABBs are up to date now
+   _bvh.build(this);
+   return _aabb;
+}
+//-----------------------------------------------------------------------------
+/*!
+SLGroup::updateAABB updates the AABBs after an animation changed the world 
+matrices and refits the BVH to them. The tree structure is kept.
+*/
+SLAABBox& SLGroup::updateAABB()
+{  SLShape::updateAABB();
+   _bvh.refit();
    return _aabb;
 }
 //-----------------------------------------------------------------------------
@@ -19,11 +19,14 @@
 #include "SLSceneView.h"
 #include "SLCamera.h"
 #include "SLUniformGrid.h"
+#include "SLKDTree.h"
 #include "SLLightSphere.h"
 #include "SLLightRect.h"
 #include "SLGLShaderProg.h"
 #include "TriangleBoxIntersect.h"
 
+//-----------------------------------------------------------------------------
+SLAccelType SLMesh::defaultAccelType = accelUniformGrid;
 //-----------------------------------------------------------------------------
 /*! 
 The ctor sets the parent scene and initialises everything to 0.
@@ -42,7 +45,8 @@ SLMesh::SLMesh(SLstring name) : SLShape(name)
    
    _isVolume = true; // is used for RT to decide inside/outside
    
-   _accelStruct = new SLUniformGrid(this);
+   _accelStruct = 0;
+   accelType(defaultAccelType);
 }
 //-----------------------------------------------------------------------------
 //! The destructor deletes all VBO's and C-arrays
@@ -280,10 +284,28 @@ SLShape* SLMesh::shapeCopy()
    
    copy->M = new SLMatFaces[numM]; 
    memcpy(copy->M, M, numM*sizeof(SLMatFaces));
+   
+   copy->accelType(_accelType);
    return copy;
 }
 //-----------------------------------------------------------------------------
 /*!
+SLMesh::accelType replaces the acceleration structure by one of the given type.
+The new structure is built by the next buildAABB.
+*/
+void SLMesh::accelType(SLAccelType type)
+{  
+   delete _accelStruct;
+   _accelType = type;
+   
+   switch (type)
+   {  case accelUniformGrid: _accelStruct = new SLUniformGrid(this); break;
+      case accelKDTree:      _accelStruct = new SLKDTree(this); break;
+      default:               _accelStruct = 0;
+   }
+}
+//-----------------------------------------------------------------------------
+/*!
 SLMesh::intersect does the ray-mesh intersection test. If no acceleration 
 structure is defined all triangles are tested in a brute force manner.
 */
@@ -579,7 +601,7 @@ SLMesh::hitTriangle is the fast and minimum storage ray-triangle intersection
 test by Tomas Mller and Ben Trumbore (Journal of graphics tools 2, 1997)
 */
 SLbool SLMesh::hitTriangleOS(SLRay* ray, SLushort iT)
-{  ++SLRay::tests;
+{  ++ray->stats->tests;
 
    // prevent self-intersection of triangle
    if(ray->originTria == &F[iT]) return false;
@@ -625,7 +647,7 @@ SLbool SLMesh::hitTriangleOS(SLRay* ray, SLushort iT)
       // if intersection is closer replace ray intersection parameters
       if (t > ray->length || t < 0.0f) return false;
       
-      ++SLRay::intersections;
+      ++ray->stats->intersections;
       ray->length = t;
       
       // scale down u & v so that u+v<=1
@@ -658,7 +680,7 @@ SLbool SLMesh::hitTriangleOS(SLRay* ray, SLushort iT)
       // if intersection is closer replace ray intersection parameters
       if (t > ray->length || t < 0.0f) return false;
       
-      ++SLRay::intersections;      
+      ++ray->stats->intersections;      
       ray->length = t;
       
       ray->hitU = u;
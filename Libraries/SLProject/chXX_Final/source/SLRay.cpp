@@ -17,17 +17,7 @@
 // init static variables
 SLint   SLRay::maxDepth = 0;
 SLfloat SLRay::minContrib = 1.0 / 256.0;     
-SLuint  SLRay::reflectedRays = 0;
-SLuint  SLRay::refractedRays = 0;
-SLuint  SLRay::shadowRays = 0;
-SLuint  SLRay::subsampledRays = 0;
-SLuint  SLRay::subsampledPixels = 0;
-SLuint  SLRay::tirRays = 0;
-SLuint  SLRay::tests = 0;
-SLuint  SLRay::intersections = 0;
-SLint   SLRay::depthReached = 1;
-SLint   SLRay::maxDepthReached = 0;
-SLfloat SLRay::avgDepth = 0;
+SLRayStats SLRay::defaultStats;
 
 SLlong   SLRay::emittedPhotons = 0;      
 SLlong   SLRay::diffusePhotons = 0;      
@@ -63,6 +53,7 @@ SLRay::SLRay()
    y           = -1;
    contrib     = 1.0f;
    isOutside   = true;
+   stats       = &defaultStats;
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -87,6 +78,7 @@ SLRay::SLRay(SLVec3f Origin, SLVec3f Dir, SLint X, SLint Y)
    y           = (SLfloat)Y;
    contrib     = 1.0f;
    isOutside   = true;
+   stats       = &defaultStats;
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -113,7 +105,8 @@ SLRay::SLRay(SLfloat distToLight,
    y           = rayFromHitPoint->y;
    contrib     = 0.0f;
    isOutside   = rayFromHitPoint->isOutside;
-   shadowRays++;
+   stats       = rayFromHitPoint->stats;
+   ++stats->shadowRays;
 }
 //-----------------------------------------------------------------------------
 SLRay::SLRay(SLVec3f origin, 
@@ -134,9 +127,10 @@ SLRay::SLRay(SLVec3f origin,
    originShape = originShape;
    originMat = 0;
    x = y = -1;
+   stats = &defaultStats;
 
    if (type==SHADOW) 
-   {  ++shadowRays;
+   {  ++stats->shadowRays;
       lightDist = length;
    }
 }
@@ -182,8 +176,9 @@ void SLRay::reflect(SLRay* reflected)
    reflected->isOutside = isOutside;
    reflected->x = x;
    reflected->y = y;
-   depthReached = reflected->depth;
-   ++reflectedRays;
+   reflected->stats = stats;
+   countDepth(reflected->depth);
+   ++stats->reflectedRays;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -221,14 +216,14 @@ void SLRay::refract(SLRay* refracted)
       refracted->contrib = contrib * hitMat->kt();
       refracted->type = TRANSMITTED;
       refracted->isOutside = !isOutside;
-      ++refractedRays;
+      ++stats->refractedRays;
    } 
    else // total internal refraction results in a internal reflected ray
    {  T = 2.0f * (-dir*hitNormal) * hitNormal + dir;
       refracted->contrib = 1.0f;
       refracted->type = REFLECTED;
       refracted->isOutside = isOutside;
-      ++tirRays;
+      ++stats->tirRays;
    }
    
    refracted->setDir(T);
@@ -240,7 +235,8 @@ void SLRay::refract(SLRay* refracted)
    refracted->depth = depth + 1;
    refracted->x = x;
    refracted->y = y;
-   depthReached = refracted->depth;
+   refracted->stats = stats;
+   countDepth(refracted->depth);
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -332,7 +328,8 @@ void SLRay::diffuseMC(SLRay* scattered)
    scattered->setDir(hitNormal);
    scattered->origin = hitPoint;
    scattered->depth = depth+1;
-   depthReached = scattered->depth;
+   scattered->stats = stats;
+   countDepth(scattered->depth);
    
    // for reflectance the start material stays the same
    scattered->originMat = hitMat;
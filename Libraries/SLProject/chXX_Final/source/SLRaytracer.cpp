@@ -50,6 +50,10 @@ SLRaytracer::SLRaytracer()
    
    _numThreads = 1;
    _continuous = false;
+   _stop = false;
+   _preview = false;
+   _aaPixels = 0;
+   _cam = 0;
 }
 //-----------------------------------------------------------------------------
 SLRaytracer::~SLRaytracer()
@@ -58,21 +62,23 @@ SLRaytracer::~SLRaytracer()
 }
 //-----------------------------------------------------------------------------
 /*!
-This is the main rendering method for ray tracing. It loops over all 
-lines and pixels and determines for each pixel a color with a partly global 
-illumination calculation.
+This is the main rendering method for ray tracing. The image is split into 
+square tiles that are rendered in parallel (see renderTiles). Unless the ray 
+tracer runs continuously a low resolution preview is rendered first, so that 
+the whole image appears quickly and gets refined tile by tile. Each pixel gets 
+a color with a partly global illumination calculation.
 */
 SLbool SLRaytracer::render()
 {  
    SLScene* s = SLScene::current;      // scene shortcut
    SLSceneView* sv = s->activeSV();    // sceneview shortcut
-   SLCamera* cam = sv->_camera;        // camera shortcut
+   _cam = sv->_camera;                 // camera shortcut
    _state = rtBusy;                    // From here we state the RT as busy
    _stateGL = SLGLState::getInstance();// OpenGL state shortcut
    _numThreads = 1;                    // No. of threads
    _pcRendered = 0;                    // % rendered
    _renderSec = 0.0f;                  // reset time
-   SLint pc = (_aaSamples>1)?50:100;   // %-factor depending on AA
+   _stop = false;                      // no worker got cancelled yet
    _infoText  = SLScene::current->info()->text();  // keep original info string
    _infoColor = SLScene::current->info()->color(); // keep original info color
    
@@ -85,239 +91,287 @@ SLbool SLRaytracer::render()
    // calculate half window width & height in world coords   
    SLint   resX = sv->scrW();
    SLint   resY = sv->scrH();   
-   SLfloat hh = tan(SL_DEG2RAD*cam->fov()*0.5f) * cam->focalDist();
+   SLfloat hh = tan(SL_DEG2RAD*_cam->fov()*0.5f) * _cam->focalDist();
    SLfloat hw = hh * (SLfloat)resX / (SLfloat)resY;
    
    // calculate the size of a pixel in world coords. 
-   SLfloat pxSize = hw * 2 / sv->scrW();
+   _pxSize = hw * 2 / sv->scrW();
    
    // get camera vectors eye, lookAt, lookUp
-   SLVec3f EYE, LA, LU, LR;
-   cam->vm().lookAt(&EYE, &LA, &LU, &LR);
+   SLVec3f LA;
+   _cam->vm().lookAt(&_EYE, &LA, &_LU, &_LR);
    
    // calculate a vector to the center (C) of the bottom left (BL) pixel
-   SLVec3f C  = LA * cam->focalDist();
-   SLVec3f BL = C - hw*LR - hh*LU  +  pxSize/2*LR - pxSize/2*LU;
+   SLVec3f C  = LA * _cam->focalDist();
+   _BL = C - hw*_LR - hh*_LU  +  _pxSize/2*_LR - _pxSize/2*_LU;
+   
+   // lens sampling constants
+   _lensRadiusX = _LR*(_cam->lensDiameter()*0.5f);
+   _lensRadiusY = _LU*(_cam->lensDiameter()*0.5f);
 
    createImage(resX, resY);
+   createTiles(resX, resY);
    
-   #ifdef SL_OMP
-   SLbool doGUIUpdate = false;
-   #endif
+   // Anti-aliasing w. contrast compare is done in a separate pass
+   SLbool doAA = !_continuous && _aaSamples > 1 && 
+                 _cam->lensSamples()->samples() == 1;
+   SLint  pc = doAA ? 50 : 100;        // %-factor depending on AA
+   
+   _timer.start();
+   _lastGUIUpdate = 0.0f;
+   
+   ////////////////////////////////////////////////////////////////////////////
+   // Render a preview with one ray per SL_RTPREVIEW x SL_RTPREVIEW pixels 
+   // and then all remaining pixels
+   _preview = !_continuous;
+   if (_preview) 
+      renderTiles(rtPassPreview, 0, pc/SL_RTPREVIEW);
+   renderTiles(rtPassFull, _preview ? pc/SL_RTPREVIEW : 0, pc);
+   
+   ////////////////////////////////////////////////////////////////////////////
+   // Do anti-aliasing w. contrast compare in a 2nd. pass
+   if (!_stop && doAA)
+   {  markAAPixels();
+      renderTiles(rtPassAA, 50, 100);
+      delete[] _aaPixels;
+      _aaPixels = 0;
+   }
+   ////////////////////////////////////////////////////////////////////////////
+   
+   // wall clock time, clock() would sum up the time of all threads
+   _renderSec = (SLfloat)_timer.getElapsedTimeInSec();
+   _pcRendered = 100;
+   
+   if (_continuous && !_stop)
+      _state = rtReady;
+   else
+   {  _state = rtFinished;
+      printStats(_renderSec);
+   }
+   return true;
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the n-th point of the Morton (Z-order) curve. Consecutive points are 
+close to each other in both directions.
+*/
+static void mortonDecode(SLuint code, SLuint& x, SLuint& y)
+{  x = y = 0;
+   for (SLuint bit=0; bit<16; ++bit)
+   {  x |= ((code >> (2*bit  )) & 1) << bit;
+      y |= ((code >> (2*bit+1)) & 1) << bit;
+   }
+}
+//-----------------------------------------------------------------------------
+/*!
+Splits the image into tiles of SL_RTTILESIZE x SL_RTTILESIZE pixels in 
+Morton order. Neighbouring tiles are rendered at about the same time, so 
+they share the cached parts of the scene.
+*/
+void SLRaytracer::createTiles(SLint width, SLint height)
+{  
+   SLuint tilesX = (width  + SL_RTTILESIZE - 1) / SL_RTTILESIZE;
+   SLuint tilesY = (height + SL_RTTILESIZE - 1) / SL_RTTILESIZE;
+   
+   // the curve covers a power of two square, the tiles outside are skipped
+   SLuint side = 1;
+   while (side < tilesX || side < tilesY) side <<= 1;
+   
+   _tiles.clear();
+   _tiles.reserve(tilesX * tilesY);
+   for (SLuint code=0; code < side*side; ++code)
+   {  SLuint tx, ty;
+      mortonDecode(code, tx, ty);
+      if (tx < tilesX && ty < tilesY)
+         _tiles.push_back(SLRTTile(tx * SL_RTTILESIZE, ty * SL_RTTILESIZE));
+   }
+}
+//-----------------------------------------------------------------------------
+/*!
+Renders one pass over all tiles. The tiles are handed out one by one to the 
+threads that are free, so a thread that got cheap tiles takes over work of 
+the others. Only the main thread may update the GUI. If the GUI asks to stop, 
+the flag _stop makes every thread skip its remaining tiles.
+*/
+void SLRaytracer::renderTiles(SLRTPass pass, SLint pcStart, SLint pcEnd)
+{  
    #if defined(SL_OS_ANDROID) || defined(SL_OS_IOS)
-   const SLint GUIUPDATE = 8;
+   const SLfloat GUIUPDATESEC = 0.2f;
    #else
-   const SLint GUIUPDATE = 16;
+   const SLfloat GUIUPDATESEC = 0.1f;
    #endif
-
-   SLbool stop = false;
-
-   clock_t clockstart = clock();
    
-   ////////////////////////////////////////////////////////////////////////////
-   // single primary ray rendering
-   if (cam->lensSamples()->samples() == 1)
-   {  
-      // Do standard RT with one primary ray per pixel
+   SLint numTiles  = (SLint)_tiles.size();
+   SLint tilesDone = 0;
+   
+   #ifdef SL_OMP
+   #pragma omp parallel
+   #endif
+   {  SLRayStats stats; // counters of this thread
+      
       #ifdef SL_OMP
-      #pragma omp parallel for schedule(dynamic)
-      #endif      
-      for (SLint x=0; x<resX; ++x)
-      {  if (!stop)
-         {  for (SLint y=0; y<resY; ++y)
-            {  
-               // calculate ray from eye to pixel
-               SLVec3f primaryDir(BL + pxSize*((SLfloat)x*LR + (SLfloat)y*LU));
-               primaryDir.normalize();
-               SLRay primaryRay(EYE, primaryDir, x, y);
-            
-               ///////////////////////////////////
-               SLCol4f color = trace(&primaryRay);
-               ///////////////////////////////////
-            
-               _img[0].setPixeliRGB(x, y, color);
-            
-               SLRay::avgDepth += SLRay::depthReached;
-               SLRay::maxDepthReached = SL_max(SLRay::depthReached, SLRay::maxDepthReached);
-            }
-         
-            // Allow the GUI to process events & refresh RT window every 16th line
-            #ifdef SL_OMP
-            _numThreads = omp_get_num_threads();
-            #else
-            _numThreads = 1;
-            #endif
-         
-            if (!_continuous)
-            {  _pcRendered = (SLint)((SLfloat)x/(SLfloat)resX*pc);
-               #ifdef SL_OMP
-               if (!doGUIUpdate) doGUIUpdate = (x%GUIUPDATE==0);
-               if (doGUIUpdate && omp_get_thread_num()==0) 
-                  stop = guiRTWndUpdate();
-               #else
-               if (x%GUIUPDATE==0) 
-            	   stop = guiRTWndUpdate();
-               #endif
-            }
-         }
-      }
-   }
-   else // Do lens sampling with multiple primary rays per pixel -------------
-   {  
-      // lens sampling constants
-      SLVec3f lensRadiusX = LR*(cam->lensDiameter()*0.5f);
-      SLVec3f lensRadiusY = LU*(cam->lensDiameter()*0.5f);
-
-      // Loop over pixels and then over lense
+      _numThreads = omp_get_num_threads();
+      SLbool isMainThread = omp_get_thread_num()==0;
+      #else
+      SLbool isMainThread = true;
+      #endif
+      
       #ifdef SL_OMP
-      #pragma omp parallel for schedule(dynamic)
+      #pragma omp for schedule(dynamic, 1)
       #endif
-      for (SLint x=0; x<resX; ++x) 
-      {  if (!stop)
-         {  for (SLint y=0; y<resY; ++y)
-            {           
-               // focal point is single shot primary dir
-               SLVec3f primaryDir(BL + pxSize*((SLfloat)x*LR + (SLfloat)y*LU));
-               SLVec3f FP = EYE + primaryDir;
-               SLCol4f color(SLCol4f::BLACK);
-            
-               // Loop over radius r and angle phi of lens
-               for (SLint iR=cam->lensSamples()->samplesX()-1; iR>=0; --iR)
-               {  for (SLint iPhi=cam->lensSamples()->samplesY()-1; iPhi>=0; --iPhi)
-                  {   
-                     SLVec2f discPos(cam->lensSamples()->point(iR,iPhi));
-                  
-                     // calculate lensposition out of disc position
-                     SLVec3f lensPos(EYE + discPos.x*lensRadiusX + discPos.y*lensRadiusY);
-                     SLVec3f lensToFP(FP-lensPos);
-                     lensToFP.normalize();
-                     SLRay primaryRay(lensPos, lensToFP, x, y);
-                  
-                     ///////////////////////////
-                     color += trace(&primaryRay);
-                     ///////////////////////////
-                  
-                     SLRay::avgDepth += SLRay::depthReached;
-                     SLRay::maxDepthReached = SL_max(SLRay::depthReached, SLRay::maxDepthReached);   
-                  }
-               }
-               color /= (SLfloat)cam->lensSamples()->samples();
-               _img[0].setPixeliRGB(x, y, color);
-            }
+      for (SLint t=0; t<numTiles; ++t)
+      {  if (_stop) continue;
+      
+         renderTile(_tiles[t], pass, &stats);
          
-            #ifdef SL_OMP
-            _numThreads = omp_get_num_threads();
-            #else
-            _numThreads = 1;
-            #endif
+         #ifdef SL_OMP
+         #pragma omp atomic
+         #endif
+         ++tilesDone;
          
-            if (!_continuous)
-            {  _pcRendered = (SLint)((SLfloat)x/(SLfloat)resX*pc);
-               
-               // Allow the GUI to process events & refresh RT window every 32th line
-               #ifdef SL_OMP
-               if (!doGUIUpdate) doGUIUpdate = (x%GUIUPDATE==0);
-               if (doGUIUpdate && omp_get_thread_num()==0) 
-               {  stop = guiRTWndUpdate();
-                  doGUIUpdate = false;
-               }
-               #else
-               if (x%GUIUPDATE==0) 
-            	   stop = guiRTWndUpdate();
-               #endif
+         // Allow the GUI to process events & refresh RT window
+         if (!_continuous && isMainThread)
+         {  _pcRendered = pcStart + (pcEnd-pcStart)*tilesDone/numTiles;
+            SLfloat now = (SLfloat)_timer.getElapsedTimeInSec();
+            if (now - _lastGUIUpdate > GUIUPDATESEC)
+            {  _lastGUIUpdate = now;
+               if (guiRTWndUpdate()) _stop = true;
             }
          }
       }
+      
+      mergeStats(stats);
    }
+}
+//-----------------------------------------------------------------------------
+/*!
+Renders the pixels of one tile for the given pass:
+- rtPassPreview traces one ray per SL_RTPREVIEW x SL_RTPREVIEW block and 
+  fills the block with its color.
+- rtPassFull traces all pixels that were not traced by the preview.
+- rtPassAA subsamples the pixels marked by markAAPixels.
+*/
+void SLRaytracer::renderTile(const SLRTTile& tile, SLRTPass pass, SLRayStats* stats)
+{  
+   SLint x0 = tile.x;
+   SLint y0 = tile.y;
+   SLint x1 = SL_min(x0 + SL_RTTILESIZE, (SLint)_img[0].width());
+   SLint y1 = SL_min(y0 + SL_RTTILESIZE, (SLint)_img[0].height());
    
-   ////////////////////////////////////////////////////////////////////////////
-   // Do anti-aliasing w. contrast compare in a 2nd. pass
-   if (!stop && !_continuous && _aaSamples > 1 && 
-       cam->lensSamples()->samples() == 1)
-   {  SLCol4f  color, colorLeft, colorUp;    // pixel colors to be compared      
-      SLbool*  gotSampled = new SLbool[resX];// Flags if above pixel got sampled
-      SLbool   isSubsampled = false;         // Flag if pixel got subsampled
-      SLVPixel pix;                          // Dynamic vector for AA pixels
-            
-      // Nothing got sampled at beginning
-      for (SLint x=0; x<resX; ++x) gotSampled[x] = false;
-      
-      // Loop through all pixels & add the pixel that have to be subsampled
-      for (SLint y=0; y<resY; ++y)
-      {  for (SLint x=0; x<resX; ++x) 
-         {  
-            color = _img[0].getPixeli(x, y);        
-            isSubsampled = false;
-            if (x>0)
-            {  colorLeft = _img[0].getPixeli(x-1, y);
-               if (color.diffRGB(colorLeft) > _aaThreshold)
-               {  if (!gotSampled[x-1]) 
-                  {  pix.push_back(SLRTAAPixel(x-1,y));
-                     gotSampled[x-1] = true;
-                  }
-                  pix.push_back(SLRTAAPixel(x,y));
-                  isSubsampled = true;
-               }
+   switch (pass)
+   {  case rtPassPreview:
+         for (SLint y=y0; y<y1 && !_stop; y+=SL_RTPREVIEW)
+         {  for (SLint x=x0; x<x1; x+=SL_RTPREVIEW)
+            {  SLCol4f color = primaryColor(x, y, stats);
+               for (SLint by=y; by<SL_min(y+SL_RTPREVIEW, y1); ++by)
+                  for (SLint bx=x; bx<SL_min(x+SL_RTPREVIEW, x1); ++bx)
+                     _img[0].setPixeliRGB(bx, by, color);
             }
-            if (y>0)
-            {  colorUp = _img[0].getPixeli(x, y-1);
-               if(color.diffRGB(colorUp) > _aaThreshold)
-               {  if (!gotSampled[x]) pix.push_back(SLRTAAPixel(x,y-1));
-                  if (!isSubsampled) 
-                  {  pix.push_back(SLRTAAPixel(x,y));
-                     isSubsampled = true;
-                  }
-               }
+         }
+         break;
+         
+      case rtPassFull:
+         for (SLint y=y0; y<y1 && !_stop; ++y)
+         {  for (SLint x=x0; x<x1; ++x)
+            {  // the preview pixels are final already
+               if (_preview && x%SL_RTPREVIEW==0 && y%SL_RTPREVIEW==0) continue;
+               _img[0].setPixeliRGB(x, y, primaryColor(x, y, stats));
             }
-            gotSampled[x] = isSubsampled;
          }
-      } 
-      delete[] gotSampled;
-      
-      // Subsample all pixels in the vector pix
-      SLRay::subsampledPixels = pix.size();
-      SLint deltaPix = pix.size() / 20;
-      
-      #ifdef SL_OMP
-      #pragma omp parallel for schedule(dynamic)
-      #endif
-      for (SLint i=0; i<(SLint)pix.size(); ++i)
-      {  
-         if (!stop)
-         {  SLCol4f color = _img[0].getPixeli(pix[i].x, pix[i].y);
-            color = subSample(pix[i].x, pix[i].y, color, EYE, BL, LR, LU, pxSize);
-            _img[0].setPixeliRGB(pix[i].x, pix[i].y, color);
+         break;
          
-            // Allow the GUI to process events & refresh RT window ~20 times
-            if (!_continuous)
-            {  _pcRendered = 50+(SLint)((SLfloat)i/pix.size()*50);
-               
-               #ifdef SL_OMP
-               if (!doGUIUpdate) doGUIUpdate = (i%deltaPix==0);
-               if (doGUIUpdate && omp_get_thread_num()==0) 
-               {  stop = guiRTWndUpdate();
-                  doGUIUpdate = false;
-               }
-               #else
-               if (i%deltaPix==0) 
-                  stop = guiRTWndUpdate();
-               #endif
+      case rtPassAA:
+         for (SLint y=y0; y<y1 && !_stop; ++y)
+         {  for (SLint x=x0; x<x1; ++x)
+            {  if (!_aaPixels[y*_img[0].width() + x]) continue;
+               SLCol4f color = _img[0].getPixeli(x, y);
+               color = subSample(x, y, color, _EYE, _BL, _LR, _LU, _pxSize, stats);
+               _img[0].setPixeliRGB(x, y, color);
+               ++stats->subsampledPixels;
             }
          }
+         break;
+   }
+}
+//-----------------------------------------------------------------------------
+/*!
+Returns the color of the pixel at x, y. With lens sampling multiple primary 
+rays are shot through the lens towards the focal point of the pixel.
+*/
+SLCol4f SLRaytracer::primaryColor(SLint x, SLint y, SLRayStats* stats)
+{  
+   SLVec3f primaryDir(_BL + _pxSize*((SLfloat)x*_LR + (SLfloat)y*_LU));
+   
+   // single primary ray rendering
+   if (_cam->lensSamples()->samples() == 1)
+   {  primaryDir.normalize();
+      SLRay primaryRay(_EYE, primaryDir, x, y);
+      return tracePrimary(&primaryRay, stats);
+   }
+   
+   // focal point is single shot primary dir
+   SLVec3f FP = _EYE + primaryDir;
+   SLCol4f color(SLCol4f::BLACK);
+
+   // Loop over radius r and angle phi of lens
+   for (SLint iR=_cam->lensSamples()->samplesX()-1; iR>=0; --iR)
+   {  for (SLint iPhi=_cam->lensSamples()->samplesY()-1; iPhi>=0; --iPhi)
+      {   
+         SLVec2f discPos(_cam->lensSamples()->point(iR,iPhi));
+      
+         // calculate lensposition out of disc position
+         SLVec3f lensPos(_EYE + discPos.x*_lensRadiusX + discPos.y*_lensRadiusY);
+         SLVec3f lensToFP(FP-lensPos);
+         lensToFP.normalize();
+         SLRay primaryRay(lensPos, lensToFP, x, y);
+         color += tracePrimary(&primaryRay, stats);
       }
    }
-   ////////////////////////////////////////////////////////////////////////////
+   color /= (SLfloat)_cam->lensSamples()->samples();
+   return color;
+}
+//-----------------------------------------------------------------------------
+/*!
+Traces a primary ray and counts the depth reached by its secondary rays.
+*/
+SLCol4f SLRaytracer::tracePrimary(SLRay* primaryRay, SLRayStats* stats)
+{  
+   primaryRay->stats = stats;
+   stats->depthReached = 1;
    
-   _renderSec = (SLfloat)(clock()-clockstart)/(SLfloat)CLOCKS_PER_SEC;
-   _pcRendered = 100;
+   ///////////////////////////////////
+   SLCol4f color = trace(primaryRay);
+   ///////////////////////////////////
    
-   if (_continuous && !stop)
-      _state = rtReady;
-   else
-   {  _state = rtFinished;
-      printStats(_renderSec);
+   stats->avgDepth += stats->depthReached;
+   stats->maxDepthReached = SL_max(stats->depthReached, stats->maxDepthReached);
+   return color;
+}
+//-----------------------------------------------------------------------------
+/*!
+Marks the pixels that differ from one of their four neighbours by more than 
+the AA threshold. All pixels are compared before any gets subsampled, so the 
+lines can be compared in parallel.
+*/
+void SLRaytracer::markAAPixels()
+{  
+   SLint resX = _img[0].width();
+   SLint resY = _img[0].height();
+   _aaPixels = new SLbool[resX*resY];
+   
+   #ifdef SL_OMP
+   #pragma omp parallel for schedule(static)
+   #endif
+   for (SLint y=0; y<resY; ++y)
+   {  for (SLint x=0; x<resX; ++x)
+      {  SLCol4f color = _img[0].getPixeli(x, y);
+         _aaPixels[y*resX + x] = 
+            (x>0      && color.diffRGB(_img[0].getPixeli(x-1, y)) > _aaThreshold) ||
+            (x<resX-1 && color.diffRGB(_img[0].getPixeli(x+1, y)) > _aaThreshold) ||
+            (y>0      && color.diffRGB(_img[0].getPixeli(x, y-1)) > _aaThreshold) ||
+            (y<resY-1 && color.diffRGB(_img[0].getPixeli(x, y+1)) > _aaThreshold);
+      }
    }
-   return true;
 }
 //-----------------------------------------------------------------------------
 /*!
@@ -475,7 +529,8 @@ SLCol4f SLRaytracer::subSample(SLint x, SLint y,
                                SLCol4f centerColor,
                                SLVec3f EYE, SLVec3f TL, 
                                SLVec3f LR, SLVec3f LU, 
-                               SLfloat pxSize)
+                               SLfloat pxSize,
+                               SLRayStats* stats)
 {  
    assert(_aaSamples%2==1 && "subSample: maskSize must be uneven");
    SLint   centerIndex = _aaSamples>>1;
@@ -494,12 +549,13 @@ SLCol4f SLRaytracer::subSample(SLint x, SLint y,
          {  SLVec3f primaryDir(TL + pxSize*((xpos+i*f)*LR + (ypos+j*f)*LU));
             primaryDir.normalize();
             SLRay primaryRay(EYE, primaryDir, x, y);
+            primaryRay.stats = stats;
             color += trace(&primaryRay);
          }
       }
       ypos += f;
    }
-   SLRay::subsampledRays += (SLuint)samples;
+   stats->subsampledRays += (SLuint)samples;
    color /= samples;
    return color;
 }
@@ -526,20 +582,24 @@ SLCol4f SLRaytracer::fogBlend(SLfloat z, SLCol4f color)
 }
 //-----------------------------------------------------------------------------
 /*!
-Initialises the statistic variables in SLRay to zero
+Sets the allowed depth and initialises the merged statistics to zero
 */
 void SLRaytracer::initStats(SLint depth)
 {  
    SLRay::maxDepth = (depth) ? depth : SL_MAXTRACE;
-   SLRay::reflectedRays = 0;
-   SLRay::refractedRays = 0;
-   SLRay::shadowRays = 0;
-   SLRay::subsampledRays = 0;
-   SLRay::subsampledPixels = 0;
-   SLRay::tests = 0;
-   SLRay::intersections = 0;
-   SLRay::maxDepthReached = 0;
-   SLRay::avgDepth = 0.0f;
+   _stats.reset();
+}
+//-----------------------------------------------------------------------------
+/*!
+Adds the counters of one thread to the merged statistics. It is called once 
+by every thread at the end of a parallel loop.
+*/
+void SLRaytracer::mergeStats(const SLRayStats& stats)
+{  
+   #ifdef SL_OMP
+   #pragma omp critical
+   #endif
+   _stats.add(stats);
 }
 //-----------------------------------------------------------------------------
 /*! 
@@ -551,38 +611,38 @@ void SLRaytracer::printStats(SLfloat sec)
    SLSceneView* sv = s->activeSV();
    SLint  primarys = sv->scrW()*sv->scrH();
    SLuint total = primarys + 
-                  SLRay::reflectedRays + 
-                  SLRay::subsampledRays + 
-                  SLRay::refractedRays + 
-                  SLRay::shadowRays;
+                  _stats.reflectedRays + 
+                  _stats.subsampledRays + 
+                  _stats.refractedRays + 
+                  _stats.shadowRays;
    SL_LOG("\nRendering time    : %10.2f sec.", sec);
    SL_LOG("\nImage size        : %10d x %d",sv->scrW(), sv->scrH());
    SL_LOG("\nNum. Threads      : %10d", _numThreads);
    SL_LOG("\nAllowed depth     : %10d", SLRay::maxDepth);
-   SL_LOG("\nMaximum depth     : %10d", SLRay::maxDepthReached);
-   SL_LOG("\nAverage depth     : %10.6f", SLRay::avgDepth/primarys);
+   SL_LOG("\nMaximum depth     : %10d", _stats.maxDepthReached);
+   SL_LOG("\nAverage depth     : %10.6f", _stats.avgDepth/primarys);
    SL_LOG("\nAA threshold      : %10.1f", _aaThreshold);
    SL_LOG("\nAA subsampling    : %8dx%d\n", _aaSamples, _aaSamples);
-   SL_LOG("\nSubsampled pixels : %10u, %4.1f%% of total", SLRay::subsampledPixels,  
-          (SLfloat)SLRay::subsampledPixels/primarys*100.0f);   
+   SL_LOG("\nSubsampled pixels : %10u, %4.1f%% of total", _stats.subsampledPixels,  
+          (SLfloat)_stats.subsampledPixels/primarys*100.0f);   
    SL_LOG("\nPrimary rays      : %10u, %4.1f%% of total", primarys,               
           (SLfloat)primarys/total*100.0f);
-   SL_LOG("\nReflected rays    : %10u, %4.1f%% of total", SLRay::reflectedRays,   
-          (SLfloat)SLRay::reflectedRays/total*100.0f);
-   SL_LOG("\nTransmitted rays  : %10u, %4.1f%% of total", SLRay::refractedRays, 
-          (SLfloat)SLRay::refractedRays/total*100.0f);
-   SL_LOG("\nTIR rays          : %10u, %4.1f%% of total", SLRay::tirRays,         
-          (SLfloat)SLRay::tirRays/total*100.0f);
-   SL_LOG("\nShadow rays       : %10u, %4.1f%% of total", SLRay::shadowRays,      
-          (SLfloat)SLRay::shadowRays/total*100.0f);
-   SL_LOG("\nAA subsampled rays: %10u, %4.1f%% of total", SLRay::subsampledRays,  
-          (SLfloat)SLRay::subsampledRays/total*100.0f);
+   SL_LOG("\nReflected rays    : %10u, %4.1f%% of total", _stats.reflectedRays,   
+          (SLfloat)_stats.reflectedRays/total*100.0f);
+   SL_LOG("\nTransmitted rays  : %10u, %4.1f%% of total", _stats.refractedRays, 
+          (SLfloat)_stats.refractedRays/total*100.0f);
+   SL_LOG("\nTIR rays          : %10u, %4.1f%% of total", _stats.tirRays,         
+          (SLfloat)_stats.tirRays/total*100.0f);
+   SL_LOG("\nShadow rays       : %10u, %4.1f%% of total", _stats.shadowRays,      
+          (SLfloat)_stats.shadowRays/total*100.0f);
+   SL_LOG("\nAA subsampled rays: %10u, %4.1f%% of total", _stats.subsampledRays,  
+          (SLfloat)_stats.subsampledRays/total*100.0f);
    SL_LOG("\nTotal rays        : %10u,100.0%%\n", total);
    
    SL_LOG("\nRays per second   : %10u", (SLuint)(total / sec));
-   SL_LOG("\nIntersection tests: %10u", SLRay::tests);
-   SL_LOG("\nIntersections     : %10u, %4.1f%%", SLRay::intersections, 
-          SLRay::intersections/(SLfloat)SLRay::tests*100.0f);
+   SL_LOG("\nIntersection tests: %10u", _stats.tests);
+   SL_LOG("\nIntersections     : %10u, %4.1f%%", _stats.intersections, 
+          _stats.intersections/(SLfloat)_stats.tests*100.0f);
    SL_LOG("\n\n");
 }
 
@@ -691,4 +751,4 @@ void SLRaytracer::saveImage()
    sprintf(filename,"Raytrace_%d_%d.png", no++, _maxDepth);
    _img[0].savePNG(filename);
 }
-//-----------------------------------------------------------------------------
\ No newline at end of file
+//-----------------------------------------------------------------------------
\ No newline at end of file
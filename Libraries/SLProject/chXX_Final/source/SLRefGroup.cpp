@@ -108,18 +108,11 @@ void SLRefGroup::shapeDraw(SLSceneView* sv)
 }
 //-----------------------------------------------------------------------------
 /*!
-SLRefGroup::shapeHit calls the shapeHit method of the referenced group.
+SLRefGroup::shapeHit hits the child references through the BVH of the group.
 */
 SLbool SLRefGroup::shapeHit(SLRay* ray)
 {  
-   // loop through child references an hit each
-   SLNode* current = _first;
-   SLbool wasHit = false;
-   while (current)
-   {  if (((SLShape*)current)->hit(ray) && !wasHit) wasHit = true;
-      current = current->next();
-   }
-   return wasHit;
+   return SLGroup::shapeHit(ray);
 }
 //-----------------------------------------------------------------------------
 /*!
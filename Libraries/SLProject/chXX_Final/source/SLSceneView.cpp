@@ -1111,12 +1111,13 @@ void SLSceneView::build2DInfoRT()
    SLfloat     lh = (SLfloat)f->charsHeight;  // line height
 
    SLRaytracer* rt = &_raytracer;
+   const SLRayStats& rs = rt->stats();
    SLint  primaries = _scrW * _scrH;
    SLuint total = primaries + 
-                  SLRay::reflectedRays + 
-                  SLRay::subsampledRays + 
-                  SLRay::refractedRays + 
-                  SLRay::shadowRays;
+                  rs.reflectedRays + 
+                  rs.subsampledRays + 
+                  rs.refractedRays + 
+                  rs.shadowRays;
    
    // prepare some statistic infos
    SLfloat vox = (SLfloat)s->root3D()->numVoxels;
@@ -1139,33 +1140,33 @@ void SLSceneView::build2DInfoRT()
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
    sprintf(str, "Max. allowed RT depth: %d", SLRay::maxDepth);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Max. reached RT depth: %d", SLRay::maxDepthReached);
+   sprintf(str, "Max. reached RT depth: %d", rs.maxDepthReached);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Average RT depth: %4.2f", SLRay::avgDepth/primaries);
+   sprintf(str, "Average RT depth: %4.2f", rs.avgDepth/primaries);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
    sprintf(str, "AA threshhold: %2.1f", rt->aaThreshold());
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
    sprintf(str, "AA samples: %d x %d", rt->aaSamples(), rt->aaSamples());
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "AA pixels: %u, %3.1f%%", SLRay::subsampledPixels, (SLfloat)SLRay::subsampledPixels/primaries*100.0f);
+   sprintf(str, "AA pixels: %u, %3.1f%%", rs.subsampledPixels, (SLfloat)rs.subsampledPixels/primaries*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
    sprintf(str, "Primary rays: %u, %3.1f%%", primaries, (SLfloat)primaries/total*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Reflected rays: %u, %3.1f%%", SLRay::reflectedRays, (SLfloat)SLRay::reflectedRays/total*100.0f);
+   sprintf(str, "Reflected rays: %u, %3.1f%%", rs.reflectedRays, (SLfloat)rs.reflectedRays/total*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Refracted rays: %u, %3.1f%%", SLRay::refractedRays, (SLfloat)SLRay::refractedRays/total*100.0f);
+   sprintf(str, "Refracted rays: %u, %3.1f%%", rs.refractedRays, (SLfloat)rs.refractedRays/total*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "TIR rays: %u, %3.1f%%", SLRay::tirRays, (SLfloat)SLRay::tirRays/total*100.0f);
+   sprintf(str, "TIR rays: %u, %3.1f%%", rs.tirRays, (SLfloat)rs.tirRays/total*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Shadow rays: %u, %3.1f%%", SLRay::shadowRays, (SLfloat)SLRay::shadowRays/total*100.0f);
+   sprintf(str, "Shadow rays: %u, %3.1f%%", rs.shadowRays, (SLfloat)rs.shadowRays/total*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "AA rays: %u, %3.1f%%", SLRay::subsampledRays, (SLfloat)SLRay::subsampledRays/total*100.0f);
+   sprintf(str, "AA rays: %u, %3.1f%%", rs.subsampledRays, (SLfloat)rs.subsampledRays/total*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
    sprintf(str, "Total rays: %u, %3.1f%%", total, 100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Intersection tests: %u", SLRay::intersections);
+   sprintf(str, "Intersection tests: %u", rs.tests);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
-   sprintf(str, "Intersections: %u, %3.1f%%", SLRay::tests, SLRay::intersections/(SLfloat)SLRay::tests*100.0f);
+   sprintf(str, "Intersections: %u, %3.1f%%", rs.intersections, rs.intersections/(SLfloat)rs.tests*100.0f);
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);
    sprintf(str, "--------------------------------------------"); 
    t = new SLText(str, f); t->translate(10.0f, -lh*ln++, 0.0f); g->addNode(t);     
@@ -0,0 +1,219 @@
+//#############################################################################
+//  File:      SLShapeBVH.cpp
+//  Date:      May 2013
+//             This software is provide under the GNU General Public License
+//             Please visit: http://opensource.org/licenses/GPL-3.0
+//#############################################################################
+
+#include <stdafx.h>           // precompiled headers
+#ifdef SL_MEMLEAKDETECT
+#include <nvwa/debug_new.h>   // memory leak detector
+#endif
+
+#include "SLShapeBVH.h"
+#include "SLGroup.h"
+#include "SLRay.h"
+
+//-----------------------------------------------------------------------------
+//! Compares the AABB centers of two shapes along one axis
+struct SLShapeCenterLess
+{  SLShapeCenterLess(SLint axis) : axis(axis) {}
+   SLbool operator() (SLShape* a, SLShape* b) const
+   {  return a->aabb()->minWS().comp[axis] + a->aabb()->maxWS().comp[axis] <
+             b->aabb()->minWS().comp[axis] + b->aabb()->maxWS().comp[axis];
+   }
+   SLint axis;
+};
+//-----------------------------------------------------------------------------
+SLShapeBVH::SLShapeBVH()
+{  
+}
+//-----------------------------------------------------------------------------
+/*!
+SLShapeBVH::build builds the hierarchy over the direct children of the group.
+The AABBs of the children must be up to date. Groups with less than 
+SL_BVH_MINSHAPES children are faster traversed linearly and get no tree.
+*/
+void SLShapeBVH::build(SLGroup* group)
+{  
+   clear();
+   
+   // collect the children, empty AABBs can't be hit
+   SLNode* current = group->first();
+   while (current)
+   {  SLShape* shape = (SLShape*)current;
+      if (shape->aabb()->minWS() <= shape->aabb()->maxWS())
+         _shapes.push_back(shape);
+      current = current->next();
+   }
+   
+   if (_shapes.size() < SL_BVH_MINSHAPES)
+   {  clear();
+      return;
+   }
+   
+   // a binary tree with n leaves has 2n-1 nodes, so the array never grows
+   _nodes.reserve(2*_shapes.size());
+   _nodes.push_back(SLShapeBVHNode());
+   subdivide(0, 0, (SLint)_shapes.size());
+}
+//-----------------------------------------------------------------------------
+/*!
+SLShapeBVH::subdivide fits the node to the shapes from first to first+count 
+and splits them at the median of the axis with the largest extent.
+*/
+void SLShapeBVH::subdivide(SLint iNode, SLint first, SLint count)
+{  
+   _nodes[iNode].first = first;
+   _nodes[iNode].count = count;
+   fitNode(_nodes[iNode]);
+   
+   if (count <= SL_BVH_LEAFSIZE) return;
+   
+   // the extent of the shape centers decides the split axis
+   SLVec3f minC( SL_FLOAT_MAX, SL_FLOAT_MAX, SL_FLOAT_MAX);
+   SLVec3f maxC(-SL_FLOAT_MAX,-SL_FLOAT_MAX,-SL_FLOAT_MAX);
+   for (SLint i=first; i<first+count; ++i)
+   {  SLVec3f center = (_shapes[i]->aabb()->minWS() + _shapes[i]->aabb()->maxWS()) * 0.5f;
+      minC.setMin(center);
+      maxC.setMax(center);
+   }
+   
+   SLint axis;
+   SLVec3f extent = maxC - minC;
+   if (extent.maxXYZ(axis) <= 0.0f) return; // all at the same place
+   
+   SLint mid = first + count/2;
+   std::nth_element(_shapes.begin()+first, 
+                    _shapes.begin()+mid, 
+                    _shapes.begin()+first+count, 
+                    SLShapeCenterLess(axis));
+   
+   SLint left = (SLint)_nodes.size();
+   _nodes.push_back(SLShapeBVHNode());
+   _nodes.push_back(SLShapeBVHNode());
+   _nodes[iNode].first = left;
+   _nodes[iNode].count = 0;
+   
+   subdivide(left,   first, mid-first);
+   subdivide(left+1, mid,   first+count-mid);
+}
+//-----------------------------------------------------------------------------
+/*!
+SLShapeBVH::fitNode sets the bounds of a node to its shapes or children.
+*/
+void SLShapeBVH::fitNode(SLShapeBVHNode& node)
+{  
+   node.minWS.set( SL_FLOAT_MAX, SL_FLOAT_MAX, SL_FLOAT_MAX);
+   node.maxWS.set(-SL_FLOAT_MAX,-SL_FLOAT_MAX,-SL_FLOAT_MAX);
+   
+   if (node.count)
+   {  for (SLint i=node.first; i<node.first+node.count; ++i)
+      {  node.minWS.setMin(_shapes[i]->aabb()->minWS());
+         node.maxWS.setMax(_shapes[i]->aabb()->maxWS());
+      }
+   } else
+   {  for (SLint i=node.first; i<node.first+2; ++i)
+      {  node.minWS.setMin(_nodes[i].minWS);
+         node.maxWS.setMax(_nodes[i].maxWS);
+      }
+   }
+}
+//-----------------------------------------------------------------------------
+/*!
+SLShapeBVH::refit updates the bounds of all nodes after the AABBs of the 
+shapes changed. Children come after their parents, so a backward loop fits
+the children first.
+*/
+void SLShapeBVH::refit()
+{  
+   for (SLint i=(SLint)_nodes.size()-1; i>=0; --i)
+      fitNode(_nodes[i]);
+}
+//-----------------------------------------------------------------------------
+void SLShapeBVH::clear()
+{  
+   _nodes.clear();
+   _shapes.clear();
+}
+//-----------------------------------------------------------------------------
+/*!
+SLShapeBVH::isHitInWS is the same slab test as SLAABBox::isHitInWS. It returns
+the entry distance in tmin and leaves the ray untouched.
+*/
+SLbool SLShapeBVH::isHitInWS(SLShapeBVHNode& node, SLRay* ray, SLfloat& tmin)
+{  
+   SLVec3f  params[2] = {node.minWS, node.maxWS};
+   SLfloat  tmax, tymin, tymax, tzmin, tzmax;
+
+   tmin  = (params[  ray->sign[0]].x - ray->origin.x) * ray->invDir.x;
+   tmax  = (params[1-ray->sign[0]].x - ray->origin.x) * ray->invDir.x;
+   tymin = (params[  ray->sign[1]].y - ray->origin.y) * ray->invDir.y;
+   tymax = (params[1-ray->sign[1]].y - ray->origin.y) * ray->invDir.y;
+
+   if ((tmin > tymax) || (tymin > tmax)) return false;
+   if (tymin > tmin) tmin = tymin;
+   if (tymax < tmax) tmax = tymax;
+
+   tzmin = (params[  ray->sign[2]].z - ray->origin.z) * ray->invDir.z;
+   tzmax = (params[1-ray->sign[2]].z - ray->origin.z) * ray->invDir.z;
+
+   if ((tmin > tzmax) || (tzmin > tmax)) return false;
+   if (tzmin > tmin) tmin = tzmin;
+   if (tzmax < tmax) tmax = tzmax;
+   
+   return ((tmin < ray->length) && (tmax > 0));
+}
+//-----------------------------------------------------------------------------
+/*!
+SLShapeBVH::hit traverses the tree front to back: The nearer child is 
+visited first, so the ray length shrinks early and nodes behind the closest 
+hit get skipped. Shadow rays return as soon as any shape shades them.
+*/
+SLbool SLShapeBVH::hit(SLRay* ray)
+{  
+   SLint   stack[SL_BVH_MAXDEPTH];  // node indices to visit
+   SLfloat stackT[SL_BVH_MAXDEPTH]; // entry distances of the nodes
+   SLint   top = 0;
+   SLbool  wasHit = false;
+   SLfloat t0, t1;
+   
+   if (!isHitInWS(_nodes[0], ray, t0)) return false;
+   stack[top] = 0; stackT[top++] = t0;
+   
+   while (top)
+   {  SLShapeBVHNode& node = _nodes[stack[--top]];
+   
+      // a closer hit was found since the node got pushed
+      if (stackT[top] > ray->length) continue;
+      
+      if (node.count)
+      {  for (SLint i=node.first; i<node.first+node.count; ++i)
+         {  // do not test origin node for shadow rays 
+            if (_shapes[i]==ray->originShape && ray->type==SHADOW) continue;
+            if (_shapes[i]->hit(ray)) wasHit = true;
+            if (ray->isShaded()) return true;
+         }
+      } else
+      {  SLint   left  = node.first;
+         SLbool  hit0  = isHitInWS(_nodes[left],   ray, t0);
+         SLbool  hit1  = isHitInWS(_nodes[left+1], ray, t1);
+         
+         // push the farther child first so that the nearer one is popped next
+         if (hit0 && hit1)
+         {  if (t0 > t1)
+            {  stack[top] = left;   stackT[top++] = t0;
+               stack[top] = left+1; stackT[top++] = t1;
+            } else
+            {  stack[top] = left+1; stackT[top++] = t1;
+               stack[top] = left;   stackT[top++] = t0;
+            }
+         } else 
+         if (hit0) {stack[top] = left;   stackT[top++] = t0;}
+         else 
+         if (hit1) {stack[top] = left+1; stackT[top++] = t1;}
+      }
+   }
+   return wasHit;
+}
+//-----------------------------------------------------------------------------
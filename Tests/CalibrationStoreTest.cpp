@@ -0,0 +1,135 @@
+#include "Tests.h"
+#include "CalibrationStore.h"
+#include "CameraCalibration.h"
+#include <opencv2/opencv.hpp>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+static const cv::Size imageSize(640, 480);
+
+/**
+ * Adds synthetic views of a 9x6 chessboard seen by a camera with the given
+ * focal length, so that calibrate has something to solve.
+ */
+static void addViews(ARDoor::CameraCalibration& calibration, double focalLength)
+{
+    std::vector<cv::Point3f> objectCorners;
+    for (int y = 0; y < 6; y++) {
+        for (int x = 0; x < 9; x++) {
+            objectCorners.push_back(cv::Point3f((float) x, (float) y, 0.0f));
+        }
+    }
+
+    cv::Mat intrinsics = (cv::Mat_<double>(3, 3) <<
+        focalLength, 0, imageSize.width / 2.0,
+        0, focalLength, imageSize.height / 2.0,
+        0, 0, 1);
+    cv::Mat distortion = (cv::Mat_<double>(1, 5) << -0.1, 0.01, 0, 0, 0);
+
+    for (int view = 0; view < 8; view++) {
+        cv::Mat rotation = (cv::Mat_<double>(3, 1) << 0.3 * std::sin(view * 0.8), 0.3 * std::cos(view * 0.8), 0.05 * view);
+        cv::Mat translation = (cv::Mat_<double>(3, 1) << -4.0, -2.5, 12.0 + view);
+
+        std::vector<cv::Point2f> imageCorners;
+        cv::projectPoints(objectCorners, rotation, translation, intrinsics, distortion, imageCorners);
+        calibration.addPoints(imageCorners, objectCorners);
+    }
+}
+
+int testCalibrationStore()
+{
+    int failures = 0;
+    const std::string path = "ardoor-test-calibration.bin";
+    cv::Size size = imageSize;
+    cv::Mat image(imageSize, CV_8UC1, cv::Scalar(128));
+    cv::Mat undistorted;
+
+    {
+        ARDoor::CameraCalibration calibration;
+        addViews(calibration, 500.0);
+        calibration.calibrate(size);
+
+        ARDoor::CalibrationStore store(path);
+        store.put("camera", imageSize, calibration);
+        CHECK(store.save());
+    }
+
+    cv::Mat storedMap1, storedMap2;
+    ARDoor::CameraCalibration calibration;
+
+    {
+        ARDoor::CalibrationStore store(path);
+        CHECK(store.load());
+        CHECK(store.apply("camera", imageSize, calibration));
+
+        calibration.getUndistortMaps(imageSize, storedMap1, storedMap2);
+        storedMap1 = storedMap1.clone();
+        storedMap2 = storedMap2.clone();
+        calibration.remap(image, undistorted);
+
+        // recalibrating at the same resolution rebuilds maps of the same size and type
+        addViews(calibration, 600.0);
+        calibration.calibrate(size);
+        calibration.remap(image, undistorted);
+        CHECK(undistorted.size() == imageSize);
+
+        ARDoor::CameraCalibration reloaded;
+        CHECK(store.apply("camera", imageSize, reloaded));
+
+        cv::Mat map1, map2;
+        reloaded.getUndistortMaps(imageSize, map1, map2);
+        CHECK(cv::countNonZero(map1.reshape(1) != storedMap1.reshape(1)) == 0);
+        CHECK(cv::countNonZero(map2 != storedMap2) == 0);
+    }
+
+    // the maps have to stay valid after the store is gone
+    ARDoor::CameraCalibration applied;
+    {
+        ARDoor::CalibrationStore store(path);
+        CHECK(store.load());
+        CHECK(store.apply("camera", imageSize, applied));
+    }
+    applied.remap(image, undistorted);
+    CHECK(undistorted.size() == imageSize);
+
+    std::vector<char> bytes;
+    {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // a truncated file keeps its profile table but loses the maps, so the profile is rejected
+    {
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(&bytes[0], bytes.size() / 2);
+    }
+    {
+        ARDoor::CalibrationStore store(path);
+        ARDoor::CameraCalibration rejected;
+        store.load();
+        CHECK(!store.apply("camera", imageSize, rejected));
+    }
+
+    // distortionCount of the first profile: 16 byte header, then device, size, intrinsics and distortion
+    {
+        std::vector<char> corrupted = bytes;
+        int32_t distortionCount = 3;
+        memcpy(&corrupted[16 + 64 + 2 * 4 + 9 * 8 + 8 * 8], &distortionCount, sizeof(distortionCount));
+
+        std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(&corrupted[0], corrupted.size());
+    }
+    {
+        ARDoor::CalibrationStore store(path);
+        ARDoor::CameraCalibration rejected;
+        CHECK(store.load());
+        CHECK(!store.apply("camera", imageSize, rejected));
+    }
+
+    std::remove(path.c_str());
+    return failures;
+}
@@ -0,0 +1,21 @@
+#include "Tests.h"
+#include "ImageUtils.h"
+#include <opencv2/opencv.hpp>
+
+int testImageUtils()
+{
+    int failures = 0;
+
+    // one pixel with R = 10, G = 20, B = 30 and A = 255, as BGRA32 stores it on little endian machines
+    cv::Mat argb(2, 3, CV_8UC4, cv::Scalar(255, 10, 20, 30));
+    cv::Mat bgra;
+    ARDoor::ImageUtils::argbToBgra(argb, bgra);
+    CHECK(bgra.size() == argb.size() && bgra.type() == CV_8UC4);
+    CHECK(bgra.at<cv::Vec4b>(1, 2) == cv::Vec4b(30, 20, 10, 255));
+
+    cv::Mat rgb;
+    ARDoor::ImageUtils::bgraToRgb(bgra, rgb);
+    CHECK(rgb.at<cv::Vec3b>(1, 2) == cv::Vec3b(10, 20, 30));
+
+    return failures;
+}
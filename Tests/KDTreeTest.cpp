@@ -0,0 +1,195 @@
+#include "Tests.h"
+#include <stdafx.h>
+#include <SLMesh.h>
+#include <SLSphere.h>
+#include <SLRay.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+static float random01()
+{
+    return rand() / (float) RAND_MAX;
+}
+
+/**
+ * Random triangles, a third of them clustered in a small corner, so that the
+ * kd-tree gets both empty space and dense cells.
+ */
+class TriangleSoup : public SLMesh
+{
+public:
+    TriangleSoup(SLuint triangles) : SLMesh("TriangleSoup")
+    {
+        numV = (SLushort) (triangles * 3);
+        numF = triangles;
+        P = new SLVec3f[numV];
+        N = new SLVec3f[numV];
+        F = new SLFace[numF];
+
+        for (SLuint i = 0; i < triangles; i++) {
+            SLVec3f center(random01() * 10, random01() * 3, random01() * 10);
+            if (i % 3 == 0) {
+                center.set(random01(), random01(), random01());
+            }
+            for (SLuint k = 0; k < 3; k++) {
+                P[i * 3 + k] = center + SLVec3f(random01() - 0.5f, random01() - 0.5f, random01() - 0.5f) * 0.4f;
+            }
+            F[i].iA = (SLushort) (i * 3);
+            F[i].iB = (SLushort) (i * 3 + 1);
+            F[i].iC = (SLushort) (i * 3 + 2);
+        }
+
+        // hitTriangleOS looks at the material of the faces
+        numM = 1;
+        M = new SLMatFaces[1];
+        M[0].startF = 0;
+        M[0].numF = (SLushort) numF;
+        M[0].mat = 0;
+
+        calcNormals();
+        _isVolume = false;
+    }
+};
+
+struct TestRay
+{
+    SLVec3f origin;
+    SLVec3f dir;
+};
+
+struct TestHit
+{
+    SLbool hit;
+    SLfloat length;
+};
+
+static std::vector<TestHit> traceRays(SLMesh& mesh, SLAccelType type, const std::vector<TestRay>& rays)
+{
+    mesh.accelType(type);
+    mesh.buildAABB();
+
+    std::vector<TestHit> hits;
+    SLRayStats stats;
+
+    for (size_t i = 0; i < rays.size(); i++) {
+        SLRay ray;
+        ray.originOS = rays[i].origin;
+        ray.setDirOS(rays[i].dir);
+        ray.isOutside = true;
+        ray.stats = &stats;
+
+        TestHit hit;
+        hit.hit = mesh.shapeHit(&ray);
+        hit.length = ray.length;
+        hits.push_back(hit);
+    }
+
+    return hits;
+}
+
+/**
+ * Random rays from inside and around the box, every seventh parallel to the z axis
+ */
+static std::vector<TestRay> randomRays(SLVec3f min, SLVec3f max, int count)
+{
+    std::vector<TestRay> rays;
+
+    for (int i = 0; i < count; i++) {
+        TestRay ray;
+        ray.origin.set(min.x + random01() * (max.x - min.x),
+                       min.y + random01() * (max.y - min.y),
+                       min.z + random01() * (max.z - min.z));
+        ray.dir.set(random01() - 0.5f, random01() - 0.5f, random01() - 0.5f);
+        if (i % 7 == 0) {
+            ray.dir.set(0, 0, 1);
+        }
+        ray.dir.normalize();
+        rays.push_back(ray);
+    }
+
+    return rays;
+}
+
+/**
+ * Rays parallel to the candidate split planes of the root node, which start
+ * in the plane. The candidates are computed like in SLKDTree::findSplit3 with
+ * its 32 bins, so one of them is the split plane of the root.
+ */
+static std::vector<TestRay> inPlaneRays(SLMesh& mesh, int raysPerPlane)
+{
+    std::vector<TestRay> rays;
+    SLVec3f min, max;
+    mesh.calcMinMax(min, max);
+
+    // SLMesh::buildAABB enlarges the box for the acceleration structure
+    min -= 0.01f;
+    max += 0.01f;
+    SLVec3f size(max - min);
+
+    for (SLint axis = 0; axis < 3; axis++) {
+        SLfloat delta = size.comp[axis] / 32;
+
+        for (SLint bin = 1; bin < 32; bin++) {
+            for (int i = 0; i < raysPerPlane; i++) {
+                TestRay ray;
+                ray.origin.set(min.x + random01() * size.x,
+                               min.y + random01() * size.y,
+                               min.z + random01() * size.z);
+                ray.origin.comp[axis] = min.comp[axis] + bin * delta;
+                ray.dir.set(random01() - 0.5f, random01() - 0.5f, random01() - 0.5f);
+                ray.dir.comp[axis] = 0;
+                ray.dir.normalize();
+                rays.push_back(ray);
+            }
+        }
+    }
+
+    return rays;
+}
+
+/**
+ * Compares the hits of the kd-tree with testing all triangles
+ */
+static int compareWithBruteForce(SLMesh& mesh, const std::vector<TestRay>& rays)
+{
+    int failures = 0;
+
+    std::vector<TestHit> expected = traceRays(mesh, accelNone, rays);
+    std::vector<TestHit> hits = traceRays(mesh, accelKDTree, rays);
+    int mismatches = 0;
+
+    for (size_t i = 0; i < rays.size(); i++) {
+        if (hits[i].hit != expected[i].hit ||
+            (expected[i].hit && std::fabs(hits[i].length - expected[i].length) > 1e-4f)) {
+            mismatches++;
+        }
+    }
+
+    if (mismatches > 0) {
+        std::cerr << mesh.name() << ": " << mismatches << " of " << rays.size() << " rays differ" << std::endl;
+    }
+    CHECK(mismatches == 0);
+
+    return failures;
+}
+
+int testKDTree()
+{
+    int failures = 0;
+    srand(1);
+
+    TriangleSoup soup(5000);
+    failures += compareWithBruteForce(soup, randomRays(SLVec3f(-2, -2, -2), SLVec3f(12, 5, 12), 5000));
+    failures += compareWithBruteForce(soup, inPlaneRays(soup, 20));
+
+    SLSphere sphere(1.0f, 32, 32);
+    failures += compareWithBruteForce(sphere, randomRays(SLVec3f(-2, -2, -2), SLVec3f(2, 2, 2), 5000));
+    failures += compareWithBruteForce(sphere, inPlaneRays(sphere, 20));
+
+    // too few triangles for an acceleration structure
+    TriangleSoup small(5);
+    failures += compareWithBruteForce(small, randomRays(SLVec3f(-2, -2, -2), SLVec3f(12, 5, 12), 500));
+
+    return failures;
+}
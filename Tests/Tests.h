@@ -0,0 +1,33 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <iostream>
+
+/**
+ * Prints a failed check and counts it, the test functions return the number
+ * of failed checks.
+ */
+#define CHECK(condition) \
+    if (!(condition)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        failures++; \
+    }
+
+/**
+ * Stores a profile, loads it into a new store and recalibrates the camera
+ * at the same resolution afterwards.
+ */
+int testCalibrationStore();
+
+/**
+ * Checks the channel order of the pixel conversions with a known pixel.
+ */
+int testImageUtils();
+
+/**
+ * Compares the ray hits of SLMesh with the kd-tree with the hits found by
+ * testing all triangles, also for rays running in split planes.
+ */
+int testKDTree();
+
+#endif // TESTS_H
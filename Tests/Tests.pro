@@ -0,0 +1,54 @@
+#-------------------------------------------------
+#
+# Headless regression tests for ARDoorCommon,
+# exits with a non-zero status if a test fails
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = Tests
+TEMPLATE = app
+
+include(../_globals.pro)
+
+
+SOURCES += \
+    main.cpp \
+    CalibrationStoreTest.cpp \
+    ImageUtilsTest.cpp \
+    KDTreeTest.cpp
+
+HEADERS += \
+    Tests.h
+
+unix:!macx {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv
+}
+
+macx {
+    QMAKE_LFLAGS += -F/Library/Frameworks
+    LIBS += -framework opencv2
+}
+
+# ARDoorCommon Library
+INCLUDEPATH += ../Libraries/ARDoorCommon
+LIBS += -L$$BUILDPATH/ARDoorCommon -lARDoorCommon
+
+# SLProject headers, the code itself is part of ARDoorCommon
+SLPROJECT = ../Libraries/SLProject
+INCLUDEPATH += \
+    $$SLPROJECT/_external \
+    $$SLPROJECT/_external/glew/include \
+    $$SLPROJECT/_external/glfw/include \
+    $$SLPROJECT/_external/randomc \
+    $$SLPROJECT/_globals \
+    $$SLPROJECT/_globals/SL \
+    $$SLPROJECT/_globals/GL \
+    $$SLPROJECT/_globals/math \
+    $$SLPROJECT/_globals/SpacePartitioning \
+    $$SLPROJECT/chXX_Final/include
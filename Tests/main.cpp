@@ -0,0 +1,29 @@
+#include "Tests.h"
+#include <cstdlib>
+
+struct Test
+{
+    const char* name;
+    int (*run)();
+};
+
+int main()
+{
+    const Test tests[] = {
+        { "CalibrationStore", testCalibrationStore },
+        { "ImageUtils", testImageUtils },
+        { "KDTree", testKDTree }
+    };
+
+    int failed = 0;
+
+    for (const Test& test : tests) {
+        int failures = test.run();
+        std::cout << (failures == 0 ? "passed: " : "FAILED: ") << test.name << std::endl;
+        if (failures != 0) {
+            failed++;
+        }
+    }
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
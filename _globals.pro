@@ -1,6 +1,8 @@
 release: ENVIRONMENT = "release"
 debug:   ENVIRONMENT = "debug"
 
+CONFIG += c++11
+
 BUILDPATH = $$PWD/build/$$ENVIRONMENT
 DESTDIR = $$BUILDPATH/$$TARGET
 